@@ -0,0 +1,88 @@
+/* ext.h -- stub of the max sdk's ext.h for the xtbench harness
+
+Declares only what generated max externals use; implemented in
+xtbench_mx.cpp. Generated max externals are compiled as C++.
+*/
+
+#ifndef XTBENCH_EXT_H
+#define XTBENCH_EXT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef intptr_t t_ptr_int;
+typedef long t_atom_long;
+typedef double t_atom_float;
+typedef long t_max_err;
+typedef float t_float;
+typedef double t_double;
+typedef double t_sample;
+typedef void *(*method)(void *, ...);
+typedef void *t_critical;
+typedef void t_outlet;
+
+typedef struct symbol {
+    const char *s_name;
+    struct object *s_thing;
+} t_symbol;
+
+typedef struct object {
+    void *o_magic;
+    void *o_inlet;
+    void *o_outlet;
+} t_object;
+
+union word {
+    t_atom_long w_long;
+    t_atom_float w_float;
+    t_symbol *w_sym;
+    t_object *w_obj;
+};
+
+typedef struct atom {
+    short a_type;
+    union word a_w;
+} t_atom;
+
+typedef struct maxclass t_class;
+
+enum e_max_atomtypes {
+    A_NOTHING = 0, A_LONG, A_FLOAT, A_SYM, A_OBJ, A_DEFLONG, A_DEFFLOAT,
+    A_DEFSYM, A_GIMME, A_CANT, A_SEMI, A_COMMA, A_DOLLAR, A_DOLLSYM,
+    A_GIMMEBACK, A_DEFER, A_USURP, A_DEFER_LOW, A_USURP_LOW
+};
+
+enum { ASSIST_INLET = 1, ASSIST_OUTLET = 2 };
+
+#define calcoffset(x, y) ((t_ptr_int)(&(((x *)0L)->y)))
+
+t_symbol *gensym(const char *s);
+void post(const char *fmt, ...);
+void object_error(t_object *x, const char *fmt, ...);
+t_class *class_new(const char *name, const method mnew, const method mfree,
+    long size, const method mmenu, short type, ...);
+t_max_err class_addmethod(t_class *c, const method m, const char *name, ...);
+void *outlet_new(void *x, const char *s);
+void *outlet_float(void *o, double f);
+void *outlet_bang(void *o);
+void *outlet_list(void *o, t_symbol *s, short ac, t_atom *av);
+long proxy_getinlet(t_object *master);
+void *sysmem_newptr(long size);
+void *sysmem_newptrclear(long size);
+void *sysmem_resizeptr(void *ptr, long newsize);
+void *sysmem_resizeptrclear(void *ptr, long newsize);
+void sysmem_freeptr(void *ptr);
+void critical_enter(t_critical x);
+void critical_exit(t_critical x);
+double gettime_forobject(t_object *x);
+void *clock_new(void *obj, method fn);
+void clock_fdelay(void *obj, double time);
+t_atom_float atom_getfloat(const t_atom *a);
+t_atom_long atom_getlong(const t_atom *a);
+t_symbol *atom_getsym(const t_atom *a);
+t_max_err atom_setfloat(t_atom *a, double b);
+
+extern "C" void ext_main(void *r);
+
+#endif /* XTBENCH_EXT_H */
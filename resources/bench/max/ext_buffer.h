@@ -0,0 +1,24 @@
+/* ext_buffer.h -- stub of the max sdk's ext_buffer.h for the xtbench harness
+
+Declares only what generated max externals with table params use;
+implemented in xtbench_mx.cpp.
+*/
+
+#ifndef XTBENCH_EXT_BUFFER_H
+#define XTBENCH_EXT_BUFFER_H
+
+#include "ext.h"
+
+typedef struct _buffer_ref t_buffer_ref;
+typedef struct _buffer_obj t_buffer_obj;
+
+t_buffer_ref *buffer_ref_new(t_object *self, t_symbol *name);
+void buffer_ref_set(t_buffer_ref *x, t_symbol *name);
+t_buffer_obj *buffer_ref_getobject(t_buffer_ref *x);
+t_max_err buffer_ref_notify(t_buffer_ref *x, t_symbol *s, t_symbol *msg, void *sender, void *data);
+float *buffer_locksamples(t_buffer_obj *b);
+void buffer_unlocksamples(t_buffer_obj *b);
+t_atom_long buffer_getframecount(t_buffer_obj *b);
+t_atom_long buffer_getchannelcount(t_buffer_obj *b);
+
+#endif /* XTBENCH_EXT_BUFFER_H */
@@ -0,0 +1,31 @@
+/* ext_obex.h -- stub of the max sdk's ext_obex.h for the xtbench harness
+
+Declares only what generated max externals use; implemented in
+xtbench_mx.cpp. Attributes are registered but not exercised.
+*/
+
+#ifndef XTBENCH_EXT_OBEX_H
+#define XTBENCH_EXT_OBEX_H
+
+#include "ext.h"
+
+#define MAX_ERR_NONE 0
+#define CLASS_BOX gensym("box")
+
+void *object_alloc(t_class *c);
+void *object_method(void *x, t_symbol *s, ...);
+t_max_err object_free(void *x);
+t_max_err class_register(t_symbol *name_space, t_class *c);
+void attr_args_process(void *x, short ac, t_atom *av);
+void xtb_class_addattr(t_class *c, const char *name, t_ptr_int offset);
+
+#define CLASS_ATTR_DOUBLE(c, attrname, flags, structname, structmember) \
+    xtb_class_addattr(c, attrname, calcoffset(structname, structmember))
+#define CLASS_ATTR_FLOAT(c, attrname, flags, structname, structmember) \
+    xtb_class_addattr(c, attrname, calcoffset(structname, structmember))
+#define CLASS_ATTR_LONG(c, attrname, flags, structname, structmember) \
+    xtb_class_addattr(c, attrname, calcoffset(structname, structmember))
+#define CLASS_ATTR_ACCESSORS(c, attrname, getter, setter) ((void)(getter), (void)(setter))
+#define CLASS_ATTR_FILTER_CLIP(c, attrname, minval, maxval) ((void)0)
+
+#endif /* XTBENCH_EXT_OBEX_H */
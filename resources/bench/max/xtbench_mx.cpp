@@ -0,0 +1,438 @@
+/* xtbench_mx.cpp -- benchmark harness for a generated max dsp external
+
+Implements the part of the max sdk's API (see ext.h, ext_obex.h and z_dsp.h)
+which a generated dsp external calls from its ext_main, constructor and dsp64
+methods, so that the external runs without max. Instances are created
+through the class' constructor, their dsp64 method is called with all audio
+inlets connected and param inlets unconnected (the scalar path, see count[]),
+and the perform routines registered with dsp_add64 are run once per block,
+like in max's audio thread (see xtbench.h for the options and output).
+Multichannel (Z_MC_INLETS) objects get -c channels on their first inlet.
+*/
+
+#include <stdarg.h>
+
+#include "ext.h"
+#include "ext_obex.h"
+#include "z_dsp.h"
+#include "ext_buffer.h"
+
+#include "xtbench.h"
+
+typedef void (*t_dsp64method)(void *x, t_object *dsp64, short *count,
+    double samplerate, long maxvectorsize, long flags);
+typedef long (*t_inputchangedmethod)(void *x, long index, long count);
+typedef long (*t_mcoutputsmethod)(void *x, long index);
+typedef void (*t_perfroutine64)(void *x, t_object *dsp64, double **ins,
+    long numins, double **outs, long numouts, long sampleframes, long flags,
+    void *userparam);
+
+
+/*
+ * stubs of the max api
+ * ---------------------------------------------------------------------------
+ */
+
+struct maxclass {
+    const char *c_name;
+    method c_new;
+    method c_free;
+    long c_size;
+    method c_dsp64;
+    method c_inputchanged;      // multichannel objects only
+    method c_mcoutputs;
+};
+
+static t_class *bench_class;    // the class created by ext_main
+static int bench_nsigout;       // signal outlets of the last created object
+static int bench_nmcout;        // multichannel signal outlets of the last created object
+static double bench_sr = 48000;
+
+// one perform routine per instance, registered by dsp_add64
+struct bench_perform {
+    void *x;
+    t_perfroutine64 fn;
+};
+
+static bench_perform *bench_chain;
+static int bench_chainsize;
+
+t_symbol *gensym(const char *s)
+{
+    static struct bench_sym { t_symbol sym; bench_sym *next; } *symlist = 0;
+    for (bench_sym *b = symlist; b; b = b->next)
+        if (!strcmp(b->sym.s_name, s))
+            return &b->sym;
+    bench_sym *b = (bench_sym *)calloc(1, sizeof(bench_sym));
+    b->sym.s_name = strdup(s);
+    b->next = symlist;
+    symlist = b;
+    return &b->sym;
+}
+
+void post(const char *fmt, ...) {}
+
+void object_error(t_object *x, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+}
+
+t_class *class_new(const char *name, const method mnew, const method mfree,
+    long size, const method mmenu, short type, ...)
+{
+    t_class *c = (t_class *)calloc(1, sizeof(t_class));
+    c->c_name = name;
+    c->c_new = mnew;
+    c->c_free = mfree;
+    c->c_size = size;
+    bench_class = c;
+    return c;
+}
+
+t_max_err class_addmethod(t_class *c, const method m, const char *name, ...)
+{
+    if (!strcmp(name, "dsp64"))
+        c->c_dsp64 = m;
+    else if (!strcmp(name, "inputchanged"))
+        c->c_inputchanged = m;
+    else if (!strcmp(name, "multichanneloutputs"))
+        c->c_mcoutputs = m;
+    return MAX_ERR_NONE;
+}
+
+t_max_err class_register(t_symbol *name_space, t_class *c)
+{
+    return MAX_ERR_NONE;
+}
+
+void class_dspinit(t_class *c) {}
+void xtb_class_addattr(t_class *c, const char *name, t_ptr_int offset) {}
+void attr_args_process(void *x, short ac, t_atom *av) {}
+
+void *object_alloc(t_class *c)
+{
+    bench_nsigout = bench_nmcout = 0;
+    return calloc(1, c->c_size);
+}
+
+// only dsp_add64 is sent to the dsp64 object
+void *object_method(void *x, t_symbol *s, ...)
+{
+    va_list ap;
+    if (strcmp(s->s_name, "dsp_add64"))
+        return 0;
+    va_start(ap, s);
+    bench_chain[bench_chainsize].x = va_arg(ap, void *);
+    bench_chain[bench_chainsize].fn = va_arg(ap, t_perfroutine64);
+    bench_chainsize++;
+    va_end(ap);
+    return 0;
+}
+
+// the only objects freed by generated externals are buffer~ references and clocks
+t_max_err object_free(void *x)
+{
+    sysmem_freeptr(x);
+    return MAX_ERR_NONE;
+}
+
+void *outlet_new(void *x, const char *s)
+{
+    if (s && !strcmp(s, "signal"))
+        bench_nsigout++;
+    else if (s && !strcmp(s, "multichannelsignal"))
+        bench_nmcout++;
+    return x;
+}
+
+void *outlet_float(void *o, double f) { return 0; }
+void *outlet_bang(void *o) { return 0; }
+void *outlet_list(void *o, t_symbol *s, short ac, t_atom *av) { return 0; }
+
+long proxy_getinlet(t_object *master)
+{
+    return 0;
+}
+
+void *sysmem_newptr(long size)
+{
+    return malloc(size ? size : 1);
+}
+
+void *sysmem_newptrclear(long size)
+{
+    return calloc(1, size ? size : 1);
+}
+
+void *sysmem_resizeptr(void *ptr, long newsize)
+{
+    return realloc(ptr, newsize ? newsize : 1);
+}
+
+void *sysmem_resizeptrclear(void *ptr, long newsize)
+{
+    return sysmem_resizeptr(ptr, newsize);
+}
+
+void sysmem_freeptr(void *ptr)
+{
+    free(ptr);
+}
+
+void critical_enter(t_critical x) {}
+void critical_exit(t_critical x) {}
+
+// the benchmark runs outside of a scheduler: scheduler time stands still
+double gettime_forobject(t_object *x)
+{
+    return 0;
+}
+
+// clocks never fire: reports of the perform routines wait in their ring
+void *clock_new(void *obj, method fn)
+{
+    return sysmem_newptrclear(sizeof(void *));
+}
+
+void clock_fdelay(void *obj, double time) {}
+
+t_atom_float atom_getfloat(const t_atom *a)
+{
+    return a->a_type == A_LONG ? (t_atom_float)a->a_w.w_long : a->a_w.w_float;
+}
+
+t_atom_long atom_getlong(const t_atom *a)
+{
+    return a->a_type == A_FLOAT ? (t_atom_long)a->a_w.w_float : a->a_w.w_long;
+}
+
+t_symbol *atom_getsym(const t_atom *a)
+{
+    return a->a_type == A_SYM ? a->a_w.w_sym : gensym("");
+}
+
+t_max_err atom_setfloat(t_atom *a, double b)
+{
+    a->a_type = A_FLOAT;
+    a->a_w.w_float = b;
+    return MAX_ERR_NONE;
+}
+
+// every buffer~ name resolves to the same buffer~ of silence, so table params read real memory
+#define BENCH_BUFFER 65536
+
+struct _buffer_ref {
+    t_symbol *name;
+};
+
+struct _buffer_obj {
+    float samples[BENCH_BUFFER];
+};
+
+static t_buffer_obj bench_buffer;
+
+t_buffer_ref *buffer_ref_new(t_object *self, t_symbol *name)
+{
+    t_buffer_ref *x = (t_buffer_ref *)sysmem_newptrclear(sizeof(t_buffer_ref));
+    x->name = name;
+    return x;
+}
+
+void buffer_ref_set(t_buffer_ref *x, t_symbol *name)
+{
+    x->name = name;
+}
+
+t_buffer_obj *buffer_ref_getobject(t_buffer_ref *x)
+{
+    return *x->name->s_name ? &bench_buffer : NULL;
+}
+
+t_max_err buffer_ref_notify(t_buffer_ref *x, t_symbol *s, t_symbol *msg, void *sender, void *data)
+{
+    return MAX_ERR_NONE;
+}
+
+float *buffer_locksamples(t_buffer_obj *b)
+{
+    return b->samples;
+}
+
+void buffer_unlocksamples(t_buffer_obj *b) {}
+
+t_atom_long buffer_getframecount(t_buffer_obj *b)
+{
+    return BENCH_BUFFER;
+}
+
+t_atom_long buffer_getchannelcount(t_buffer_obj *b)
+{
+    return 1;
+}
+
+void dsp_setup(t_pxobject *x, long nsignals)
+{
+    x->z_in = nsignals;
+}
+
+void dsp_free(t_pxobject *x) {}
+
+double sys_getsr(void)
+{
+    return bench_sr;
+}
+
+short sys_getdspobjdspstate(t_object *o)
+{
+    return 1;
+}
+
+int sys_getmaxblksize(void)
+{
+    return 64;
+}
+
+
+/*
+ * benchmark driver
+ * ---------------------------------------------------------------------------
+ */
+
+struct bench_ctx {
+    double ***ins;      // per instance input vectors
+    double ***outs;     // per instance output vectors
+    long nin;
+    long nout;
+    long n;
+};
+
+// run one block of every instance, like max's audio thread does
+static void bench_tick(void *ctx)
+{
+    bench_ctx *b = (bench_ctx *)ctx;
+    for (int i = 0; i < bench_chainsize; i++)
+        bench_chain[i].fn(bench_chain[i].x, 0, b->ins[i], b->nin, b->outs[i],
+            b->nout, b->n, 0, 0);
+}
+
+/**
+ * create an instance and set up its signals for `chans` channels
+ *
+ * on return *nin and *nout are the signal vectors passed to the perform
+ * routine and count[] (one entry per inlet and outlet) is filled in.
+ */
+static void *bench_new(int chans, int *nin, int *nout, short *count, int *mc)
+{
+    typedef void *(*t_newgimme)(t_symbol *s, long argc, t_atom *argv);
+    void *x = ((t_newgimme)bench_class->c_new)(gensym(bench_class->c_name), 0, 0);
+    t_pxobject *ob = (t_pxobject *)x;
+    int s, ninlets = (int)ob->z_in, noutlets = bench_nsigout + bench_nmcout;
+
+    *mc = (ob->z_misc & Z_MC_INLETS) && bench_class->c_inputchanged && bench_class->c_mcoutputs;
+    if (*mc) {
+        // the channels go to the first inlet, param inlets get one each
+        ((t_inputchangedmethod)bench_class->c_inputchanged)(x, 0, chans);
+        *nin = chans + ninlets - 1;
+        *nout = bench_nsigout;
+        for (s = 0; s < bench_nmcout; s++)
+            *nout += (int)((t_mcoutputsmethod)bench_class->c_mcoutputs)(x, s);
+        count[0] = 1;
+        for (s = 1; s < ninlets; s++)
+            count[s] = 0;
+    } else {
+        // generated externals have as many audio inlets as outlets,
+        // followed by the param inlets: leave those open
+        *nin = ninlets;
+        *nout = noutlets;
+        for (s = 0; s < ninlets; s++)
+            count[s] = (s < noutlets);
+    }
+    for (s = 0; s < noutlets; s++)
+        count[ninlets + s] = 1;
+    return x;
+}
+
+int main(int argc, char **argv)
+{
+    t_xtb_options o;
+    int first = 1, mc = 0;
+
+    xtb_parse(argc, argv, &o);
+    bench_sr = o.samplerate;
+    ext_main(0);
+    if (!bench_class || !bench_class->c_dsp64) {
+        fprintf(stderr, "xtbench: no dsp class was set up\n");
+        return 1;
+    }
+
+    for (int bi = 0; bi < o.n_blocksizes; bi++) {
+        for (int ci = 0; ci < o.n_channels; ci++) {
+            for (int ii = 0; ii < o.n_instances; ii++) {
+                int n = o.blocksizes[bi], k = o.instances[ii];
+                int nin = 0, nout = 0, inplace = 0;
+                void **objs = (void **)calloc(k, sizeof(void *));
+                short count[256];
+                double *vecs = 0;
+                double seed = 1;
+                bench_ctx b;
+                t_xtb_result r;
+
+                bench_chain = (bench_perform *)calloc(k, sizeof(bench_perform));
+                bench_chainsize = 0;
+                b.ins = (double ***)calloc(k, sizeof(double **));
+                b.outs = (double ***)calloc(k, sizeof(double **));
+                for (int i = 0; i < k; i++) {
+                    objs[i] = bench_new(o.channels[ci], &nin, &nout, count, &mc);
+                    if (!i) {
+                        // max honours Z_NO_INPLACE by giving the object its own outputs
+                        inplace = o.inplace && !(((t_pxobject *)objs[i])->z_misc & Z_NO_INPLACE);
+                        vecs = (double *)calloc((size_t)k * (nin + nout) * n, sizeof(double));
+                    }
+                    b.ins[i] = (double **)calloc(nin + nout, sizeof(double *));
+                    b.outs[i] = b.ins[i] + nin;
+                    for (int s = 0; s < nin + nout; s++) {
+                        // in place: outlet j shares the vector of inlet j
+                        int v = (inplace && s >= nin && s - nin < nin) ? s - nin : s;
+                        b.ins[i][s] = vecs + ((size_t)i * (nin + nout) + v) * n;
+                    }
+                    for (int s = 0; s < nin; s++)
+                        xtb_noise(&seed, 0, b.ins[i][s], n);
+                    ((t_dsp64method)bench_class->c_dsp64)(objs[i], 0, count, bench_sr, n, 0);
+                }
+                b.nin = nin;
+                b.nout = nout;
+                b.n = n;
+
+                r.external = bench_class->c_name;
+                r.blocksize = n;
+                r.inputs = nin;
+                r.outputs = nout;
+                r.channels = mc ? o.channels[ci] : nout;
+                r.instances = k;
+                r.inplace = inplace;
+                xtb_run(bench_tick, &b, &o, &r);
+                xtb_report(&o, &r, first);
+                first = 0;
+
+                for (int i = 0; i < k; i++) {
+                    if (bench_class->c_free)
+                        ((void (*)(void *))bench_class->c_free)(objs[i]);
+                    free(objs[i]);
+                    free(b.ins[i]);
+                }
+                free(objs);
+                free(b.ins);
+                free(b.outs);
+                free(bench_chain);
+                free(vecs);
+            }
+            if (!mc)
+                break;  // the channel count is fixed by the spec
+        }
+    }
+    return 0;
+}
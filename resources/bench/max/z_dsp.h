@@ -0,0 +1,31 @@
+/* z_dsp.h -- stub of the max sdk's z_dsp.h for the xtbench harness
+
+Declares only what generated max dsp externals use; implemented in
+xtbench_mx.cpp.
+*/
+
+#ifndef XTBENCH_Z_DSP_H
+#define XTBENCH_Z_DSP_H
+
+#include "ext.h"
+
+#define Z_NO_INPLACE 1
+#define Z_MC_INLETS 32
+
+typedef struct t_pxobject {
+    t_object z_ob;
+    long z_in;
+    void *z_proxy;
+    long z_disabled;
+    short z_count;
+    short z_misc;
+} t_pxobject;
+
+void dsp_setup(t_pxobject *x, long nsignals);
+void dsp_free(t_pxobject *x);
+void class_dspinit(t_class *c);
+double sys_getsr(void);
+int sys_getmaxblksize(void);
+short sys_getdspobjdspstate(t_object *o);
+
+#endif /* XTBENCH_Z_DSP_H */
@@ -0,0 +1,26 @@
+/* g_canvas.h -- stub of pd's g_canvas.h for the xtbench harness
+
+Declares only what generated dsp externals use; implemented in xtbench.c,
+where a patch has no connections (so param inlets take the scalar path).
+*/
+
+#ifndef XTBENCH_G_CANVAS_H
+#define XTBENCH_G_CANVAS_H
+
+typedef struct _linetraverser
+{
+    t_canvas *tr_x;
+    t_object *tr_ob;
+    int tr_nout;
+    int tr_outno;
+    t_object *tr_ob2;
+    t_outlet *tr_outlet;
+    t_inlet *tr_inlet;
+    int tr_nin;
+    int tr_inno;
+} t_linetraverser;
+
+EXTERN void linetraverser_start(t_linetraverser *t, t_canvas *x);
+EXTERN t_outconnect *linetraverser_next(t_linetraverser *t);
+
+#endif /* XTBENCH_G_CANVAS_H */
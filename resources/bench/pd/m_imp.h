@@ -0,0 +1,12 @@
+/* m_imp.h -- stub of pd's m_imp.h for the xtbench harness
+
+Declares only what generated dsp externals use; implemented in xtbench.c.
+*/
+
+#ifndef XTBENCH_M_IMP_H
+#define XTBENCH_M_IMP_H
+
+EXTERN t_float *obj_findsignalscalar(const t_object *x, int m);
+EXTERN int obj_issignaloutlet(const t_object *x, int m);
+
+#endif /* XTBENCH_M_IMP_H */
@@ -0,0 +1,424 @@
+/* xtbench_pd.c -- benchmark harness for a generated pd dsp external
+
+Implements the part of pd's API (see m_pd.h, m_imp.h and g_canvas.h) which
+a generated dsp external calls from its setup, constructor and dsp methods,
+so that the external runs without pd. Instances are created through the
+class' constructor, their dsp method is called with synthetic signals and
+the perform routines registered with dsp_add() are run as a dsp chain,
+like in pd's scheduler (see xtbench.h for the options and output).
+
+Build with -DXT_SETUP=<name>_tilde_setup (see Makefile).
+*/
+
+#include <stdarg.h>
+
+#include "m_pd.h"
+#include "m_imp.h"
+#include "g_canvas.h"
+
+#include "xtbench.h"
+
+#define MAX_ARGS 6
+
+void XT_SETUP(void);
+
+
+/*
+ * stubs of the pd api
+ * ---------------------------------------------------------------------------
+ */
+
+struct _class {
+    t_symbol *c_name;
+    t_newmethod c_new;
+    t_method c_free;
+    size_t c_size;
+    t_atomtype c_args[MAX_ARGS + 1];
+    t_method c_dsp;
+    int c_mainsignalin;
+};
+
+static t_class *bench_class;    // the class created by XT_SETUP
+static int bench_nsigin;        // signal inlets of the last created object
+static int bench_nsigout;       // signal outlets of the last created object
+static t_float bench_sr = 48000;
+
+// the dsp chain: perform routines each followed by their arguments
+static t_int *bench_chain;
+static int bench_chainsize;
+static int bench_chainalloc;
+
+t_symbol s_pointer = {"pointer", 0, 0};
+t_symbol s_float = {"float", 0, 0};
+t_symbol s_symbol = {"symbol", 0, 0};
+t_symbol s_bang = {"bang", 0, 0};
+t_symbol s_list = {"list", 0, 0};
+t_symbol s_anything = {"anything", 0, 0};
+t_symbol s_signal = {"signal", 0, 0};
+t_symbol s__N = {"#N", 0, 0};
+t_symbol s__X = {"#X", 0, 0};
+t_symbol s_x = {"x", 0, 0};
+t_symbol s_y = {"y", 0, 0};
+t_symbol s_ = {"", 0, 0};
+
+static t_symbol *bench_symbols[] = {
+    &s_pointer, &s_float, &s_symbol, &s_bang, &s_list, &s_anything,
+    &s_signal, &s__N, &s__X, &s_x, &s_y, &s_,
+};
+
+t_symbol *gensym(const char *s)
+{
+    static t_symbol *symlist = 0;
+    t_symbol *sym;
+    size_t i;
+    for (i = 0; i < sizeof(bench_symbols) / sizeof(*bench_symbols); i++)
+        if (!strcmp(bench_symbols[i]->s_name, s))
+            return bench_symbols[i];
+    for (sym = symlist; sym; sym = sym->s_next)
+        if (!strcmp(sym->s_name, s))
+            return sym;
+    sym = (t_symbol *)calloc(1, sizeof(t_symbol));
+    sym->s_name = strdup(s);
+    sym->s_next = symlist;
+    symlist = sym;
+    return sym;
+}
+
+void *getbytes(size_t nbytes)
+{
+    return calloc(1, nbytes ? nbytes : 1);
+}
+
+void *resizebytes(void *x, size_t oldsize, size_t newsize)
+{
+    char *y = (char *)realloc(x, newsize ? newsize : 1);
+    if (y && newsize > oldsize)
+        memset(y + oldsize, 0, newsize - oldsize);
+    return y;
+}
+
+void freebytes(void *x, size_t nbytes)
+{
+    free(x);
+}
+
+t_class *class_new(t_symbol *name, t_newmethod newmethod, t_method freemethod,
+    size_t size, int flags, t_atomtype arg1, ...)
+{
+    t_class *c = (t_class *)calloc(1, sizeof(t_class));
+    t_atomtype t = arg1;
+    int n = 0;
+    va_list ap;
+    va_start(ap, arg1);
+    while (t != A_NULL && n < MAX_ARGS) {
+        c->c_args[n++] = t;
+        t = (t_atomtype)va_arg(ap, int);
+    }
+    va_end(ap);
+    c->c_args[n] = A_NULL;
+    c->c_name = name;
+    c->c_new = newmethod;
+    c->c_free = freemethod;
+    c->c_size = size;
+    bench_class = c;
+    return c;
+}
+
+void class_addmethod(t_class *c, t_method fn, t_symbol *sel, t_atomtype arg1, ...)
+{
+    if (!strcmp(sel->s_name, "dsp"))
+        c->c_dsp = fn;
+}
+
+void class_addcreator(t_newmethod newmethod, t_symbol *s, t_atomtype type1, ...) {}
+void (class_addbang)(t_class *c, t_method fn) {}
+void (class_addpointer)(t_class *c, t_method fn) {}
+void class_doaddfloat(t_class *c, t_method fn) {}
+void (class_addsymbol)(t_class *c, t_method fn) {}
+void (class_addlist)(t_class *c, t_method fn) {}
+void (class_addanything)(t_class *c, t_method fn) {}
+void class_sethelpsymbol(t_class *c, t_symbol *s) {}
+
+void class_domainsignalin(t_class *c, int onset)
+{
+    c->c_mainsignalin = 1;
+}
+
+t_pd *pd_new(t_class *cls)
+{
+    t_pd *x = (t_pd *)calloc(1, cls->c_size);
+    *x = cls;
+    bench_nsigin = cls->c_mainsignalin;
+    bench_nsigout = 0;
+    return x;
+}
+
+t_inlet *inlet_new(t_object *owner, t_pd *dest, t_symbol *s1, t_symbol *s2)
+{
+    if (s1 == &s_signal)
+        bench_nsigin++;
+    return (t_inlet *)owner;
+}
+
+t_inlet *floatinlet_new(t_object *owner, t_float *fp)
+{
+    return (t_inlet *)owner;
+}
+
+t_inlet *signalinlet_new(t_object *owner, t_float f)
+{
+    bench_nsigin++;
+    return (t_inlet *)owner;
+}
+
+t_float *obj_findsignalscalar(const t_object *x, int m)
+{
+    return (t_float *)calloc(1, sizeof(t_float));
+}
+
+// the signal outlets of a generated external are its first ones (the bench
+// patch has no connections, so this is only here to link)
+int obj_issignaloutlet(const t_object *x, int m)
+{
+    return m >= 0 && m < bench_nsigout;
+}
+
+t_outlet *outlet_new(t_object *owner, t_symbol *s)
+{
+    if (s == &s_signal)
+        bench_nsigout++;
+    return (t_outlet *)owner;
+}
+
+void outlet_bang(t_outlet *x) {}
+void outlet_float(t_outlet *x, t_float f) {}
+void outlet_symbol(t_outlet *x, t_symbol *s) {}
+void outlet_list(t_outlet *x, t_symbol *s, int argc, t_atom *argv) {}
+void outlet_anything(t_outlet *x, t_symbol *s, int argc, t_atom *argv) {}
+
+t_clock *clock_new(void *owner, t_method fn)
+{
+    return (t_clock *)owner;
+}
+
+void clock_delay(t_clock *x, double delaytime) {}
+void clock_unset(t_clock *x) {}
+void clock_free(t_clock *x) {}
+
+// the dsp is on while the benchmark runs
+int canvas_dspstate = 1;
+
+// the benchmark runs outside of a scheduler: logical time stands still at 0
+double clock_gettimesince(double prevsystime)
+{
+    return -prevsystime;
+}
+
+double clock_getlogicaltime(void)
+{
+    return 0;
+}
+
+double clock_getsystimeafter(double delaytime)
+{
+    return delaytime;
+}
+
+t_glist *canvas_getcurrent(void)
+{
+    return 0;
+}
+
+// every array name resolves to the same array of silence, so table params read real memory
+#define BENCH_ARRAY 65536
+
+struct _garray {
+    t_word vec[BENCH_ARRAY];
+};
+
+static struct _class bench_garray_class;
+static t_garray bench_array;
+t_class *garray_class = &bench_garray_class;
+
+t_pd *pd_findbyclass(t_symbol *s, const t_class *c)
+{
+    return (c == garray_class && *s->s_name) ? (t_pd *)&bench_array : 0;
+}
+
+int garray_getfloatwords(t_garray *x, int *size, t_word **vec)
+{
+    *size = BENCH_ARRAY;
+    *vec = x->vec;
+    return 1;
+}
+
+void garray_usedindsp(t_garray *x) {}
+
+// the benchmark patch has no connections: param inlets take the scalar path
+void linetraverser_start(t_linetraverser *t, t_canvas *x)
+{
+    memset(t, 0, sizeof(*t));
+}
+
+t_outconnect *linetraverser_next(t_linetraverser *t)
+{
+    return 0;
+}
+
+void post(const char *fmt, ...) {}
+
+void pd_error(const void *object, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+}
+
+t_float sys_getsr(void)
+{
+    return bench_sr;
+}
+
+int sys_getblksize(void)
+{
+    return 64;
+}
+
+void dsp_add(t_perfroutine f, int n, ...)
+{
+    int i;
+    va_list ap;
+    if (bench_chainsize + n + 2 > bench_chainalloc) {
+        bench_chainalloc = 2 * (bench_chainsize + n + 2);
+        bench_chain = (t_int *)realloc(bench_chain, bench_chainalloc * sizeof(t_int));
+    }
+    bench_chain[bench_chainsize++] = (t_int)f;
+    va_start(ap, n);
+    for (i = 0; i < n; i++)
+        bench_chain[bench_chainsize++] = va_arg(ap, t_int);
+    va_end(ap);
+}
+
+
+/*
+ * benchmark driver
+ * ---------------------------------------------------------------------------
+ */
+
+static t_int *bench_done(t_int *w)
+{
+    return 0;
+}
+
+// run one block of the dsp chain, like pd's scheduler does
+static void bench_tick(void *ctx)
+{
+    t_int *ip = bench_chain;
+    while (ip)
+        ip = (*(t_perfroutine)(*ip))(ip);
+}
+
+typedef void *(*t_newgimme)(t_symbol *s, int argc, t_atom *argv);
+typedef void *(*t_newargs)(t_int i1, t_int i2, t_int i3, t_int i4, t_int i5, t_int i6,
+    t_floatarg d1, t_floatarg d2, t_floatarg d3, t_floatarg d4, t_floatarg d5, t_floatarg d6);
+
+/**
+ * create an instance with default creation arguments
+ *
+ * like pd, pointer and float arguments are passed separately, which works
+ * on ABIs with separate integer and floating point argument registers.
+ */
+static t_object *bench_new(t_class *c)
+{
+    t_int ai[MAX_ARGS] = {0};
+    int i, n = 0;
+    if (c->c_args[0] == A_GIMME)
+        return (t_object *)((t_newgimme)c->c_new)(c->c_name, 0, 0);
+    for (i = 0; c->c_args[i] != A_NULL; i++)
+        if (c->c_args[i] == A_DEFSYM || c->c_args[i] == A_SYMBOL)
+            ai[n++] = (t_int)&s_;
+    return (t_object *)((t_newargs)c->c_new)(ai[0], ai[1], ai[2], ai[3], ai[4], ai[5],
+        0, 0, 0, 0, 0, 0);
+}
+
+int main(int argc, char **argv)
+{
+    t_xtb_options o;
+    int bi, ii, first = 1;
+
+    xtb_parse(argc, argv, &o);
+    bench_sr = (t_float)o.samplerate;
+    XT_SETUP();
+    if (!bench_class || !bench_class->c_dsp) {
+        fprintf(stderr, "xtbench: no dsp class was set up\n");
+        return 1;
+    }
+
+    for (bi = 0; bi < o.n_blocksizes; bi++) {
+        for (ii = 0; ii < o.n_instances; ii++) {
+            int n = o.blocksizes[bi], k = o.instances[ii];
+            int i, s, nsig = 0, nin = 0, nout = 0;
+            t_object **objs = (t_object **)calloc(k, sizeof(t_object *));
+            t_signal *sigs = 0;
+            t_signal **sp = 0;
+            t_sample *vecs = 0;
+            double seed = 1;
+            t_xtb_result r;
+
+            bench_chainsize = 0;
+            for (i = 0; i < k; i++) {
+                objs[i] = bench_new(bench_class);
+                if (!i) {
+                    nin = bench_nsigin;
+                    nout = bench_nsigout;
+                    nsig = nin + nout;
+                    sigs = (t_signal *)calloc((size_t)k * nsig, sizeof(t_signal));
+                    sp = (t_signal **)calloc((size_t)k * nsig, sizeof(t_signal *));
+                    vecs = (t_sample *)calloc((size_t)k * nsig * n, sizeof(t_sample));
+                }
+                for (s = 0; s < nsig; s++) {
+                    t_signal *sig = &sigs[i * nsig + s];
+                    // in place: outlet j shares the vector of inlet j
+                    int v = (o.inplace && s >= nin && s - nin < nin) ? s - nin : s;
+                    sig->s_n = n;
+                    sig->s_vec = vecs + ((size_t)i * nsig + v) * n;
+                    sig->s_sr = bench_sr;
+                    sp[i * nsig + s] = sig;
+                }
+                for (s = 0; s < nin; s++) {
+#if PD_FLOATSIZE == 64
+                    xtb_noise(&seed, 0, sp[i * nsig + s]->s_vec, n);
+#else
+                    xtb_noise(&seed, sp[i * nsig + s]->s_vec, 0, n);
+#endif
+                }
+                ((void (*)(t_object *, t_signal **))bench_class->c_dsp)(objs[i], sp + i * nsig);
+            }
+            dsp_add(bench_done, 0);
+
+            r.external = bench_class->c_name->s_name;
+            r.blocksize = n;
+            r.inputs = nin;
+            r.outputs = nout;
+            r.channels = nout;
+            r.instances = k;
+            r.inplace = o.inplace;
+            xtb_run(bench_tick, 0, &o, &r);
+            xtb_report(&o, &r, first);
+            first = 0;
+
+            for (i = 0; i < k; i++) {
+                if (bench_class->c_free)
+                    ((void (*)(t_object *))bench_class->c_free)(objs[i]);
+                free(objs[i]);
+            }
+            free(objs);
+            free(sigs);
+            free(sp);
+            free(vecs);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,250 @@
+/* xtbench.h -- shared part of the xtbench harnesses
+
+Command-line options, clocks and the timing loop used by the pd and max
+benchmark drivers (xtbench_pd.c, xtbench_mx.cpp). A driver loads the
+generated external through stubs of the host API and passes a `tick`
+function, which runs one block of all instances, to xtb_run().
+
+Results are printed one line per configuration, as JSON objects (default)
+or CSV, so they can be collected and compared across commits.
+
+usage: bench [-n blocksizes] [-i instances] [-c channels] [-s seconds]
+             [-r samplerate] [-f json|csv] [-p]
+
+    -n  comma separated block sizes (default 64)
+    -i  comma separated instance counts (default 1)
+    -c  comma separated channel counts of multichannel objects (default 1,
+        other objects have the fixed channel count of their spec)
+    -s  cpu seconds spent per configuration (default 0.5)
+    -r  sample rate passed to the dsp method (default 48000)
+    -f  output format (default json)
+    -p  process in place: output vectors alias the input vectors (ignored
+        for max objects which set Z_NO_INPLACE, as max does)
+*/
+
+#ifndef XTBENCH_H
+#define XTBENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define XTB_HAVE_CYCLES 1
+#else
+#define XTB_HAVE_CYCLES 0
+#endif
+
+#define XTB_MAX_CONFIGS 16
+#define XTB_WARMUP_BLOCKS 16
+#define XTB_BATCH_BLOCKS 64
+
+typedef struct _xtb_options {
+    int blocksizes[XTB_MAX_CONFIGS];
+    int n_blocksizes;
+    int instances[XTB_MAX_CONFIGS];
+    int n_instances;
+    int channels[XTB_MAX_CONFIGS];
+    int n_channels;
+    double seconds;
+    double samplerate;
+    int csv;
+    int inplace;
+} t_xtb_options;
+
+typedef struct _xtb_result {
+    const char *external;
+    int blocksize;
+    int inputs;         // signal inputs per instance (audio and param inlets)
+    int outputs;        // signal outputs per instance
+    int channels;       // audio channels per instance
+    int instances;
+    int inplace;        // outputs alias inputs (-p, unless the object forbids it)
+    long blocks;        // blocks run per instance
+    double seconds;
+    uint64_t cycles;    // 0 when no cycle counter is available
+} t_xtb_result;
+
+
+static void xtb_usage(const char *prog)
+{
+    fprintf(stderr,
+        "usage: %s [-n blocksizes] [-i instances] [-c channels] [-s seconds]"
+        " [-r samplerate] [-f json|csv] [-p]\n", prog);
+    exit(1);
+}
+
+static int xtb_parse_list(const char *s, int *out)
+{
+    int n = 0;
+    while (*s && n < XTB_MAX_CONFIGS) {
+        char *end;
+        long v = strtol(s, &end, 10);
+        if (end == s || v < 1)
+            return 0;
+        out[n++] = (int)v;
+        s = (*end == ',') ? end + 1 : end;
+    }
+    return n;
+}
+
+static void xtb_parse(int argc, char **argv, t_xtb_options *o)
+{
+    int i;
+    o->blocksizes[0] = 64;
+    o->n_blocksizes = 1;
+    o->instances[0] = 1;
+    o->n_instances = 1;
+    o->channels[0] = 1;
+    o->n_channels = 1;
+    o->seconds = 0.5;
+    o->samplerate = 48000;
+    o->csv = 0;
+    o->inplace = 0;
+
+    for (i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!strcmp(arg, "-p")) {
+            o->inplace = 1;
+            continue;
+        }
+        if (!val)
+            xtb_usage(argv[0]);
+        if (!strcmp(arg, "-n"))
+            o->n_blocksizes = xtb_parse_list(val, o->blocksizes);
+        else if (!strcmp(arg, "-i"))
+            o->n_instances = xtb_parse_list(val, o->instances);
+        else if (!strcmp(arg, "-c"))
+            o->n_channels = xtb_parse_list(val, o->channels);
+        else if (!strcmp(arg, "-s"))
+            o->seconds = atof(val);
+        else if (!strcmp(arg, "-r"))
+            o->samplerate = atof(val);
+        else if (!strcmp(arg, "-f"))
+            o->csv = !strcmp(val, "csv");
+        else
+            xtb_usage(argv[0]);
+        i++;
+    }
+    if (!o->n_blocksizes || !o->n_instances || !o->n_channels || o->seconds <= 0 || o->samplerate <= 0)
+        xtb_usage(argv[0]);
+}
+
+// monotonic wall clock in seconds
+static double xtb_now(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart / (double)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+static uint64_t xtb_cycles(void)
+{
+#if XTB_HAVE_CYCLES
+    return (uint64_t)__rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// fill a vector with deterministic noise in [-1, 1)
+static void xtb_noise(double *seed, float *fvec, double *dvec, int n)
+{
+    int i;
+    for (i = 0; i < n; i++) {
+        *seed = *seed * 16807.0 - (int64_t)(*seed * 16807.0 / 2147483647.0) * 2147483647.0;
+        if (fvec)
+            fvec[i] = (float)(*seed / 1073741823.5 - 1.0);
+        if (dvec)
+            dvec[i] = *seed / 1073741823.5 - 1.0;
+    }
+}
+
+/**
+ * run `tick` (one block of every instance) for the configured cpu time,
+ * after a few warmup blocks, and fill in the timings of `r`
+ */
+static void xtb_run(void (*tick)(void *), void *ctx, const t_xtb_options *o,
+    t_xtb_result *r)
+{
+    long b;
+    double t0, t1;
+    uint64_t c0, c1;
+
+    for (b = 0; b < XTB_WARMUP_BLOCKS; b++)
+        tick(ctx);
+
+    r->blocks = 0;
+    t0 = xtb_now();
+    c0 = xtb_cycles();
+    do {
+        for (b = 0; b < XTB_BATCH_BLOCKS; b++)
+            tick(ctx);
+        r->blocks += XTB_BATCH_BLOCKS;
+        t1 = xtb_now();
+    } while (t1 - t0 < o->seconds);
+    c1 = xtb_cycles();
+    r->seconds = t1 - t0;
+    r->cycles = c1 - c0;
+}
+
+/**
+ * print one result line
+ *
+ * ns_per_sample and cycles_per_block are per instance, msamples_per_sec
+ * counts the sample frames of all instances, and realtime is the ratio of
+ * the processed audio time to the cpu time (> 1 is faster than realtime).
+ */
+static void xtb_report(const t_xtb_options *o, const t_xtb_result *r, int first)
+{
+    double frames = (double)r->blocks * r->blocksize * r->instances;
+    double ns_per_sample = r->seconds * 1e9 / frames;
+    double cycles_per_block = (double)r->cycles / ((double)r->blocks * r->instances);
+    double msamples_per_sec = frames / r->seconds / 1e6;
+    double realtime = (double)r->blocks * r->blocksize / o->samplerate / r->seconds;
+
+    if (o->csv) {
+        if (first)
+            printf("external,blocksize,inputs,outputs,channels,instances,inplace,blocks,"
+                   "ns_per_sample,cycles_per_block,msamples_per_sec,realtime\n");
+        printf("%s,%d,%d,%d,%d,%d,%d,%ld,%.4f,%.1f,%.3f,%.2f\n",
+            r->external, r->blocksize, r->inputs, r->outputs, r->channels, r->instances,
+            r->inplace, r->blocks, ns_per_sample, cycles_per_block,
+            msamples_per_sec, realtime);
+    } else {
+        printf("{\"external\": \"%s\", \"blocksize\": %d, \"inputs\": %d, "
+               "\"outputs\": %d, \"channels\": %d, \"instances\": %d, "
+               "\"inplace\": %d, \"blocks\": %ld, \"ns_per_sample\": %.4f, ",
+            r->external, r->blocksize, r->inputs, r->outputs, r->channels, r->instances,
+            r->inplace, r->blocks, ns_per_sample);
+        if (XTB_HAVE_CYCLES)
+            printf("\"cycles_per_block\": %.1f, ", cycles_per_block);
+        else
+            printf("\"cycles_per_block\": null, ");
+        printf("\"msamples_per_sec\": %.3f, \"realtime\": %.2f}\n",
+            msamples_per_sec, realtime);
+    }
+    fflush(stdout);
+}
+
+#endif /* XTBENCH_H */
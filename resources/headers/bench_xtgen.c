@@ -0,0 +1,314 @@
+/* bench_xtgen.c -- speed and accuracy of the xtgen_common.h helpers
+
+For every function, runs over a buffer of inputs spread across its valid
+domain:
+
+    double  the double version, one call per sample (the reference)
+    float   the fast float version (_f), one call per sample, with
+            vectorization disabled as in a perform loop that does not
+            vectorize
+    buf     the batch form (_buf), which processes the whole buffer
+
+and prints one line per function and variant, as JSON objects (default)
+or CSV, with ns per call, throughput, and the max absolute and relative
+errors against the double version evaluated at the same (float) inputs.
+Relative errors only count reference values with |ref| >= 1e-3.
+
+usage: bench_xtgen [-n samples] [-s seconds] [-f json|csv] [name...]
+
+    -n  samples per buffer (default 65536)
+    -s  cpu seconds spent per measurement (default 0.1)
+    -f  output format (default json)
+
+Only the functions whose name contains one of the given names are run.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "xtgen_common.h"
+
+#if defined(__GNUC__) && !defined(__clang__)
+#define NOVEC __attribute__((noinline, optimize("no-tree-vectorize")))
+#else
+#define NOVEC __attribute__((noinline))
+#endif
+
+#define REL_MIN 1e-3
+
+typedef void (*t_runner)(const float *in, float *out, int n);
+typedef void (*t_ref_runner)(const float *in, double *out, int n);
+
+typedef struct _bench_func {
+    const char *name;
+    double lo, hi;          // valid domain of the input
+    t_ref_runner ref;       // double version
+    t_runner fast;          // float version
+    t_runner buf;           // batch form
+} t_bench_func;
+
+typedef struct _bench_options {
+    int n;
+    double seconds;
+    int csv;
+} t_bench_options;
+
+
+/*
+ * runners
+ * ---------------------------------------------------------------------------
+ */
+
+#define RUNNERS(name, ref_expr, fast_expr, buf_stmt) \
+    static NOVEC void name##_ref_run(const float *in, double *out, int n) \
+    { \
+        for (int i = 0; i < n; i++) { \
+            double t = in[i]; \
+            out[i] = (ref_expr); \
+        } \
+    } \
+    static NOVEC void name##_fast_run(const float *in, float *out, int n) \
+    { \
+        for (int i = 0; i < n; i++) { \
+            float t = in[i]; \
+            out[i] = (fast_expr); \
+        } \
+    } \
+    static __attribute__((noinline)) void name##_buf_run(const float *in, float *out, int n) \
+    { \
+        buf_stmt; \
+    }
+
+#define EASE_RUNNERS(name) RUNNERS(name, name(t), name##_f(t), name##_buf(in, out, n))
+
+RUNNERS(clamp, clamp(t, 0.25, 0.75), clamp(t, 0.25f, 0.75f), clamp_buf(in, out, n, 0.25f, 0.75f))
+RUNNERS(linear_scale, linear_scale(t, 0, 1, 20, 20000), linear_scale_f(t, 0, 1, 20, 20000),
+    linear_scale_buf(in, out, n, 0, 1, 20, 20000))
+RUNNERS(xt_exp2f, exp2(t), xt_exp2f(t), for (int i = 0; i < n; i++) out[i] = xt_exp2f(in[i]))
+RUNNERS(xt_sinf, sin(t), xt_sinf(t), for (int i = 0; i < n; i++) out[i] = xt_sinf(in[i]))
+RUNNERS(xt_cosf, cos(t), xt_cosf(t), for (int i = 0; i < n; i++) out[i] = xt_cosf(in[i]))
+EASE_RUNNERS(ease_in_sine)
+EASE_RUNNERS(ease_out_sine)
+EASE_RUNNERS(ease_inout_sine)
+EASE_RUNNERS(ease_in_quad)
+EASE_RUNNERS(ease_out_quad)
+EASE_RUNNERS(ease_inout_quad)
+EASE_RUNNERS(ease_in_cubic)
+EASE_RUNNERS(ease_out_cubic)
+EASE_RUNNERS(ease_inout_cubic)
+EASE_RUNNERS(ease_in_quart)
+EASE_RUNNERS(ease_out_quart)
+EASE_RUNNERS(ease_inout_quart)
+EASE_RUNNERS(ease_in_quint)
+EASE_RUNNERS(ease_out_quint)
+EASE_RUNNERS(ease_inout_quint)
+EASE_RUNNERS(ease_in_expo)
+EASE_RUNNERS(ease_out_expo)
+EASE_RUNNERS(ease_inout_expo)
+EASE_RUNNERS(ease_in_circ)
+EASE_RUNNERS(ease_out_circ)
+EASE_RUNNERS(ease_inout_circ)
+EASE_RUNNERS(ease_in_back)
+EASE_RUNNERS(ease_out_back)
+EASE_RUNNERS(ease_inout_back)
+EASE_RUNNERS(ease_in_elastic)
+EASE_RUNNERS(ease_out_elastic)
+EASE_RUNNERS(ease_inout_elastic)
+EASE_RUNNERS(ease_in_bounce)
+EASE_RUNNERS(ease_out_bounce)
+EASE_RUNNERS(ease_inout_bounce)
+
+#define FUNC(name, lo, hi) {#name, lo, hi, name##_ref_run, name##_fast_run, name##_buf_run}
+#define EASE(name) FUNC(name, 0.0, 1.0)
+
+static const t_bench_func bench_funcs[] = {
+    FUNC(clamp, 0.0, 1.0),
+    FUNC(linear_scale, 0.0, 1.0),
+    FUNC(xt_exp2f, -126.0, 127.0),
+    FUNC(xt_sinf, -1000.0, 1000.0),
+    FUNC(xt_cosf, -1000.0, 1000.0),
+    EASE(ease_in_sine),
+    EASE(ease_out_sine),
+    EASE(ease_inout_sine),
+    EASE(ease_in_quad),
+    EASE(ease_out_quad),
+    EASE(ease_inout_quad),
+    EASE(ease_in_cubic),
+    EASE(ease_out_cubic),
+    EASE(ease_inout_cubic),
+    EASE(ease_in_quart),
+    EASE(ease_out_quart),
+    EASE(ease_inout_quart),
+    EASE(ease_in_quint),
+    EASE(ease_out_quint),
+    EASE(ease_inout_quint),
+    EASE(ease_in_expo),
+    EASE(ease_out_expo),
+    EASE(ease_inout_expo),
+    EASE(ease_in_circ),
+    EASE(ease_out_circ),
+    EASE(ease_inout_circ),
+    EASE(ease_in_back),
+    EASE(ease_out_back),
+    EASE(ease_inout_back),
+    EASE(ease_in_elastic),
+    EASE(ease_out_elastic),
+    EASE(ease_inout_elastic),
+    EASE(ease_in_bounce),
+    EASE(ease_out_bounce),
+    EASE(ease_inout_bounce),
+};
+
+
+/*
+ * measurement
+ * ---------------------------------------------------------------------------
+ */
+
+static void bench_usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-n samples] [-s seconds] [-f json|csv] [name...]\n", prog);
+    exit(1);
+}
+
+// monotonic wall clock in seconds
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * fill `in` with n inputs across [lo, hi]: an even grid (so the error is
+ * measured everywhere, endpoints included) in shuffled order (so timings
+ * do not profit from a predictable input)
+ */
+static void bench_inputs(float *in, int n, double lo, double hi)
+{
+    unsigned long seed = 1;
+    for (int i = 0; i < n; i++)
+        in[i] = (float)(lo + (hi - lo) * i / (n - 1));
+    for (int i = n - 1; i > 0; i--) {
+        int j;
+        float t;
+        seed = seed * 1103515245UL + 12345UL;
+        j = (int)((seed >> 8) % (unsigned long)(i + 1));
+        t = in[i];
+        in[i] = in[j];
+        in[j] = t;
+    }
+}
+
+// ns per sample of `run` (or `ref`) over the buffer, repeated for o->seconds
+static double bench_time(t_runner run, t_ref_runner ref, const float *in, float *out,
+    double *refout, const t_bench_options *o)
+{
+    long calls = 0;
+    double t0, t1;
+    t0 = bench_now();
+    do {
+        if (run)
+            run(in, out, o->n);
+        else
+            ref(in, refout, o->n);
+        calls++;
+        t1 = bench_now();
+    } while (t1 - t0 < o->seconds);
+    return (t1 - t0) * 1e9 / ((double)calls * o->n);
+}
+
+// max absolute and relative error of `out` against `ref`
+static void bench_error(const double *ref, const float *out, int n, double *abs_err, double *rel_err)
+{
+    *abs_err = *rel_err = 0;
+    for (int i = 0; i < n; i++) {
+        double e = fabs((double)out[i] - ref[i]);
+        if (e > *abs_err)
+            *abs_err = e;
+        if (fabs(ref[i]) >= REL_MIN && e / fabs(ref[i]) > *rel_err)
+            *rel_err = e / fabs(ref[i]);
+    }
+}
+
+static void bench_report(const t_bench_options *o, const t_bench_func *f, const char *variant,
+    double ns, double abs_err, double rel_err, int first)
+{
+    double msamples_per_sec = 1e3 / ns;
+    if (o->csv) {
+        if (first)
+            printf("function,variant,lo,hi,samples,ns_per_call,msamples_per_sec,max_abs_err,max_rel_err\n");
+        printf("%s,%s,%g,%g,%d,%.4f,%.2f,%.3g,%.3g\n", f->name, variant, f->lo, f->hi,
+            o->n, ns, msamples_per_sec, abs_err, rel_err);
+    } else {
+        printf("{\"function\": \"%s\", \"variant\": \"%s\", \"lo\": %g, \"hi\": %g, "
+               "\"samples\": %d, \"ns_per_call\": %.4f, \"msamples_per_sec\": %.2f, "
+               "\"max_abs_err\": %.3g, \"max_rel_err\": %.3g}\n", f->name, variant, f->lo, f->hi,
+            o->n, ns, msamples_per_sec, abs_err, rel_err);
+    }
+    fflush(stdout);
+}
+
+static int bench_selected(const char *name, int argc, char **argv, int first_name)
+{
+    if (first_name >= argc)
+        return 1;
+    for (int i = first_name; i < argc; i++)
+        if (strstr(name, argv[i]))
+            return 1;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    t_bench_options o = {65536, 0.1, 0};
+    int i, first = 1;
+    float *in, *out;
+    double *ref;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i += 2) {
+        if (i + 1 >= argc)
+            bench_usage(argv[0]);
+        if (!strcmp(argv[i], "-n"))
+            o.n = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "-s"))
+            o.seconds = atof(argv[i + 1]);
+        else if (!strcmp(argv[i], "-f"))
+            o.csv = !strcmp(argv[i + 1], "csv");
+        else
+            bench_usage(argv[0]);
+    }
+    if (o.n < 2 || o.seconds <= 0)
+        bench_usage(argv[0]);
+
+    in = (float *)malloc(o.n * sizeof(float));
+    ref = (double *)malloc(o.n * sizeof(double));
+    out = (float *)malloc(o.n * sizeof(float));
+
+    for (size_t k = 0; k < sizeof(bench_funcs) / sizeof(*bench_funcs); k++) {
+        const t_bench_func *f = &bench_funcs[k];
+        double abs_err, rel_err, ns;
+        if (!bench_selected(f->name, argc, argv, i))
+            continue;
+        bench_inputs(in, o.n, f->lo, f->hi);
+
+        ns = bench_time(0, f->ref, in, out, ref, &o);
+        bench_report(&o, f, "double", ns, 0, 0, first);
+        first = 0;
+
+        ns = bench_time(f->fast, 0, in, out, ref, &o);
+        bench_error(ref, out, o.n, &abs_err, &rel_err);
+        bench_report(&o, f, "float", ns, abs_err, rel_err, 0);
+
+        ns = bench_time(f->buf, 0, in, out, ref, &o);
+        bench_error(ref, out, o.n, &abs_err, &rel_err);
+        bench_report(&o, f, "buf", ns, abs_err, rel_err, 0);
+    }
+
+    free(in);
+    free(ref);
+    free(out);
+    return 0;
+}
@@ -1,19 +1,35 @@
+#ifndef XTGEN_COMMON_H
+#define XTGEN_COMMON_H
+
 #include <math.h>
+#include <stdint.h>
+#include <string.h>
 
 #define PI 3.1415926535
 #define HALF_PI 1.5707963
 
+#if defined(_MSC_VER)
+#define XT_RESTRICT __restrict
+#else
+#define XT_RESTRICT __restrict__
+#endif
+
 
 /*
  * General helper functions for xtgen templates
+ *
+ * Everything is static inline, so the header can be included from several
+ * translation units of an external.
  */
 
-float clamp(float value, float smallest, float largest)
+// compiles to min/max instructions (unlike fmax/fmin, which handle NaN)
+static inline float clamp(float value, float smallest, float largest)
 {
-    return fmax(smallest, fmin(value, largest));
+    value = (value < smallest) ? smallest : value;
+    return (value > largest) ? largest : value;
 }
 
-float linear_scale(float x, float from_min, float from_max, float to_min, float to_max)
+static inline float linear_scale(float x, float from_min, float from_max, float to_min, float to_max)
 {
     return ((to_max - to_min) * (x - from_min) / (from_max - from_min)) + to_min;
 }
@@ -21,82 +37,82 @@ float linear_scale(float x, float from_min, float from_max, float to_min, float
 // add easing functions... from https://github.com/nicolausYes/easing-functions
 
 
-double ease_in_linear(double t, double b, double c, double d)
+static inline double ease_in_linear(double t, double b, double c, double d)
 { 
 	return (c * t / d + b);
 }
 
-double ease_out_linear(double t, double b, double c, double d)
+static inline double ease_out_linear(double t, double b, double c, double d)
 { 
 	return (c * t / d + b);
 }
 
-double ease_inout_linear(double t, double b, double c, double d)
+static inline double ease_inout_linear(double t, double b, double c, double d)
 { 
 	return (c * t / d + b);
 }
 
-double ease_in_sine(double t)
+static inline double ease_in_sine(double t)
 {
 	return sin(HALF_PI * t);
 }
 
-double ease_out_sine(double t)
+static inline double ease_out_sine(double t)
 {
 	return 1 + sin(HALF_PI * (--t));
 }
 
-double ease_inout_sine(double t)
+static inline double ease_inout_sine(double t)
 {
     return 0.5 * (1 + sin(PI * (t - 0.5)));
 }
 
-double ease_in_quad(double t)
+static inline double ease_in_quad(double t)
 {
 	return t * t;
 }
 
-double ease_out_quad(double t)
+static inline double ease_out_quad(double t)
 {
 	return t * (2 - t);
 }
 
-double ease_inout_quad(double t)
+static inline double ease_inout_quad(double t)
 {
     return t < 0.5 ? 2 * t * t : t * (4 - 2 * t) - 1;
 }
 
-double ease_in_cubic(double t)
+static inline double ease_in_cubic(double t)
 { 
 	return t * t * t;
 }
 
-double ease_out_cubic(double t)
+static inline double ease_out_cubic(double t)
 {
 	double t1 = t - 1.0;
 	return 1 + t1 * t * t;
 }
 
-double ease_inout_cubic(double t)
+static inline double ease_inout_cubic(double t)
 {
 	double t1 = t - 1.0;
     return t < 0.5 ? 4 * t * t * t : 1 + t1 * (2 * t1) * (2 * t);
 }
 
-double ease_in_quart(double t)
+static inline double ease_in_quart(double t)
 {
     t *= t;
     return t * t;
 }
 
-double ease_out_quart(double t)
+static inline double ease_out_quart(double t)
 {
 	double t1 = t - 1.0;
     t = t1 * t;
     return 1 - t * t;
 }
 
-double ease_inout_quart(double t)
+static inline double ease_inout_quart(double t)
 {
     if (t < 0.5) {
         t *= t;
@@ -108,20 +124,20 @@ double ease_inout_quart(double t)
     }
 }
 
-double ease_in_quint(double t)
+static inline double ease_in_quint(double t)
 {
     double t2 = t * t;
     return t * t2 * t2;
 }
 
-double ease_out_quint(double t)
+static inline double ease_out_quint(double t)
 {
 	double t1 = t - 1.0;
     double t2 = t1 * t;
     return 1 + t * t2 * t2;
 }
 
-double ease_inout_quint(double t)
+static inline double ease_inout_quint(double t)
 {
     double t2;
     if (t < 0.5) {
@@ -134,17 +150,17 @@ double ease_inout_quint(double t)
     }
 }
 
-double ease_in_expo(double t)
+static inline double ease_in_expo(double t)
 { 
 	return (pow(2, 8 * t) - 1) / 255;
 }
 
-double ease_out_expo(double t)
+static inline double ease_out_expo(double t)
 { 
 	return 1 - pow(2, -8 * t);
 }
 
-double ease_inout_expo(double t)
+static inline double ease_inout_expo(double t)
 {
     if (t < 0.5) {
         return (pow(2, 16 * t) - 1) / 510;
@@ -153,17 +169,17 @@ double ease_inout_expo(double t)
     }
 }
 
-double ease_in_circ(double t)
+static inline double ease_in_circ(double t)
 {
 	return 1 - sqrt(1 - t);
 }
 
-double ease_out_circ(double t)
+static inline double ease_out_circ(double t)
 {
 	return sqrt(t);
 }
 
-double ease_inout_circ(double t)
+static inline double ease_inout_circ(double t)
 {
     if (t < 0.5) {
         return (1 - sqrt(1 - 2 * t)) * 0.5;
@@ -172,18 +188,18 @@ double ease_inout_circ(double t)
     }
 }
 
-double ease_in_back(double t)
+static inline double ease_in_back(double t)
 { 
 	return t * t * (2.70158 * t - 1.70158);
 }
 
-double ease_out_back(double t)
+static inline double ease_out_back(double t)
 { 
 	double t1 = t - 1.0;
 	return 1 + t1 * t * (2.70158 * t + 1.70158);
 }
 
-double ease_inout_back(double t)
+static inline double ease_inout_back(double t)
 {
     if (t < 0.5) {
         return t * t * (7 * t - 2.5) * 2;
@@ -193,19 +209,19 @@ double ease_inout_back(double t)
     }
 }
 
-double ease_in_elastic(double t)
+static inline double ease_in_elastic(double t)
 {
     double t2 = t * t;
     return t2 * t2 * sin(t * PI * 4.5);
 }
 
-double ease_out_elastic(double t)
+static inline double ease_out_elastic(double t)
 {
     double t2 = (t - 1) * (t - 1);
     return 1 - t2 * t2 * cos(t * PI * 4.5);
 }
 
-double ease_inout_elastic(double t)
+static inline double ease_inout_elastic(double t)
 {
     double t2;
     if (t < 0.45) {
@@ -219,21 +235,385 @@ double ease_inout_elastic(double t)
     }
 }
 
-double ease_in_bounce(double t)
+static inline double ease_in_bounce(double t)
 {
     return pow(2, 6 * (t - 1)) * fabs(sin(t * PI * 3.5));
 }
 
-double ease_out_bounce(double t)
+static inline double ease_out_bounce(double t)
 {
     return 1 - pow(2, -6 * t) * fabs(cos(t * PI * 3.5));
 }
 
-double ease_inout_bounce(double t)
+static inline double ease_inout_bounce(double t)
 {
     if (t < 0.5) {
         return 8 * pow(2, 8 * (t - 1)) * fabs(sin(t * PI * 7));
     } else {
         return 1 - 8 * pow(2, -8 * t) * fabs(sin(t * PI * 7));
     }
-}
\ No newline at end of file
+}
+
+
+/*
+ * Fast float variants
+ *
+ * ease_*_f() are float versions of the easings above, for per-sample use
+ * over the domain t in [0, 1]. They replace libm pow/sin/cos by the
+ * polynomial approximations xt_exp2f and xt_sinf/xt_cosf, which are
+ * branch-free, so the _buf forms below vectorize. Measured over [0, 1]
+ * against the double versions at the same (float) t, the absolute error
+ * is below 1e-6 for all easings. Near their vertical tangents (t = 1, and
+ * t = 0.5 for inout) the circ easings also magnify the rounding of t to
+ * float, up to 1e-5.
+ */
+
+/**
+ * cond ? a : b as a bitwise blend, for loops which must vectorize: gcc
+ * does not if-convert selects between computed floats unless it may
+ * assume -fno-trapping-math
+ */
+static inline float xt_selectf(int cond, float a, float b)
+{
+    int32_t mask = -(int32_t)(cond != 0), ia, ib;
+    memcpy(&ia, &a, sizeof(ia));
+    memcpy(&ib, &b, sizeof(ib));
+    ia = (ia & mask) | (ib & ~mask);
+    memcpy(&a, &ia, sizeof(a));
+    return a;
+}
+
+/**
+ * 2^x for x in [-126, 127], max relative error 1e-7
+ *
+ * x is split into the nearest integer i, which becomes the exponent bits,
+ * and f in [-0.5, 0.5], for which 2^f is a degree 5 polynomial (cephes
+ * exp2f). i is rounded by adding 1.5 * 2^23, which leaves it in the low
+ * mantissa bits, and clamped as an integer (the result saturates for
+ * |x| < 2^22): unlike a float to int conversion or float selects this
+ * vectorizes without -fno-trapping-math.
+ */
+static inline float xt_exp2f(float x)
+{
+    const float magic = 12582912.0f;   // 1.5 * 2^23
+    float r, f, p;
+    int32_t i;
+    uint32_t bits;
+    r = x + magic;
+    f = x - (r - magic);
+    memcpy(&i, &r, sizeof(i));
+    i -= 0x4B400000;
+    i = (i < -126) ? -126 : i;
+    i = (i > 127) ? 127 : i;
+    p = 1.535336188319500e-4f;
+    p = p * f + 1.339887440266574e-3f;
+    p = p * f + 9.618437357674640e-3f;
+    p = p * f + 5.550332471162809e-2f;
+    p = p * f + 2.402264791363012e-1f;
+    p = p * f + 6.931472028550421e-1f;
+    p = p * f + 1.0f;
+    bits = (uint32_t)(i + 127) << 23;   // 2^i
+    memcpy(&r, &bits, sizeof(r));
+    return p * r;
+}
+
+// x reduced to [-pi, pi] by whole turns, |x| < 1000
+static inline float xt_turnf(float x)
+{
+    float r, k;
+    int32_t i;
+    r = x * (1.0f / 6.28318530717958647692f) + 0.5f;
+    i = (int32_t)r;
+    i -= (r < (float)i);            // floor: the nearest whole turn
+    k = (float)i;
+    return (x - k * 6.28125f) - k * 1.93530717958647692e-3f;   // exact high part first
+}
+
+// odd degree 9 polynomial for sin on [-pi/2, pi/2] (fitted to an error of 3e-9)
+static inline float xt_sinpolyf(float x)
+{
+    float x2 = x * x;
+    return x * (0.9999999766f + x2 * (-0.1666664764f + x2 * (0.0083328999f
+        + x2 * (-0.0001980090f + x2 * 2.5904969e-6f))));
+}
+
+/**
+ * sin(x) for |x| < 1000, max absolute error 3e-7
+ *
+ * x is reduced to [-pi, pi] by whole turns and folded to [-pi/2, pi/2],
+ * where sin is a polynomial.
+ */
+static inline float xt_sinf(float x)
+{
+    const float half_pi = 1.57079632679489661923f;
+    x = xt_turnf(x);
+    return xt_sinpolyf((half_pi - fabsf(fabsf(x) - half_pi)) * copysignf(1.0f, x));   // sin(x) = sin(pi - x)
+}
+
+/**
+ * cos(x) for |x| < 1000, max absolute error 3e-7
+ *
+ * as cos(x) = sin(pi/2 - |x|) on [-pi, pi], the quarter turn is added
+ * after the reduction, where it does not lose the low bits of a large x.
+ */
+static inline float xt_cosf(float x)
+{
+    return xt_sinpolyf(1.57079632679489661923f - fabsf(xt_turnf(x)));
+}
+
+static inline float linear_scale_f(float x, float from_min, float from_max, float to_min, float to_max)
+{
+    return ((to_max - to_min) * (x - from_min) / (from_max - from_min)) + to_min;
+}
+
+static inline float ease_in_linear_f(float t, float b, float c, float d)
+{
+    return (c * t / d + b);
+}
+
+static inline float ease_out_linear_f(float t, float b, float c, float d)
+{
+    return (c * t / d + b);
+}
+
+static inline float ease_inout_linear_f(float t, float b, float c, float d)
+{
+    return (c * t / d + b);
+}
+
+static inline float ease_in_sine_f(float t)
+{
+    return xt_sinf(1.5707963f * t);
+}
+
+static inline float ease_out_sine_f(float t)
+{
+    return 1 + xt_sinf(1.5707963f * (t - 1));
+}
+
+static inline float ease_inout_sine_f(float t)
+{
+    return 0.5f * (1 + xt_sinf(3.1415927f * (t - 0.5f)));
+}
+
+static inline float ease_in_quad_f(float t)
+{
+    return t * t;
+}
+
+static inline float ease_out_quad_f(float t)
+{
+    return t * (2 - t);
+}
+
+static inline float ease_inout_quad_f(float t)
+{
+    return xt_selectf(t < 0.5f, 2 * t * t, t * (4 - 2 * t) - 1);
+}
+
+static inline float ease_in_cubic_f(float t)
+{
+    return t * t * t;
+}
+
+static inline float ease_out_cubic_f(float t)
+{
+    float t1 = t - 1;
+    return 1 + t1 * t * t;
+}
+
+static inline float ease_inout_cubic_f(float t)
+{
+    float t1 = t - 1;
+    return xt_selectf(t < 0.5f, 4 * t * t * t, 1 + t1 * (2 * t1) * (2 * t));
+}
+
+static inline float ease_in_quart_f(float t)
+{
+    t *= t;
+    return t * t;
+}
+
+static inline float ease_out_quart_f(float t)
+{
+    float t1 = (t - 1) * t;
+    return 1 - t1 * t1;
+}
+
+static inline float ease_inout_quart_f(float t)
+{
+    float t2 = t * t, t1 = (t - 1) * t;
+    return xt_selectf(t < 0.5f, 8 * t2 * t2, 1 - 8 * t1 * t1);
+}
+
+static inline float ease_in_quint_f(float t)
+{
+    float t2 = t * t;
+    return t * t2 * t2;
+}
+
+static inline float ease_out_quint_f(float t)
+{
+    float t2 = (t - 1) * t;
+    return 1 + t * t2 * t2;
+}
+
+static inline float ease_inout_quint_f(float t)
+{
+    float t2 = t * t, t1 = (t - 1) * t;
+    return xt_selectf(t < 0.5f, 16 * t * t2 * t2, 1 + 16 * t * t1 * t1);
+}
+
+static inline float ease_in_expo_f(float t)
+{
+    return (xt_exp2f(8 * t) - 1) * (1.0f / 255);
+}
+
+static inline float ease_out_expo_f(float t)
+{
+    return 1 - xt_exp2f(-8 * t);
+}
+
+static inline float ease_inout_expo_f(float t)
+{
+    return xt_selectf(t < 0.5f, (xt_exp2f(16 * t) - 1) * (1.0f / 510),
+        1 - 0.5f * xt_exp2f(-16 * (t - 0.5f)));
+}
+
+static inline float ease_in_circ_f(float t)
+{
+    return 1 - sqrtf(1 - t);
+}
+
+static inline float ease_out_circ_f(float t)
+{
+    return sqrtf(t);
+}
+
+// both halves are computed, so they take |2t - 1| to stay in the domain of sqrt
+static inline float ease_inout_circ_f(float t)
+{
+    float r = sqrtf(fabsf(2 * t - 1));
+    return xt_selectf(t < 0.5f, (1 - r) * 0.5f, (1 + r) * 0.5f);
+}
+
+static inline float ease_in_back_f(float t)
+{
+    return t * t * (2.70158f * t - 1.70158f);
+}
+
+static inline float ease_out_back_f(float t)
+{
+    float t1 = t - 1;
+    return 1 + t1 * t * (2.70158f * t + 1.70158f);
+}
+
+static inline float ease_inout_back_f(float t)
+{
+    float t1 = t - 1;
+    return xt_selectf(t < 0.5f, t * t * (7 * t - 2.5f) * 2, 1 + t1 * t * 2 * (7 * t + 2.5f));
+}
+
+static inline float ease_in_elastic_f(float t)
+{
+    float t2 = t * t;
+    return t2 * t2 * xt_sinf(t * 14.137167f);       // 4.5 pi
+}
+
+static inline float ease_out_elastic_f(float t)
+{
+    float t2 = (t - 1) * (t - 1);
+    return 1 - t2 * t2 * xt_cosf(t * 14.137167f);
+}
+
+static inline float ease_inout_elastic_f(float t)
+{
+    float t2 = t * t, t1 = (t - 1) * (t - 1);
+    float s = xt_sinf(t * 28.274334f);              // 9 pi
+    float lo = 8 * t2 * t2 * s, hi = 1 - 8 * t1 * t1 * s;
+    float mid = 0.5f + 0.75f * xt_sinf(t * 12.566371f);
+    return xt_selectf(t < 0.45f, lo, xt_selectf(t < 0.55f, mid, hi));
+}
+
+static inline float ease_in_bounce_f(float t)
+{
+    return xt_exp2f(6 * (t - 1)) * fabsf(xt_sinf(t * 10.995574f));   // 3.5 pi
+}
+
+static inline float ease_out_bounce_f(float t)
+{
+    return 1 - xt_exp2f(-6 * t) * fabsf(xt_cosf(t * 10.995574f));
+}
+
+static inline float ease_inout_bounce_f(float t)
+{
+    float s = fabsf(xt_sinf(t * 21.991149f));       // 7 pi
+    return xt_selectf(t < 0.5f, 8 * xt_exp2f(8 * (t - 1)) * s, 1 - 8 * xt_exp2f(-8 * t) * s);
+}
+
+
+/*
+ * Batch forms
+ *
+ * <easing>_buf(in, out, n) applies <easing>_f to n samples, the buffers
+ * must not overlap. The loops have no calls or branches (piecewise
+ * easings blend both halves with xt_selectf), so gcc vectorizes all of
+ * them at -O3, given -fno-math-errno for sqrtf.
+ */
+
+static inline void clamp_buf(const float *XT_RESTRICT in, float *XT_RESTRICT out, int n,
+    float smallest, float largest)
+{
+    for (int i = 0; i < n; i++)
+        out[i] = clamp(in[i], smallest, largest);
+}
+
+// the scale is hoisted out of the loop, leaving one multiply-add per sample
+static inline void linear_scale_buf(const float *XT_RESTRICT in, float *XT_RESTRICT out, int n,
+    float from_min, float from_max, float to_min, float to_max)
+{
+    float scale = (to_max - to_min) / (from_max - from_min);
+    float offset = to_min - from_min * scale;
+    for (int i = 0; i < n; i++)
+        out[i] = in[i] * scale + offset;
+}
+
+#define XT_EASE_BUF(name) \
+    static inline void name##_buf(const float *XT_RESTRICT in, float *XT_RESTRICT out, int n) \
+    { \
+        for (int i = 0; i < n; i++) \
+            out[i] = name##_f(in[i]); \
+    }
+
+XT_EASE_BUF(ease_in_sine)
+XT_EASE_BUF(ease_out_sine)
+XT_EASE_BUF(ease_inout_sine)
+XT_EASE_BUF(ease_in_quad)
+XT_EASE_BUF(ease_out_quad)
+XT_EASE_BUF(ease_inout_quad)
+XT_EASE_BUF(ease_in_cubic)
+XT_EASE_BUF(ease_out_cubic)
+XT_EASE_BUF(ease_inout_cubic)
+XT_EASE_BUF(ease_in_quart)
+XT_EASE_BUF(ease_out_quart)
+XT_EASE_BUF(ease_inout_quart)
+XT_EASE_BUF(ease_in_quint)
+XT_EASE_BUF(ease_out_quint)
+XT_EASE_BUF(ease_inout_quint)
+XT_EASE_BUF(ease_in_expo)
+XT_EASE_BUF(ease_out_expo)
+XT_EASE_BUF(ease_inout_expo)
+XT_EASE_BUF(ease_in_circ)
+XT_EASE_BUF(ease_out_circ)
+XT_EASE_BUF(ease_inout_circ)
+XT_EASE_BUF(ease_in_back)
+XT_EASE_BUF(ease_out_back)
+XT_EASE_BUF(ease_inout_back)
+XT_EASE_BUF(ease_in_elastic)
+XT_EASE_BUF(ease_out_elastic)
+XT_EASE_BUF(ease_inout_elastic)
+XT_EASE_BUF(ease_in_bounce)
+XT_EASE_BUF(ease_out_bounce)
+XT_EASE_BUF(ease_inout_bounce)
+
+#endif /* XTGEN_COMMON_H */
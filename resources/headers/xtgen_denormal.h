@@ -0,0 +1,76 @@
+/* xtgen_denormal.h -- flush-to-zero guard of generated perform routines
+
+When the input of a feedback kernel (a reverb, a resonant filter) goes
+silent, its state decays into subnormal numbers, which x86 cpus process
+many times slower than normal ones. Generated dsp externals declared with
+`denormals: ftz` include this header and set the cpu's flush-to-zero mode
+(on x86 also denormals-are-zero) on entry to their perform routines, and
+restore the previous mode on exit, so neither the host nor other objects
+see a changed mode.
+
+The mode register is only written when the mode actually changes: many
+hosts already run their dsp with flush-to-zero set, and writing MXCSR or
+FPCR stalls the pipeline. Where the mode is not known the guard compiles
+to nothing.
+*/
+
+#ifndef XTGEN_DENORMAL_H
+#define XTGEN_DENORMAL_H
+
+#include <stdint.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define XT_FTZ_BITS 0x8040u     // MXCSR flush-to-zero (bit 15) and denormals-are-zero (bit 6)
+typedef unsigned int t_xt_fpmode;
+static inline t_xt_fpmode xt_fpmode_get(void) { return _mm_getcsr(); }
+static inline void xt_fpmode_set(t_xt_fpmode mode) { _mm_setcsr(mode); }
+#elif defined(__aarch64__)
+#define XT_FTZ_BITS (1ull << 24) // FPCR flush-to-zero
+typedef uint64_t t_xt_fpmode;
+static inline t_xt_fpmode xt_fpmode_get(void)
+{
+    uint64_t mode;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(mode));
+    return mode;
+}
+static inline void xt_fpmode_set(t_xt_fpmode mode) { __asm__ __volatile__("msr fpcr, %0" : : "r"(mode)); }
+#elif defined(_M_ARM64)
+#include <intrin.h>
+#define XT_FTZ_BITS (1ull << 24) // FPCR flush-to-zero
+typedef uint64_t t_xt_fpmode;
+static inline t_xt_fpmode xt_fpmode_get(void) { return (uint64_t)_ReadStatusReg(ARM64_FPCR); }
+static inline void xt_fpmode_set(t_xt_fpmode mode) { _WriteStatusReg(ARM64_FPCR, (__int64)mode); }
+#elif defined(__arm__) && defined(__ARM_FP)
+#define XT_FTZ_BITS (1u << 24)  // FPSCR flush-to-zero
+typedef uint32_t t_xt_fpmode;
+static inline t_xt_fpmode xt_fpmode_get(void)
+{
+    uint32_t mode;
+    __asm__ __volatile__("vmrs %0, fpscr" : "=r"(mode));
+    return mode;
+}
+static inline void xt_fpmode_set(t_xt_fpmode mode) { __asm__ __volatile__("vmsr fpscr, %0" : : "r"(mode)); }
+#else
+#define XT_FTZ_BITS 0u
+typedef unsigned int t_xt_fpmode;
+static inline t_xt_fpmode xt_fpmode_get(void) { return 0; }
+static inline void xt_fpmode_set(t_xt_fpmode mode) { (void)mode; }
+#endif
+
+// enter flush-to-zero mode, returns the mode to restore with xt_ftz_end()
+static inline t_xt_fpmode xt_ftz_begin(void)
+{
+    t_xt_fpmode mode = xt_fpmode_get();
+    if ((mode & XT_FTZ_BITS) != XT_FTZ_BITS)
+        xt_fpmode_set(mode | XT_FTZ_BITS);
+    return mode;
+}
+
+static inline void xt_ftz_end(t_xt_fpmode mode)
+{
+    if ((mode & XT_FTZ_BITS) != XT_FTZ_BITS)
+        xt_fpmode_set(mode);
+}
+
+#endif // XTGEN_DENORMAL_H
@@ -0,0 +1,90 @@
+/* xtgen_event.h -- timestamped param events of generated dsp externals
+
+Messages reach a dsp object between two of its blocks, so a param set by a
+message normally changes on a block boundary. Generated dsp externals
+declared with `events` instead push every param change as an event into a
+queue, stamped with the logical time of the message (clock_gettimesince()
+in pd, the scheduler time in Max), and the perform routine splits its block
+at the frames the events fall on and applies each one at its own sample.
+
+The queue holds XT_EVENT_QUEUE events (a power of two, 64 if undefined) in
+the object itself. It is a single-producer/single-consumer ring, with the
+counters and atomics of xtgen_ring.h: the message handlers push (serialized
+by a critical region in Max, where they run on the main and scheduler
+threads), the perform routine peeks and pops.
+*/
+
+#ifndef XTGEN_EVENT_H
+#define XTGEN_EVENT_H
+
+#include "xtgen_ring.h"
+
+#ifndef XT_EVENT_QUEUE
+#define XT_EVENT_QUEUE 64
+#endif
+
+typedef struct _xt_event {
+    double time;    // logical time of the message in ms
+    double value;   // new value of the param
+    int id;         // which param the event sets
+} t_xt_event;
+
+typedef struct _xt_events {
+    t_xt_atomic_u32 head;   // events ever pushed, written by the producer
+    char head_pad[XT_CACHE_LINE - sizeof(t_xt_atomic_u32)];
+    t_xt_atomic_u32 tail;   // events ever popped, written by the consumer
+    char tail_pad[XT_CACHE_LINE - sizeof(t_xt_atomic_u32)];
+    t_xt_event ev[XT_EVENT_QUEUE];
+} t_xt_events;
+
+// empty the queue, before either side uses it
+static inline void xt_events_init(t_xt_events *q)
+{
+    xt_store_release(&q->head, 0);
+    xt_store_release(&q->tail, 0);
+}
+
+// (producer) queue an event, returns 0 if the queue is full
+static inline int xt_events_push(t_xt_events *q, double time, int id, double value)
+{
+    uint32_t head = xt_load_relaxed(&q->head);
+    t_xt_event *ev;
+    if (head - xt_load_acquire(&q->tail) == XT_EVENT_QUEUE)
+        return 0;
+    ev = &q->ev[head & (XT_EVENT_QUEUE - 1)];
+    ev->time = time;
+    ev->value = value;
+    ev->id = id;
+    xt_store_release(&q->head, head + 1);   // publishes the event
+    return 1;
+}
+
+// (consumer) the oldest event, or 0 if the queue is empty
+static inline const t_xt_event *xt_events_peek(t_xt_events *q)
+{
+    uint32_t tail = xt_load_relaxed(&q->tail);
+    if (xt_load_acquire(&q->head) == tail)
+        return 0;
+    return &q->ev[tail & (XT_EVENT_QUEUE - 1)];
+}
+
+// (consumer) drop the oldest event, after xt_events_peek() returned it
+static inline void xt_events_pop(t_xt_events *q)
+{
+    xt_store_release(&q->tail, xt_load_relaxed(&q->tail) + 1);
+}
+
+/**
+ * frame of an event in a block of n samples which starts at logical time
+ * `start` (ms): the nearest one, clamped to [i, n - 1] so that late events
+ * are applied at once and events of an overdue block still land in this one
+ */
+static inline int xt_event_frame(const t_xt_event *ev, double start, double sr, int i, int n)
+{
+    double at = (ev->time - start) * sr * 0.001 + 0.5;
+    if (at <= i)
+        return i;
+    return (at < n - 1) ? (int)at : n - 1;
+}
+
+#endif // XTGEN_EVENT_H
@@ -0,0 +1,287 @@
+/* xtgen_fft.h -- real fft and short-time fourier transforms of generated externals
+
+Generated dsp externals declared with `spectral` include this header,
+after defining XT_SAMPLE as the sample type they process (t_sample in pd,
+double in Max, float if undefined).
+
+    t_xt_fft    a plan of in-place real transforms of `size` points (a
+                power of two): the twiddle factors and the bit-reversal
+                permutation, computed once by xt_fft_init()
+
+    t_xt_stft   a short-time fourier transform of one or more channels:
+                frames of `size` samples every `size / overlap` samples are
+                windowed, transformed, handed to the external as spectra,
+                transformed back and overlap-added to the output, with a
+                latency of `size` samples
+
+Spectra are packed in place: bins[0] and bins[1] are the (real) dc and
+nyquist bins, bins[2 k] and bins[2 k + 1] the real and imaginary parts of
+bin k, 0 < k < size / 2. xt_fft_inverse(xt_fft_forward(x)) is x.
+
+Neither allocates: the host allocates xt_stft_bytes() zeroed bytes
+(getbytes in pd, sysmem_newptrclear in Max) and hands them to
+xt_stft_init(), which records the allocation in `mem` and `nbytes` for the
+host to free. All buffers start on a cache line, so they are aligned for
+any simd width.
+*/
+
+#ifndef XTGEN_FFT_H
+#define XTGEN_FFT_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef XT_SAMPLE
+#define XT_SAMPLE float
+#endif
+
+#ifndef XT_CACHE_LINE
+#define XT_CACHE_LINE 64
+#endif
+
+// windows of the short-time transforms (periodic, so overlapped windows add up evenly)
+enum {
+    XT_WINDOW_RECT,
+    XT_WINDOW_HANN,
+    XT_WINDOW_SINE,     // square root of the hann window
+    XT_WINDOW_HAMMING,
+    XT_WINDOW_BLACKMAN,
+};
+
+
+/*
+ * real fft
+ * ---------------------------------------------------------------------------
+ */
+
+typedef struct _xt_fft {
+    uint32_t size;          // points of the real transform
+    XT_SAMPLE *twiddle;     // size / 2 complex factors exp(-2 pi i j / size)
+    uint32_t *bitrev;       // bit-reversal permutation of the size / 2 point complex transform
+} t_xt_fft;
+
+// bytes of the tables of a plan of `size` points, multiple of a cache line
+static inline size_t xt_fft_bytes(uint32_t size)
+{
+    size_t n = size * sizeof(XT_SAMPLE) + size / 2 * sizeof(uint32_t);
+    return (n + XT_CACHE_LINE - 1) & ~(size_t)(XT_CACHE_LINE - 1);
+}
+
+// compute the plan of `size` points (a power of two >= 4) in mem: xt_fft_bytes(size) bytes
+static inline void xt_fft_init(t_xt_fft *f, void *mem, uint32_t size)
+{
+    uint32_t m = size / 2, bits = 0, i;
+    f->size = size;
+    f->twiddle = (XT_SAMPLE *)mem;
+    f->bitrev = (uint32_t *)(f->twiddle + size);
+    for (i = 0; i < m; i++) {
+        f->twiddle[2 * i] = (XT_SAMPLE)cos(6.283185307179586 * i / size);
+        f->twiddle[2 * i + 1] = (XT_SAMPLE)-sin(6.283185307179586 * i / size);
+    }
+    while ((1u << bits) < m)
+        bits++;
+    for (i = 0; i < m; i++) {
+        uint32_t r = 0, b;
+        for (b = 0; b < bits; b++)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        f->bitrev[i] = r;
+    }
+}
+
+// in-place complex transform of size / 2 interleaved points (unscaled, sign -1 or +1)
+static inline void xt_fft_complex(const t_xt_fft *f, XT_SAMPLE *z, int inverse)
+{
+    uint32_t m = f->size / 2, i, k, len;
+    for (i = 0; i < m; i++) {
+        uint32_t j = f->bitrev[i];
+        if (j > i) {
+            XT_SAMPLE re = z[2 * i], im = z[2 * i + 1];
+            z[2 * i] = z[2 * j];
+            z[2 * i + 1] = z[2 * j + 1];
+            z[2 * j] = re;
+            z[2 * j + 1] = im;
+        }
+    }
+    for (len = 2; len <= m; len <<= 1) {
+        uint32_t half = len / 2, stride = f->size / len;
+        for (k = 0; k < half; k++) {
+            XT_SAMPLE wr = f->twiddle[2 * k * stride];
+            XT_SAMPLE wi = inverse ? -f->twiddle[2 * k * stride + 1] : f->twiddle[2 * k * stride + 1];
+            for (i = k; i < m; i += len) {
+                XT_SAMPLE *a = z + 2 * i, *b = z + 2 * (i + half);
+                XT_SAMPLE tr = wr * b[0] - wi * b[1], ti = wr * b[1] + wi * b[0];
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+/**
+ * in-place transform of `size` real samples into a packed spectrum
+ *
+ * the samples are transformed as size / 2 complex points, whose spectrum
+ * is split into the spectra of the even and odd samples and recombined.
+ */
+static inline void xt_fft_forward(const t_xt_fft *f, XT_SAMPLE *x)
+{
+    uint32_t m = f->size / 2, k;
+    XT_SAMPLE dc;
+    xt_fft_complex(f, x, 0);
+    dc = x[0];
+    x[0] = dc + x[1];
+    x[1] = dc - x[1];
+    for (k = 1; k <= m / 2; k++) {
+        XT_SAMPLE *a = x + 2 * k, *b = x + 2 * (m - k);
+        XT_SAMPLE er = (XT_SAMPLE)0.5 * (a[0] + b[0]), ei = (XT_SAMPLE)0.5 * (a[1] - b[1]);
+        XT_SAMPLE or_ = (XT_SAMPLE)0.5 * (a[1] + b[1]), oi = (XT_SAMPLE)-0.5 * (a[0] - b[0]);
+        XT_SAMPLE wr = f->twiddle[2 * k], wi = f->twiddle[2 * k + 1];
+        XT_SAMPLE tr = wr * or_ - wi * oi, ti = wr * oi + wi * or_;
+        a[0] = er + tr;
+        a[1] = ei + ti;
+        b[0] = er - tr;     // bin m - k is the conjugate recombination
+        b[1] = ti - ei;
+    }
+}
+
+// in-place transform of a packed spectrum back into `size` real samples (scaled by 1 / size)
+static inline void xt_fft_inverse(const t_xt_fft *f, XT_SAMPLE *x)
+{
+    uint32_t m = f->size / 2, k;
+    XT_SAMPLE scale = (XT_SAMPLE)1 / f->size, dc = x[0];
+    x[0] = scale * (dc + x[1]);
+    x[1] = scale * (dc - x[1]);
+    for (k = 1; k <= m / 2; k++) {
+        XT_SAMPLE *a = x + 2 * k, *b = x + 2 * (m - k);
+        XT_SAMPLE er = a[0] + b[0], ei = a[1] - b[1];
+        XT_SAMPLE dr = a[0] - b[0], di = a[1] + b[1];
+        XT_SAMPLE wr = f->twiddle[2 * k], wi = -f->twiddle[2 * k + 1];
+        XT_SAMPLE or_ = wr * dr - wi * di, oi = wr * di + wi * dr;
+        a[0] = scale * (er - oi);
+        a[1] = scale * (ei + or_);
+        b[0] = scale * (er + oi);
+        b[1] = scale * (or_ - ei);
+    }
+    xt_fft_complex(f, x, 1);
+}
+
+
+/*
+ * short-time fourier transform
+ * ---------------------------------------------------------------------------
+ */
+
+typedef struct _xt_stft {
+    t_xt_fft fft;
+    uint32_t size;          // samples of a frame
+    uint32_t hop;           // samples between frames: size / overlap
+    uint32_t fill;          // samples of the next hop written so far
+    int nchans;
+    XT_SAMPLE gain;         // overlap-add gain of the windows
+    XT_SAMPLE *window;      // size samples
+    XT_SAMPLE *frame;       // size samples: the spectrum handed to the external
+    XT_SAMPLE *in;          // nchans * size samples: the last input frame of each channel
+    XT_SAMPLE *out;         // nchans * size samples: the overlap-added output of each channel
+    void *mem;              // allocation of the buffers, nbytes long (0 before init)
+    size_t nbytes;
+} t_xt_stft;
+
+// bytes to allocate for a transform of `nchans` channels of frames of `size` samples
+static inline size_t xt_stft_bytes(uint32_t size, int nchans)
+{
+    return (2 + 2 * (size_t)nchans) * size * sizeof(XT_SAMPLE) + xt_fft_bytes(size) + XT_CACHE_LINE - 1;
+}
+
+/**
+ * set s up in mem: xt_stft_bytes(size, nchans) zeroed bytes, with `size`
+ * a power of two >= 16 and `overlap` a power of two <= size
+ */
+static inline void xt_stft_init(t_xt_stft *s, void *mem, uint32_t size, uint32_t overlap, int nchans, int window)
+{
+    XT_SAMPLE *buf = (XT_SAMPLE *)(((uintptr_t)mem + XT_CACHE_LINE - 1) & ~(uintptr_t)(XT_CACHE_LINE - 1));
+    double sum = 0;
+    uint32_t j;
+    s->size = size;
+    s->hop = size / overlap;
+    s->fill = 0;
+    s->nchans = nchans;
+    s->window = buf;
+    s->frame = buf + size;
+    s->in = buf + 2 * size;
+    s->out = s->in + (size_t)nchans * size;
+    xt_fft_init(&s->fft, s->out + (size_t)nchans * size, size);
+    for (j = 0; j < size; j++) {
+        double p = 6.283185307179586 * j / size, w;
+        switch (window) {
+        case XT_WINDOW_HANN: w = 0.5 - 0.5 * cos(p); break;
+        case XT_WINDOW_SINE: w = sin(0.5 * p); break;
+        case XT_WINDOW_HAMMING: w = 0.54 - 0.46 * cos(p); break;
+        case XT_WINDOW_BLACKMAN: w = 0.42 - 0.5 * cos(p) + 0.08 * cos(2 * p); break;
+        default: w = 1; break;
+        }
+        s->window[j] = (XT_SAMPLE)w;
+        sum += w * w;
+    }
+    // analysis and synthesis windows overlap-add to sum / hop
+    s->gain = (XT_SAMPLE)(s->hop / sum);
+    s->mem = mem;
+    s->nbytes = xt_stft_bytes(size, nchans);
+}
+
+// samples of the n left in the block which can be processed before the next frame is due
+static inline uint32_t xt_stft_span(const t_xt_stft *s, uint32_t n)
+{
+    return (n < s->hop - s->fill) ? n : s->hop - s->fill;
+}
+
+// append m <= xt_stft_span() input samples of channel c to its frame
+static inline void xt_stft_write(t_xt_stft *s, int c, const XT_SAMPLE *in, uint32_t m)
+{
+    memcpy(s->in + (size_t)c * s->size + s->size - s->hop + s->fill, in, m * sizeof(XT_SAMPLE));
+}
+
+// read m output samples of channel c, after the inputs of all channels were written
+static inline void xt_stft_read(const t_xt_stft *s, int c, XT_SAMPLE *out, uint32_t m)
+{
+    memcpy(out, s->out + (size_t)c * s->size + s->fill, m * sizeof(XT_SAMPLE));
+}
+
+// count m processed samples, returns 1 if a frame is due: analyze and synthesize all channels
+static inline int xt_stft_advance(t_xt_stft *s, uint32_t m)
+{
+    s->fill += m;
+    if (s->fill < s->hop)
+        return 0;
+    s->fill = 0;
+    return 1;
+}
+
+// window and transform the last frame of channel c, returns its spectrum
+static inline XT_SAMPLE *xt_stft_analyze(t_xt_stft *s, int c)
+{
+    const XT_SAMPLE *in = s->in + (size_t)c * s->size;
+    uint32_t j;
+    for (j = 0; j < s->size; j++)
+        s->frame[j] = in[j] * s->window[j];
+    xt_fft_forward(&s->fft, s->frame);
+    return s->frame;
+}
+
+// transform the spectrum back, window and overlap-add it to the output of channel c
+static inline void xt_stft_synthesize(t_xt_stft *s, int c)
+{
+    XT_SAMPLE *in = s->in + (size_t)c * s->size, *out = s->out + (size_t)c * s->size;
+    uint32_t j, keep = s->size - s->hop;
+    xt_fft_inverse(&s->fft, s->frame);
+    memmove(in, in + s->hop, keep * sizeof(XT_SAMPLE));
+    memmove(out, out + s->hop, keep * sizeof(XT_SAMPLE));
+    memset(out + keep, 0, s->hop * sizeof(XT_SAMPLE));
+    for (j = 0; j < s->size; j++)
+        out[j] += s->frame[j] * s->window[j] * s->gain;
+}
+
+#endif // XTGEN_FFT_H
@@ -0,0 +1,99 @@
+/* xtgen_profile.h -- dsp-load instrumentation of generated externals
+
+Generated dsp externals include this header, and time each call of their
+perform routine, only when they are compiled with -DXT_PROFILE, so release
+builds carry no trace of it. The `stats` method posts the collected stats
+to the console and starts over.
+
+Time is measured in cpu cycles (rdtsc) where available, else in ns.
+*/
+
+#ifndef XTGEN_PROFILE_H
+#define XTGEN_PROFILE_H
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define XT_PROFILE_UNIT "cycles"
+#elif defined(_WIN32)
+#include <windows.h>
+#define XT_PROFILE_UNIT "ticks"
+#else
+#include <time.h>
+#define XT_PROFILE_UNIT "ns"
+#endif
+
+#define XT_PROFILE_BINS 32
+
+typedef struct _xt_profile {
+    uint64_t blocks;                    // perform calls
+    uint64_t total;                     // sum of their durations
+    uint64_t max;                       // longest duration
+    uint64_t hist[XT_PROFILE_BINS];     // hist[b]: durations in [2^b, 2^(b+1))
+} t_xt_profile;
+
+static inline uint64_t xt_profile_now(void)
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    return (uint64_t)__rdtsc();
+#elif defined(_WIN32)
+    LARGE_INTEGER c;
+    QueryPerformanceCounter(&c);
+    return (uint64_t)c.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static inline void xt_profile_add(t_xt_profile *p, uint64_t t)
+{
+    int b = 0;
+    while (b < XT_PROFILE_BINS - 1 && (t >> (b + 1)))
+        b++;
+    p->blocks++;
+    p->total += t;
+    if (t > p->max)
+        p->max = t;
+    p->hist[b]++;
+}
+
+static inline void xt_profile_reset(t_xt_profile *p)
+{
+    int b;
+    p->blocks = p->total = p->max = 0;
+    for (b = 0; b < XT_PROFILE_BINS; b++)
+        p->hist[b] = 0;
+}
+
+/**
+ * post the stats of `p` through the host's post() and reset them
+ *
+ * one summary line followed by a line per non-empty histogram bin
+ */
+static void xt_profile_post(t_xt_profile *p, const char *name,
+    void (*print)(const char *fmt, ...))
+{
+    int b;
+    print("%s: %llu blocks, mean %.1f, max %llu " XT_PROFILE_UNIT " per block",
+        name, (unsigned long long)p->blocks,
+        p->blocks ? (double)p->total / (double)p->blocks : 0.0,
+        (unsigned long long)p->max);
+    for (b = 0; b < XT_PROFILE_BINS; b++) {
+        if (p->hist[b])
+            print("%s:   >= %llu: %llu", name, 1ULL << b,
+                (unsigned long long)p->hist[b]);
+    }
+    xt_profile_reset(p);
+}
+
+#define XT_PROFILE_BEGIN() uint64_t xt_profile_t0 = xt_profile_now()
+#define XT_PROFILE_END(p) xt_profile_add((p), xt_profile_now() - xt_profile_t0)
+
+#endif /* XTGEN_PROFILE_H */
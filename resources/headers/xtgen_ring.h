@@ -0,0 +1,241 @@
+/* xtgen_ring.h -- delay lines and lock-free ring buffers for generated externals
+
+Generated dsp externals include this header when they have `delay` params
+or `from_dsp` outlets, after defining XT_SAMPLE as the sample type they process (t_sample in pd,
+double in Max, float if undefined).
+
+Both structures keep their memory in a power-of-two buffer which starts on
+a cache line, so indices wrap with a mask instead of a modulo or a branch.
+Neither allocates: the host allocates xt_*_bytes() zeroed bytes (getbytes
+in pd, sysmem_newptrclear in Max) and hands them to xt_*_init(), which
+records the allocation in `mem` and `nbytes` for the host to free.
+
+    t_xt_delay  a delay line of samples with integer, linear and cubic
+                (4-point hermite) read taps
+
+    t_xt_ring   a single-producer/single-consumer ring buffer of bytes:
+                one thread writes and another reads without locks, e.g.
+                to get data out of the audio thread
+*/
+
+#ifndef XTGEN_RING_H
+#define XTGEN_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef XT_SAMPLE
+#define XT_SAMPLE float
+#endif
+
+#define XT_CACHE_LINE 64
+
+/* atomic counters of the ring buffer: std::atomic in C++ (Max externals),
+ * C11 atomics in C (pd externals). MSVC's C compiler lacks <stdatomic.h>,
+ * but gives volatile accesses acquire/release semantics (/volatile:ms).
+ * xt_exchange() stores v and returns the previous value (acquire/release),
+ * e.g. for a flag both threads set and clear. */
+#if defined(__cplusplus)
+#include <atomic>
+typedef std::atomic<uint32_t> t_xt_atomic_u32;
+#define xt_load_acquire(a) ((a)->load(std::memory_order_acquire))
+#define xt_load_relaxed(a) ((a)->load(std::memory_order_relaxed))
+#define xt_store_release(a, v) ((a)->store((v), std::memory_order_release))
+#define xt_exchange(a, v) ((a)->exchange((v), std::memory_order_acq_rel))
+#elif defined(_MSC_VER) && !defined(__clang__)
+typedef volatile uint32_t t_xt_atomic_u32;
+#define xt_load_acquire(a) (*(a))
+#define xt_load_relaxed(a) (*(a))
+#define xt_store_release(a, v) (*(a) = (v))
+#include <intrin.h>
+#define xt_exchange(a, v) ((uint32_t)_InterlockedExchange((volatile long *)(a), (long)(v)))
+#else
+#include <stdatomic.h>
+typedef _Atomic uint32_t t_xt_atomic_u32;
+#define xt_load_acquire(a) atomic_load_explicit((a), memory_order_acquire)
+#define xt_load_relaxed(a) atomic_load_explicit((a), memory_order_relaxed)
+#define xt_store_release(a, v) atomic_store_explicit((a), (v), memory_order_release)
+#define xt_exchange(a, v) atomic_exchange_explicit((a), (v), memory_order_acq_rel)
+#endif
+
+// smallest power of two >= n (n <= 2^31)
+static inline uint32_t xt_pow2(uint32_t n)
+{
+    uint32_t size = 1;
+    while (size < n)
+        size <<= 1;
+    return size;
+}
+
+// first cache line boundary in mem
+static inline void *xt_align(void *mem)
+{
+    return (void *)(((uintptr_t)mem + XT_CACHE_LINE - 1) & ~(uintptr_t)(XT_CACHE_LINE - 1));
+}
+
+
+/*
+ * delay line
+ * ---------------------------------------------------------------------------
+ */
+
+typedef struct _xt_delay {
+    XT_SAMPLE *buf;     // mask + 1 samples, on a cache line boundary
+    uint32_t mask;
+    uint32_t pos;       // index of the last written sample
+    void *mem;          // allocation of buf, nbytes long (0 before init)
+    size_t nbytes;
+} t_xt_delay;
+
+/**
+ * bytes to allocate for a delay line of up to max_delay samples
+ *
+ * the buffer holds max_delay + 3 samples (the current one and the two
+ * guard points of a cubic tap at max_delay) rounded up to a power of two.
+ */
+static inline size_t xt_delay_bytes(uint32_t max_delay)
+{
+    return xt_pow2(max_delay + 3) * sizeof(XT_SAMPLE) + XT_CACHE_LINE - 1;
+}
+
+// set d up in mem: xt_delay_bytes(max_delay) zeroed bytes
+static inline void xt_delay_init(t_xt_delay *d, void *mem, uint32_t max_delay)
+{
+    d->buf = (XT_SAMPLE *)xt_align(mem);
+    d->mask = xt_pow2(max_delay + 3) - 1;
+    d->pos = 0;
+    d->mem = mem;
+    d->nbytes = xt_delay_bytes(max_delay);
+}
+
+static inline void xt_delay_clear(t_xt_delay *d)
+{
+    memset(d->buf, 0, (d->mask + 1) * sizeof(XT_SAMPLE));
+}
+
+static inline void xt_delay_write(t_xt_delay *d, XT_SAMPLE x)
+{
+    d->pos = (d->pos + 1) & d->mask;
+    d->buf[d->pos] = x;
+}
+
+/**
+ * the sample written `delay` samples ago (0: the last written sample)
+ *
+ * taps never read outside of the buffer, a delay past max_delay reads
+ * wrapped (stale) samples.
+ */
+static inline XT_SAMPLE xt_delay_read(const t_xt_delay *d, uint32_t delay)
+{
+    return d->buf[(d->pos - delay) & d->mask];
+}
+
+// linearly interpolated tap at a fractional delay >= 0
+static inline XT_SAMPLE xt_delay_read_linear(const t_xt_delay *d, XT_SAMPLE delay)
+{
+    uint32_t i = (uint32_t)delay;
+    XT_SAMPLE f = delay - (XT_SAMPLE)i;
+    XT_SAMPLE a = xt_delay_read(d, i), b = xt_delay_read(d, i + 1);
+    return a + f * (b - a);
+}
+
+// 4-point hermite interpolated tap at a fractional delay >= 1
+static inline XT_SAMPLE xt_delay_read_cubic(const t_xt_delay *d, XT_SAMPLE delay)
+{
+    uint32_t i = (uint32_t)delay;
+    XT_SAMPLE f = delay - (XT_SAMPLE)i;
+    XT_SAMPLE y0 = xt_delay_read(d, i - 1), y1 = xt_delay_read(d, i);
+    XT_SAMPLE y2 = xt_delay_read(d, i + 1), y3 = xt_delay_read(d, i + 2);
+    XT_SAMPLE c1 = (XT_SAMPLE)0.5 * (y2 - y0);
+    XT_SAMPLE c2 = y0 - (XT_SAMPLE)2.5 * y1 + 2 * y2 - (XT_SAMPLE)0.5 * y3;
+    XT_SAMPLE c3 = (XT_SAMPLE)0.5 * (y3 - y0) + (XT_SAMPLE)1.5 * (y1 - y2);
+    return ((c3 * f + c2) * f + c1) * f + y1;
+}
+
+
+/*
+ * single-producer/single-consumer ring buffer
+ * ---------------------------------------------------------------------------
+ */
+
+/**
+ * head and tail count the bytes ever written and read (modulo 2^32), so
+ * the whole buffer can be used and head - tail is the fill level. Each
+ * counter is written by one side only and sits on its own cache line, so
+ * the audio thread does not share a line with the reader.
+ */
+typedef struct _xt_ring {
+    t_xt_atomic_u32 head;   // written by the producer
+    char head_pad[XT_CACHE_LINE - sizeof(t_xt_atomic_u32)];
+    t_xt_atomic_u32 tail;   // written by the consumer
+    char tail_pad[XT_CACHE_LINE - sizeof(t_xt_atomic_u32)];
+    unsigned char *buf;     // mask + 1 bytes, on a cache line boundary
+    uint32_t mask;
+    void *mem;              // allocation of buf, nbytes long (0 before init)
+    size_t nbytes;
+} t_xt_ring;
+
+// bytes to allocate for a ring buffer of at least `capacity` bytes
+static inline size_t xt_ring_bytes(uint32_t capacity)
+{
+    return xt_pow2(capacity) + XT_CACHE_LINE - 1;
+}
+
+// set r up in mem: xt_ring_bytes(capacity) bytes, before either side uses it
+static inline void xt_ring_init(t_xt_ring *r, void *mem, uint32_t capacity)
+{
+    r->buf = (unsigned char *)xt_align(mem);
+    r->mask = xt_pow2(capacity) - 1;
+    r->mem = mem;
+    r->nbytes = xt_ring_bytes(capacity);
+    xt_store_release(&r->head, 0);
+    xt_store_release(&r->tail, 0);
+}
+
+// (producer) bytes which can be written now
+static inline uint32_t xt_ring_write_space(t_xt_ring *r)
+{
+    return r->mask + 1 - (xt_load_relaxed(&r->head) - xt_load_acquire(&r->tail));
+}
+
+// (consumer) bytes which can be read now
+static inline uint32_t xt_ring_read_space(t_xt_ring *r)
+{
+    return xt_load_acquire(&r->head) - xt_load_relaxed(&r->tail);
+}
+
+/**
+ * (producer) write up to n bytes of src, returns the number written
+ *
+ * the space only grows until the next write, so a producer which checked
+ * xt_ring_write_space() writes whole records.
+ */
+static inline uint32_t xt_ring_write(t_xt_ring *r, const void *src, uint32_t n)
+{
+    uint32_t head = xt_load_relaxed(&r->head), space = xt_ring_write_space(r);
+    uint32_t i = head & r->mask, first;
+    if (n > space)
+        n = space;
+    first = (n < r->mask + 1 - i) ? n : r->mask + 1 - i;
+    memcpy(r->buf + i, src, first);
+    memcpy(r->buf, (const unsigned char *)src + first, n - first);
+    xt_store_release(&r->head, head + n);   // publishes the bytes
+    return n;
+}
+
+// (consumer) read up to n bytes into dst, returns the number read
+static inline uint32_t xt_ring_read(t_xt_ring *r, void *dst, uint32_t n)
+{
+    uint32_t tail = xt_load_relaxed(&r->tail), avail = xt_ring_read_space(r);
+    uint32_t i = tail & r->mask, first;
+    if (n > avail)
+        n = avail;
+    first = (n < r->mask + 1 - i) ? n : r->mask + 1 - i;
+    memcpy(dst, r->buf + i, first);
+    memcpy((unsigned char *)dst + first, r->buf, n - first);
+    xt_store_release(&r->tail, tail + n);   // hands the space back
+    return n;
+}
+
+#endif // XTGEN_RING_H
@@ -0,0 +1,126 @@
+/* xtgen_table.h -- lookup tables for generated oscillators and shapers
+
+Generated dsp externals include this header when they have `tables`,
+after defining XT_SAMPLE as the sample type they process (t_sample in pd,
+double in Max, float if undefined).
+
+A table holds one period of a waveform (or a transfer curve) sampled at
+`size` points, with guard points before and after it (data[-1] is
+data[size - 1], data[size] and data[size + 1] are data[0] and data[1]), so
+interpolated reads at any phase in [0, 1) never wrap or branch. It does not
+allocate: the host allocates xt_table_bytes() zeroed bytes (getbytes in
+pd, sysmem_newptrclear in Max) and hands them to xt_table_init(), which
+records the allocation in `mem` and `nbytes` for the host to free. The
+generated externals share one table per class between all instances.
+*/
+
+#ifndef XTGEN_TABLE_H
+#define XTGEN_TABLE_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef XT_SAMPLE
+#define XT_SAMPLE float
+#endif
+
+#ifndef XT_CACHE_LINE
+#define XT_CACHE_LINE 64
+#endif
+
+// samples before data: the leading guard point, padded so data starts on a cache line
+#define XT_TABLE_LEAD (XT_CACHE_LINE / sizeof(XT_SAMPLE))
+
+typedef struct _xt_table {
+    XT_SAMPLE *data;    // size samples, framed by guard points
+    uint32_t size;
+    void *mem;          // allocation of data, nbytes long (0 before init)
+    size_t nbytes;
+} t_xt_table;
+
+// bytes to allocate for a table of `size` points
+static inline size_t xt_table_bytes(uint32_t size)
+{
+    return (XT_TABLE_LEAD + size + 2) * sizeof(XT_SAMPLE) + XT_CACHE_LINE - 1;
+}
+
+// set t up in mem: xt_table_bytes(size) zeroed bytes
+static inline void xt_table_init(t_xt_table *t, void *mem, uint32_t size)
+{
+    uintptr_t line = ((uintptr_t)mem + XT_CACHE_LINE - 1) & ~(uintptr_t)(XT_CACHE_LINE - 1);
+    t->data = (XT_SAMPLE *)line + XT_TABLE_LEAD;
+    t->size = size;
+    t->mem = mem;
+    t->nbytes = xt_table_bytes(size);
+}
+
+// copy the wrapped points into the guard points, after the table has been filled
+static inline void xt_table_guard(t_xt_table *t)
+{
+    t->data[-1] = t->data[t->size - 1];
+    t->data[t->size] = t->data[0];
+    t->data[t->size + 1] = t->data[1];
+}
+
+// one period of sin(2 pi p)
+static inline void xt_table_fill_sine(t_xt_table *t)
+{
+    for (uint32_t i = 0; i < t->size; i++)
+        t->data[i] = (XT_SAMPLE)sin(6.283185307179586 * i / t->size);
+    xt_table_guard(t);
+}
+
+/**
+ * one period of a bandlimited sawtooth of `harmonics` partials, rising
+ * from -1 to 1 through 0 at p = 0 like the sine
+ *
+ * the partials sin(k x) are summed by the recurrence
+ * sin(k x) = 2 cos(x) sin((k - 1) x) - sin((k - 2) x), one sin() per point.
+ */
+static inline void xt_table_fill_saw(t_xt_table *t, int harmonics)
+{
+    for (uint32_t i = 0; i < t->size; i++) {
+        double x = 6.283185307179586 * i / t->size, c = 2 * cos(x);
+        double s = sin(x), s_prev = 0, sum = 0;     // sin(k x), sin((k - 1) x)
+        for (int k = 1; k <= harmonics; k++) {
+            double s_next = c * s - s_prev;
+            sum += ((k & 1) ? s : -s) / k;
+            s_prev = s;
+            s = s_next;
+        }
+        t->data[i] = (XT_SAMPLE)(sum * 0.6366197723675814);    // 2 / pi
+    }
+    xt_table_guard(t);
+}
+
+// table point below phase p in [0, 1)
+static inline XT_SAMPLE xt_table_read(const t_xt_table *t, XT_SAMPLE p)
+{
+    return t->data[(uint32_t)(p * t->size)];
+}
+
+// linearly interpolated read at phase p in [0, 1)
+static inline XT_SAMPLE xt_table_read_linear(const t_xt_table *t, XT_SAMPLE p)
+{
+    XT_SAMPLE x = p * t->size;
+    uint32_t i = (uint32_t)x;
+    XT_SAMPLE f = x - (XT_SAMPLE)i;
+    XT_SAMPLE a = t->data[i], b = t->data[i + 1];
+    return a + f * (b - a);
+}
+
+// 4-point hermite interpolated read at phase p in [0, 1)
+static inline XT_SAMPLE xt_table_read_cubic(const t_xt_table *t, XT_SAMPLE p)
+{
+    XT_SAMPLE x = p * t->size;
+    uint32_t i = (uint32_t)x;
+    XT_SAMPLE f = x - (XT_SAMPLE)i;
+    const XT_SAMPLE *y = t->data + i;
+    XT_SAMPLE c1 = (XT_SAMPLE)0.5 * (y[1] - y[-1]);
+    XT_SAMPLE c2 = y[-1] - (XT_SAMPLE)2.5 * y[0] + 2 * y[1] - (XT_SAMPLE)0.5 * y[2];
+    XT_SAMPLE c3 = (XT_SAMPLE)0.5 * (y[2] - y[-1]) + (XT_SAMPLE)1.5 * (y[0] - y[1]);
+    return ((c3 * f + c2) * f + c1) * f + y[0];
+}
+
+#endif // XTGEN_TABLE_H
@@ -0,0 +1,148 @@
+/* xtgen_thread.h -- worker threads of generated dsp externals
+
+Generated pd dsp externals declared with `threaded: true` run their dsp on
+a worker thread of their own, one block behind the dsp thread: the perform
+routine hands each input block to the worker and outputs the block the
+worker computed from the previous one. This header wraps the few thread
+primitives they need (native threads and semaphores on Windows, pthreads
+and dispatch semaphores on macOS, pthreads and POSIX semaphores elsewhere);
+the handoff itself uses the atomics of xtgen_ring.h.
+
+Posting a semaphore does not block, so the dsp thread can wake the worker
+without taking a lock. Waiting for the worker is a spin which backs off to
+yielding the cpu: it only spins when the worker takes longer than the rest
+of the dsp chain.
+
+A worker thread function is declared with XT_THREAD_FN(name, arg) and
+returns 0.
+*/
+
+#ifndef XTGEN_THREAD_H
+#define XTGEN_THREAD_H
+
+#include "xtgen_ring.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+typedef HANDLE t_xt_thread;
+typedef HANDLE t_xt_sem;
+#define XT_THREAD_FN(name, arg) DWORD WINAPI name(LPVOID arg)
+typedef DWORD (WINAPI *t_xt_thread_fn)(LPVOID);
+#elif defined(__APPLE__)
+#include <pthread.h>
+#include <sched.h>
+#include <dispatch/dispatch.h>
+typedef pthread_t t_xt_thread;
+typedef dispatch_semaphore_t t_xt_sem;
+#define XT_THREAD_FN(name, arg) void *name(void *arg)
+typedef void *(*t_xt_thread_fn)(void *);
+#else
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+typedef pthread_t t_xt_thread;
+typedef sem_t t_xt_sem;
+#define XT_THREAD_FN(name, arg) void *name(void *arg)
+typedef void *(*t_xt_thread_fn)(void *);
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#define xt_cpu_relax() _mm_pause()
+#elif defined(__aarch64__) || (defined(__arm__) && __ARM_ARCH >= 7)
+#define xt_cpu_relax() __asm__ __volatile__("yield")
+#else
+#define xt_cpu_relax()
+#endif
+
+// start a thread running fn(arg) at the priority of the calling thread, returns 0 on success
+static inline int xt_thread_start(t_xt_thread *t, t_xt_thread_fn fn, void *arg)
+{
+#if defined(_WIN32)
+    *t = CreateThread(0, 0, fn, arg, 0, 0);
+    if (!*t)
+        return -1;
+    SetThreadPriority(*t, GetThreadPriority(GetCurrentThread()));
+    return 0;
+#else
+    pthread_attr_t attr;
+    int err;
+    pthread_attr_init(&attr);
+    pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+    err = pthread_create(t, &attr, fn, arg);
+    pthread_attr_destroy(&attr);
+    return err;
+#endif
+}
+
+static inline void xt_thread_join(t_xt_thread t)
+{
+#if defined(_WIN32)
+    WaitForSingleObject(t, INFINITE);
+    CloseHandle(t);
+#else
+    pthread_join(t, 0);
+#endif
+}
+
+static inline void xt_sem_init(t_xt_sem *s)
+{
+#if defined(_WIN32)
+    *s = CreateSemaphore(0, 0, 0x7fffffff, 0);
+#elif defined(__APPLE__)
+    *s = dispatch_semaphore_create(0);
+#else
+    sem_init(s, 0, 0);
+#endif
+}
+
+static inline void xt_sem_destroy(t_xt_sem *s)
+{
+#if defined(_WIN32)
+    CloseHandle(*s);
+#elif defined(__APPLE__)
+    dispatch_release(*s);
+#else
+    sem_destroy(s);
+#endif
+}
+
+static inline void xt_sem_post(t_xt_sem *s)
+{
+#if defined(_WIN32)
+    ReleaseSemaphore(*s, 1, 0);
+#elif defined(__APPLE__)
+    dispatch_semaphore_signal(*s);
+#else
+    sem_post(s);
+#endif
+}
+
+static inline void xt_sem_wait(t_xt_sem *s)
+{
+#if defined(_WIN32)
+    WaitForSingleObject(*s, INFINITE);
+#elif defined(__APPLE__)
+    dispatch_semaphore_wait(*s, DISPATCH_TIME_FOREVER);
+#else
+    while (sem_wait(s) && errno == EINTR)
+        ;
+#endif
+}
+
+// one round of waiting: spin for a while, then yield the cpu
+static inline void xt_backoff(unsigned *spins)
+{
+    if (++*spins < 256) {
+        xt_cpu_relax();
+    } else {
+#if defined(_WIN32)
+        SwitchToThread();
+#else
+        sched_yield();
+#endif
+    }
+}
+
+#endif // XTGEN_THREAD_H
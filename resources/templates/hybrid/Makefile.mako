@@ -0,0 +1,19 @@
+# Makefile for ${e.name}~ (pd wrapper of the hybrid kernel)
+
+lib.name = ${e.name}~
+
+class.sources = ${e.name}~.cpp
+
+datafiles = ../README.md
+
+cflags = -I..
+
+suppress-wunused = true
+
+% if e.signal_params:
+# the signal inlets include pd's m_imp.h and g_canvas.h, which xtgen does not
+# bundle (only m_pd.h): PDINCLUDEDIR must point at the headers of a full pd,
+# the src/ of a pd source tree or the include/pd of an installed pd
+# (pd-lib-builder's default)
+% endif
+include Makefile.pdlibbuilder
@@ -0,0 +1,223 @@
+/* ${e.name}_kernel.hpp
+
+${e.meta['desc']}
+Header-only dsp kernel of ${e.name}~, shared by the pd and max wrappers.
+
+The kernel is templated on the sample type (t_sample in pd, double in max)
+and owns the params, their derived coefficients and ramps, and the process
+loop. Both wrappers embed it by value and call process() from their perform
+routine, so the whole loop is visible to (and inlined by) the compiler in
+each host.
+
+Author: ${e.meta['author']}
+Repo: ${e.meta['repo']}
+
+*/
+
+#ifndef ${e.name.upper()}_KERNEL_HPP
+#define ${e.name.upper()}_KERNEL_HPP
+
+#include <math.h>
+<%
+    # the features of a spec the kernel lacks are rejected by HybridProject
+    nch = e.n_channels
+    ins = ", ".join(f"const T *in{c}" for c in range(nch))
+    outs = ", ".join(f"T *out{c}" for c in range(nch))
+%>
+
+/**
+ * compile-time params (`const: true` in the spec) of ${e.name}_kernel
+ *
+ * pass a struct with the same members as the second template argument of
+ * the kernel to build a variant with other values: they are constexpr in
+ * the process loop, so the compiler can fold them.
+ */
+template <typename T>
+struct ${e.name}_consts {
+    % for p in e.const_params:
+    static constexpr ${p.kernel_type} ${p.name} = ${p.initial};    // ${p.desc}
+    % endfor
+};
+
+/**
+ * dsp kernel of ${e.name}~, specialized at compile time on the sample type T
+ * (float or double, following PD_FLOATSIZE in pd, double in max), so
+ * there are no runtime branches on, or conversions of, the sample width.
+ */
+template <typename T, typename C = ${e.name}_consts<T> >
+struct ${e.name}_kernel {
+    enum { n_channels = ${nch} };
+    % if e.recomputed_params:
+
+    /* dirty flags of params whose derived coefficients are stale */
+    enum {
+        % for i, p in enumerate(e.recomputed_params):
+        ${p.dirty_flag} = 1UL << ${i},
+        % endfor
+        DIRTY_ALL = (1UL << ${len(e.recomputed_params)}) - 1
+    };
+    % endif
+
+    /* parameters */
+    % for p in e.variable_params:
+    ${p.kernel_declaration};    // ${p.desc}
+    % endfor
+    % if e.const_params:
+
+    /* compile-time parameters */
+    % for p in e.const_params:
+    static constexpr ${p.kernel_type} ${p.name} = C::${p.name};
+    % endfor
+    % endif
+    % if e.recomputed_params:
+
+    /* derived coefficients */
+    % for p in e.recomputed_params:
+    % for d in p.kernel_derived_declarations:
+    ${d};
+    % endfor
+    % endfor
+    unsigned long dirty;    // DIRTY_* flags, cleared once per block
+    % endif
+    % if e.smoothed_params:
+
+    /* smoothed params */
+    % for p in e.smoothed_params:
+    T ${p.name}_cur;    // ramp value at the start of the block
+    T ${p.name}_step;   // ramp increment per sample
+    int ${p.name}_togo; // samples left until the target is reached
+    int ${p.name}_ramp; // ramp length in samples (${p.smooth} ms)
+    % endfor
+    % endif
+    % if e.signal_params:
+
+    /* signal inputs of params, set by the wrapper before each process()
+     * call (NULL when no signal is connected: the param value is used) */
+    % for p in e.signal_params:
+    const T *${p.name}_in;
+    % endfor
+    % endif
+
+    T sr;   // sample rate
+
+    explicit ${e.name}_kernel(T samplerate)
+    {
+        % for p in e.variable_params:
+        ${p.name} = ${p.initial};
+        % endfor
+        % for p in e.smoothed_params:
+        ${p.name}_cur = ${p.name};
+        ${p.name}_step = 0;
+        ${p.name}_togo = 0;
+        % endfor
+        % for p in e.signal_params:
+        ${p.name}_in = 0;
+        % endfor
+        set_samplerate(samplerate);
+    }
+
+    void set_samplerate(T samplerate)
+    {
+        sr = samplerate;
+        % if e.recomputed_params:
+        dirty = DIRTY_ALL;
+        % endif
+        % for p in e.smoothed_params:
+        ${p.name}_ramp = ramp_samples(${p.smooth});
+        % endfor
+    }
+
+    /* param-setters: clamp at message time so the process loop never has to */
+    % for p in e.variable_params:
+    void set_${p.name}(${p.kernel_type} f)
+    {
+        ${p.name} = ${p.clamp("f")};
+        % if p.recompute:
+        dirty |= ${p.dirty_flag};
+        % endif
+        % if p.smooth:
+        ${p.name}_togo = ${p.name}_ramp;
+        % endif
+    }
+
+    % endfor
+    /**
+     * process a block of n samples
+     *
+     * inputs and outputs may share memory, so all inputs of a frame are
+     * read before any output of that frame is written.
+     */
+    void process(${ins}, ${outs}, int n)
+    {
+        prepare(n);
+        % for p in e.frame_params:
+        % if p.smooth:
+        const T ${p.name}_0 = ${p.name}_cur, ${p.name}_step = this->${p.name}_step;
+        % else:
+        const T ${p.name}_0 = ${p.name};
+        % endif
+        % endfor
+        % for p in e.signal_params:
+        const T *${p.name}_in = this->${p.name}_in;
+        % endfor
+
+        for (int i = 0; i < n; i++) {
+            % for p in e.frame_params:
+            const T ${p.name} = ${p.sample_value(0, True)};
+            % endfor
+            % for c in range(nch):
+            const T f${c} = in${c}[i];
+            % endfor
+            % for c in range(nch):
+            out${c}[i] = f${c};
+            % endfor
+        }
+        % for p in e.smoothed_params:
+        ${p.name}_cur = ${p.name}_0 + ${p.name}_step * n;
+        % endfor
+    }
+
+private:
+    % if e.smoothed_params:
+    /* length of a ramp of `ms` milliseconds in samples (at least 1) */
+    int ramp_samples(T ms) const
+    {
+        int n = (int)(ms * sr / 1000);
+        return (n < 1) ? 1 : n;
+    }
+
+    % endif
+    /* begin a block of n samples: recompute the derived coefficients of
+     * params flagged as dirty and advance the ramps of smoothed params */
+    void prepare(int n)
+    {
+        % if e.recomputed_params:
+        ${e.name}_kernel *x = this;   // `recompute` hooks refer to x->
+        if (dirty) {
+            % for p in e.recomputed_params:
+            if (dirty & ${p.dirty_flag}) {
+                ${p.recompute.strip()}
+            }
+            % endfor
+            dirty = 0;
+        }
+        % endif
+        % for p in e.smoothed_params:
+        if (${p.name}_togo > 0) {
+            int m = (${p.name}_togo > n) ? ${p.name}_togo : n;
+            ${p.name}_step = (${p.name} - ${p.name}_cur) / m;
+            ${p.name}_togo = (${p.name}_togo > n) ? ${p.name}_togo - n : 0;
+        } else {
+            ${p.name}_cur = ${p.name};
+            ${p.name}_step = 0;
+        }
+        % endfor
+    }
+};
+% for p in e.const_params:
+
+template <typename T, typename C>
+constexpr ${p.kernel_type} ${e.name}_kernel<T, C>::${p.name};
+% endfor
+
+#endif // ${e.name.upper()}_KERNEL_HPP
@@ -0,0 +1,328 @@
+/**
+    @file
+    ${e.namespace}.${e.name}~: ${e.meta['desc']}
+    max wrapper of the ${e.name}_kernel (see ../${e.name}_kernel.hpp)
+
+    Features:
+    % for feature in e.meta['features']:
+    - ${feature}
+    % endfor
+
+    Author: ${e.meta['author']}
+    Repo: ${e.meta['repo']}
+*/
+
+#include "ext.h"
+#include "ext_obex.h"
+#include "z_dsp.h"
+
+#include <new>
+#include <stdint.h>
+
+#include "${e.name}_kernel.hpp"
+
+#ifdef XT_PROFILE
+#include "xtgen_profile.h"  // dsp-load stats of the perform routine
+#else
+#define XT_PROFILE_BEGIN()
+#define XT_PROFILE_END(p)
+#endif
+% if e.denormal_ftz:
+
+#include "xtgen_denormal.h"    // flush-to-zero guard of the perform routine
+% endif
+<%
+    nch = e.n_channels
+    nsig = len(e.signal_params)
+%>
+
+#define N_CHANNELS ${nch}
+
+typedef ${e.name}_kernel<double> t_${e.prefix}_kernel;
+
+typedef struct _${e.prefix} {
+    t_pxobject ob;              // the object itself (t_pxobject in MSP instead of t_object)
+
+    t_${e.prefix}_kernel k;     // params and dsp state, constructed in _new
+    % if e.signal_params:
+
+    /* params with a signal inlet */
+    % for p in e.signal_params:
+    short ${p.name}_connected;  // 1 if a signal is connected to the inlet (count[] in _dsp64)
+    % endfor
+    % endif
+#ifdef XT_PROFILE
+
+    t_xt_profile profile;       // timings of the perform routine, see _stats
+#endif
+
+    /* outlets */
+    % for o in e.outlets:
+    t_outlet *out_${o.name};
+    % endfor
+} t_${e.prefix};
+
+
+// method prototypes
+void *${e.prefix}_new(t_symbol *s, long argc, t_atom *argv);
+void ${e.prefix}_free(t_${e.prefix} *x);
+void ${e.prefix}_assist(t_${e.prefix} *x, void *b, long m, long a, char *s);
+void ${e.prefix}_bang(t_${e.prefix} *x);
+#ifdef XT_PROFILE
+void ${e.prefix}_stats(t_${e.prefix} *x);
+#endif
+% if e.signal_params:
+void ${e.prefix}_float(t_${e.prefix} *x, double f);
+% endif
+void ${e.prefix}_anything(t_${e.prefix}* x, t_symbol* s, long argc, t_atom* argv);
+% for m in e.message_methods:
+void ${e.prefix}_${m.name}(t_${e.prefix} *x, t_symbol *s, long argc, t_atom *argv);
+% endfor
+% for p in e.attrs:
+t_max_err ${e.prefix}_attr_${p.name}(t_${e.prefix} *x, void *attr, long argc, t_atom *argv);
+% endfor
+void ${e.prefix}_dsp64(t_${e.prefix} *x, t_object *dsp64, short *count, double samplerate, long maxvectorsize, long flags);
+void ${e.prefix}_perform64(t_${e.prefix} *x, t_object *dsp64, double **ins, long numins, double **outs, long numouts, long sampleframes, long flags, void *userparam);
+
+
+// global class pointer variable
+static t_class *${e.prefix}_class = NULL;
+
+
+// selector symbols, interned once in ext_main
+% for m in e.message_methods + e.dispatch_params:
+static t_symbol *${m.symbol} = NULL;
+% endfor
+
+// selectors handled by ${e.prefix}_anything
+enum {
+    SEL_NONE = 0,
+    % for m in e.message_methods + e.dispatch_params:
+    ${m.selector},
+    % endfor
+};
+
+// open-addressed table mapping interned symbol pointers to selectors
+#define SELTABLE_SIZE ${e.selector_table_size}
+
+static struct {
+    t_symbol *sym;
+    long sel;
+} ${e.prefix}_seltable[SELTABLE_SIZE];
+
+static inline long ${e.prefix}_selhash(t_symbol *s)
+{
+    return (long)(((uintptr_t)s >> 4) & (SELTABLE_SIZE - 1));
+}
+
+static void ${e.prefix}_seltable_add(t_symbol *s, long sel)
+{
+    long h = ${e.prefix}_selhash(s);
+    while (${e.prefix}_seltable[h].sym) {
+        h = (h + 1) & (SELTABLE_SIZE - 1);
+    }
+    ${e.prefix}_seltable[h].sym = s;
+    ${e.prefix}_seltable[h].sel = sel;
+}
+
+static inline long ${e.prefix}_seltable_find(t_symbol *s)
+{
+    long h = ${e.prefix}_selhash(s);
+    while (${e.prefix}_seltable[h].sym) {
+        if (${e.prefix}_seltable[h].sym == s) {
+            return ${e.prefix}_seltable[h].sel;
+        }
+        h = (h + 1) & (SELTABLE_SIZE - 1);
+    }
+    return SEL_NONE;
+}
+
+
+//-----------------------------------------------------------------------------------------------
+
+void ext_main(void *r)
+{
+    t_class *c = class_new("${e.namespace}.${e.name}~", (method)${e.prefix}_new, (method)${e.prefix}_free, (long)sizeof(t_${e.prefix}), 0L, A_GIMME, 0);
+
+    class_addmethod(c, (method)${e.prefix}_anything, "anything", A_GIMME,   0);
+    class_addmethod(c, (method)${e.prefix}_bang,     "bang",                0);
+    % if e.signal_params:
+    class_addmethod(c, (method)${e.prefix}_float,    "float",    A_FLOAT,   0);
+    % endif
+    class_addmethod(c, (method)${e.prefix}_dsp64,    "dsp64",    A_CANT,    0);
+    class_addmethod(c, (method)${e.prefix}_assist,   "assist",   A_CANT,    0);
+#ifdef XT_PROFILE
+    class_addmethod(c, (method)${e.prefix}_stats,    "stats",               0);
+#endif
+
+    % if e.attrs:
+    // attributes (the kernel is templated on double in max)
+    % for p in e.attrs:
+    CLASS_ATTR_DOUBLE(c, "${p.name}", 0, t_${e.prefix}, k.${p.name});
+    CLASS_ATTR_ACCESSORS(c, "${p.name}", NULL, ${e.prefix}_attr_${p.name});
+    % endfor
+
+    % endif
+    // intern selector symbols once, so that dispatch is a pointer lookup
+    % for m in e.message_methods + e.dispatch_params:
+    ${m.symbol} = gensym("${m.name}");
+    ${e.prefix}_seltable_add(${m.symbol}, ${m.selector});
+    % endfor
+
+    class_dspinit(c);
+    class_register(CLASS_BOX, c);
+    ${e.prefix}_class = c;
+}
+
+void *${e.prefix}_new(t_symbol *s, long argc, t_atom *argv)
+{
+    t_${e.prefix} *x = (t_${e.prefix} *)object_alloc(${e.prefix}_class);
+
+    if (x) {
+        % if e.signal_params:
+        dsp_setup((t_pxobject *)x, N_CHANNELS + ${nsig});  // N_CHANNELS audio inlets + param signal inlets
+        % else:
+        dsp_setup((t_pxobject *)x, N_CHANNELS);
+        % endif
+
+        for (int i=0; i < N_CHANNELS; ++i) {
+            outlet_new(x, "signal");        // signal outlet (note "signal" rather than NULL)
+        }
+
+        // construct the kernel in place: its params start at their initial values
+        new (&x->k) t_${e.prefix}_kernel(sys_getsr());
+        % for p in e.signal_params:
+        x->${p.name}_connected = 0;
+        % endfor
+        % if e.attrs:
+
+        attr_args_process(x, (short)argc, argv);
+        % endif
+    }
+    return (x);
+}
+
+
+void ${e.prefix}_free(t_${e.prefix} *x)
+{
+    dsp_free((t_pxobject *)x);
+    x->k.~t_${e.prefix}_kernel();
+}
+
+
+void ${e.prefix}_assist(t_${e.prefix} *x, void *b, long m, long a, char *s)
+{
+    // FIXME: assign to inlets
+    if (m == ASSIST_INLET) { //inlet
+        sprintf(s, "I am inlet %ld", a);
+    }
+    else {  // outlet
+        sprintf(s, "I am outlet %ld", a);
+    }
+}
+
+void ${e.prefix}_bang(t_${e.prefix} *x)
+{
+    post("bang");
+}
+#ifdef XT_PROFILE
+
+// post the dsp-load stats of the perform routine and start over
+void ${e.prefix}_stats(t_${e.prefix} *x)
+{
+    xt_profile_post(&x->profile, "${e.namespace}.${e.name}~", post);
+}
+#endif
+% if e.signal_params:
+
+// floats sent to a param signal inlet set the param
+void ${e.prefix}_float(t_${e.prefix} *x, double f)
+{
+    switch (proxy_getinlet((t_object *)x)) {
+    % for j, p in enumerate(e.signal_params):
+    case N_CHANNELS + ${j}:
+        x->k.set_${p.name}(f);
+        break;
+    % endfor
+    default:
+        break;
+    }
+}
+% endif
+
+% for m in e.message_methods:
+void ${e.prefix}_${m.name}(t_${e.prefix} *x, t_symbol *s, long argc, t_atom *argv)
+{
+    % if m.doc:
+    // ${m.doc}
+    % endif
+    post("${m.name} body");
+}
+
+% endfor
+% for p in e.attrs:
+t_max_err ${e.prefix}_attr_${p.name}(t_${e.prefix} *x, void *attr, long argc, t_atom *argv)
+{
+    if (argc && argv) {
+        x->k.set_${p.name}(atom_getfloat(argv));
+    }
+    return MAX_ERR_NONE;
+}
+
+% endfor
+void ${e.prefix}_anything(t_${e.prefix}* x, t_symbol* s, long argc, t_atom* argv)
+{
+    switch (${e.prefix}_seltable_find(s)) {
+    % for m in e.message_methods:
+    case ${m.selector}:
+        ${e.prefix}_${m.name}(x, s, argc, argv);
+        break;
+    % endfor
+    % for p in e.dispatch_params:
+    case ${p.selector}:
+        if (argc > 0) {
+            x->k.set_${p.name}(atom_getfloat(argv));
+        }
+        break;
+    % endfor
+    default:
+        break;
+    }
+}
+
+
+void ${e.prefix}_dsp64(t_${e.prefix} *x, t_object *dsp64, short *count, double samplerate, long maxvectorsize, long flags)
+{
+    if (samplerate != x->k.sr) {
+        x->k.set_samplerate(samplerate);
+    }
+    % for j, p in enumerate(e.signal_params):
+    x->${p.name}_connected = count[N_CHANNELS + ${j}];
+    % endfor
+
+    object_method(dsp64, gensym("dsp_add64"), x, ${e.prefix}_perform64, 0, NULL);
+}
+
+
+void ${e.prefix}_perform64(t_${e.prefix} *x, t_object *dsp64, double **ins, long numins, double **outs, long numouts, long sampleframes, long flags, void *userparam)
+{
+    XT_PROFILE_BEGIN();
+    % if e.denormal_ftz:
+    t_xt_fpmode fpmode = xt_ftz_begin();
+    % endif
+    % for j, p in enumerate(e.signal_params):
+    x->k.${p.name}_in = x->${p.name}_connected ? ins[N_CHANNELS + ${j}] : NULL;
+    % endfor
+    x->k.process(
+        % for c in range(nch):
+        ins[${c}],
+        % endfor
+        % for c in range(nch):
+        outs[${c}],
+        % endfor
+        (int)sampleframes);
+    % if e.denormal_ftz:
+    xt_ftz_end(fpmode);
+    % endif
+    XT_PROFILE_END(&x->profile);
+}
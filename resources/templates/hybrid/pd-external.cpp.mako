@@ -0,0 +1,326 @@
+/* ${e.name}~.cpp
+
+${e.meta['desc']}
+pd wrapper of the ${e.name}_kernel (see ../${e.name}_kernel.hpp)
+
+Features:
+% for feature in e.meta['features']:
+- ${feature}
+% endfor
+
+Author: ${e.meta['author']}
+Repo: ${e.meta['repo']}
+
+*/
+
+#include <new>
+
+#include "m_pd.h"
+% if e.signal_params:
+#include "m_imp.h"      // obj_findsignalscalar(), obj_issignaloutlet()
+#include "g_canvas.h"   // linetraverser_*()
+% endif
+
+#include "${e.name}_kernel.hpp"
+
+#ifdef XT_PROFILE
+#include "xtgen_profile.h"  // dsp-load stats of the perform routine
+#else
+#define XT_PROFILE_BEGIN()
+#define XT_PROFILE_END(p)
+#endif
+% if e.denormal_ftz:
+
+#include "xtgen_denormal.h"    // flush-to-zero guard of the perform routine
+% endif
+<%
+    nch = e.n_channels
+    nsig = len(e.signal_params)
+    nin = nch + nsig
+%>
+
+typedef ${e.name}_kernel<t_sample> t_${e.c_name}_kernel;
+
+
+/*
+ * ${e.name} class object
+ * ---------------------------------------------------------------------------
+ */
+
+static t_class *${e.klass};
+
+
+/*
+ * ${e.name} class struct (data-space)
+ * ---------------------------------------------------------------------------
+ */
+
+typedef struct _${e.c_name} {
+    t_object x_obj;
+    t_float x_f; // main signal in
+
+    t_${e.c_name}_kernel k; // params and dsp state, constructed in _new
+    % if e.signal_params:
+
+    /* params with a signal inlet */
+    % for p in e.signal_params:
+    t_float *${p.name}_scalar;   // value of the inlet when no signal is connected
+    t_float ${p.name}_last;      // last value picked up from ${p.name}_scalar
+    int ${p.name}_connected;     // 1 if a signal is connected to the inlet
+    % endfor
+    t_canvas *x_canvas;
+    % endif
+#ifdef XT_PROFILE
+
+    t_xt_profile profile;   // timings of the perform routine, see _stats
+#endif
+
+    /* outlets */
+    % for o in e.outlets:
+    t_outlet *out_${o.name};
+    % endfor
+} ${e.type};
+
+
+/*
+ * ${e.name} class methods (operation-space)
+ * ---------------------------------------------------------------------------
+ */
+
+// typed-methods
+% for method in e.type_methods:
+static void ${e.c_name}_${method.type}(${method.args})
+{
+    post("${method.type} body");
+}
+
+% endfor
+
+// message-methods
+% for method in e.message_methods:
+static void ${e.c_name}_${method.name}(${method.args})
+{
+    % if method.doc:
+    // ${method.doc}
+    % endif
+    post("${method.name} body");
+}
+
+% endfor
+
+#ifdef XT_PROFILE
+// post the dsp-load stats of the perform routine and start over
+static void ${e.c_name}_stats(${e.type} *x)
+{
+    xt_profile_post(&x->profile, "${e.name}~", post);
+}
+
+#endif
+// param-setters
+% for p in e.variable_params:
+static void ${e.c_name}_set_${p.name}(${e.type} *x, t_floatarg f)
+{
+    x->k.set_${p.name}(f);
+}
+
+% endfor
+
+/*
+ * ${e.name} dsp operations
+ * ---------------------------------------------------------------------------
+ */
+
+% if e.signal_params:
+/**
+ * returns the inlets of the object into which a signal is connected, bit i
+ * for inlet i, in a single pass over the connections of the canvas
+ */
+static unsigned long ${e.c_name}_connected(${e.type} *x)
+{
+    unsigned long inlets = 0;
+    t_linetraverser t;
+    linetraverser_start(&t, x->x_canvas);
+    while (linetraverser_next(&t)) {
+        if (t.tr_ob2 == &x->x_obj && t.tr_inno < ${nin}
+            && obj_issignaloutlet(t.tr_ob, t.tr_outno))
+            inlets |= 1UL << t.tr_inno;
+    }
+    return inlets;
+}
+
+% endif
+/**
+ * the argument vector holds the objects data-space, N_CHANNELS input
+% if e.signal_params:
+ * vectors, ${nsig} param input vectors, N_CHANNELS output vectors and the
+ * length of the vectors.
+% else:
+ * vectors, N_CHANNELS output vectors and the length of the vectors.
+% endif
+ */
+static t_int *${e.c_name}_perform(t_int *w)
+{
+    ${e.type} *x = (${e.type} *)(w[1]);
+    XT_PROFILE_BEGIN();
+    % if e.denormal_ftz:
+    t_xt_fpmode fpmode = xt_ftz_begin();
+    % endif
+    % for j, p in enumerate(e.signal_params):
+
+    if (*x->${p.name}_scalar != x->${p.name}_last) {
+        x->${p.name}_last = *x->${p.name}_scalar;
+        x->k.set_${p.name}(x->${p.name}_last);
+    }
+    x->k.${p.name}_in = x->${p.name}_connected ? (t_sample *)(w[${2 + nch + j}]) : 0;
+    % endfor
+
+    x->k.process(
+        % for c in range(nch):
+        (t_sample *)(w[${2 + c}]),
+        % endfor
+        % for c in range(nch):
+        (t_sample *)(w[${2 + nin + c}]),
+        % endfor
+        (int)(w[${2 + nin + nch}]));
+    % if e.denormal_ftz:
+    xt_ftz_end(fpmode);
+    % endif
+    XT_PROFILE_END(&x->profile);
+
+    return (w + ${3 + nin + nch});
+}
+
+
+/**
+ * register the perform-routine at the dsp-engine
+ * this function gets called whenever the DSP is turned ON
+ */
+static void ${e.c_name}_dsp(${e.type} *x, t_signal **sp)
+{
+    if (sp[0]->s_sr != x->k.sr)
+        x->k.set_samplerate(sp[0]->s_sr);
+    % if e.signal_params:
+    unsigned long inlets = ${e.c_name}_connected(x);
+    % endif
+    % for j, p in enumerate(e.signal_params):
+    x->${p.name}_connected = (inlets >> ${nch + j}) & 1;
+    % endfor
+
+    dsp_add(${e.c_name}_perform, ${2 + nin + nch}, x,
+            % for c in range(nin + nch):
+            sp[${c}]->s_vec,
+            % endfor
+            sp[0]->s_n);
+}
+
+
+/*
+ * ${e.name} class destructor
+ * ---------------------------------------------------------------------------
+ */
+
+static void ${e.c_name}_free(${e.type} *x)
+{
+    x->k.~t_${e.c_name}_kernel();
+}
+
+
+/*
+ * ${e.name} class constructor
+ * ---------------------------------------------------------------------------
+ */
+
+static void *${e.c_name}_new(${e.class_new_args})
+{
+    ${e.type} *x = (${e.type} *)pd_new(${e.klass});
+
+    // construct the kernel in place: its params start at their initial values
+    new (&x->k) t_${e.c_name}_kernel(sys_getsr());
+
+    // populate variables
+    % if len(e.args) > 0:
+    // switch stmt here
+    % endif
+
+    // create signal inlets (the main signal inlet is created by pd)
+    for (int i = 1; i < ${nch}; i++) {
+        inlet_new(&x->x_obj, &x->x_obj.ob_pd, &s_signal, &s_signal);
+    }
+    % if e.signal_params:
+
+    // create param signal inlets, which may also receive floats
+    x->x_canvas = canvas_getcurrent();
+    % for j, p in enumerate(e.signal_params):
+    signalinlet_new(&x->x_obj, x->k.${p.name});
+    x->${p.name}_scalar = obj_findsignalscalar(&x->x_obj, ${nch + j});
+    x->${p.name}_last = x->k.${p.name};
+    x->${p.name}_connected = 0;
+    % endfor
+    % endif
+
+    // create inlets (routed to the param-setters)
+    % for i in e.inlets:
+    inlet_new(&x->x_obj, &x->x_obj.ob_pd, &s_float, gensym("${i.name}"));
+    % endfor
+
+    // create signal outlets
+    for (int i = 0; i < ${nch}; i++) {
+        outlet_new(&x->x_obj, &s_signal);
+    }
+
+    // initialize outlets
+    % for o in e.outlets:
+    x->out_${o.name} = outlet_new(&x->x_obj, &s_${o.type});
+    % endfor
+
+    return (void *)x;
+}
+
+
+/*
+ * ${e.name} class setup
+ * ---------------------------------------------------------------------------
+ */
+
+extern "C" void ${e.c_name}_setup(void)
+{
+    ${e.klass} = class_new(gensym("${e.name}~"),
+                            (t_newmethod)${e.c_name}_new,
+                            (t_method)${e.c_name}_free,
+                            sizeof(${e.type}),
+                            CLASS_DEFAULT,
+                            ${e.class_type_signature});
+
+    // typed methods
+    %for m in e.type_methods:
+    ${m.class_addmethod};
+    % endfor
+
+    // message methods
+    %for m in e.message_methods:
+    ${m.class_addmethod};
+    % endfor
+
+    // param-setters
+    % for p in e.settable_params:
+    class_addmethod(${e.klass}, (t_method)${e.c_name}_set_${p.name}, gensym("${p.name}"), A_FLOAT, 0);
+    % endfor
+
+#ifdef XT_PROFILE
+    class_addmethod(${e.klass}, (t_method)${e.c_name}_stats, gensym("stats"), A_NULL);
+
+#endif
+    // set main signal in
+    CLASS_MAINSIGNALIN(${e.klass}, ${e.type}, x_f);
+
+    /* Bind the DSP method, which is called when the DACs are turned on */
+    class_addmethod(${e.klass}, (t_method)${e.c_name}_dsp, gensym("dsp"), A_CANT, 0);
+
+    % if e.alias:
+    // set the alias to external
+    ${e.class_addcreator};
+    % endif
+
+    // set name of default help file
+    class_sethelpsymbol(${e.klass}, gensym("${e.help}"));
+}
@@ -0,0 +1,24 @@
+# Makefile for the ${e.name}~ benchmark harness (see xtbench.h)
+#
+# links the generated perform routines against stubs of the max api:
+#
+#   make run                                    # default configurations
+#   make CPPFLAGS=-I<dir> LDLIBS=-l<lib> ...    # external dsp libraries
+#   ./bench -n 64,256,1024 -i 1,16,128 -f csv   # custom configurations
+
+CXX ?= c++
+OPT ?= -O3
+
+CXXFLAGS = -std=c++11 $(OPT) -I.
+
+# the generated external is C++ in a .c file
+bench: xtbench_mx.cpp xtbench.h ../${e.name}~.c
+	$(CXX) $(CXXFLAGS) $(CPPFLAGS) -o $@ xtbench_mx.cpp -x c++ ../${e.name}~.c $(LDFLAGS) $(LDLIBS) -lm
+
+run: bench
+	./bench -n 64,256,1024 -i 1,16,128
+
+clean:
+	@rm -f bench
+
+.PHONY: run clean
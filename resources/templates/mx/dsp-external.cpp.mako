@@ -13,24 +13,291 @@
 #include "ext.h"
 #include "ext_obex.h"
 #include "z_dsp.h"
+% if e.table_params:
+#include "ext_buffer.h"
+% endif
+
+<%
+    kern = e.kernel("max")
+    dc = " + bias" if e.denormal_dc else ""    # denormal offset of the input reads
+%>
+#include <math.h>
+#include <stdint.h>
+% if e.handoff or e.recomputed_params or e.smoothed_params:
+#include <atomic>
+% endif
+% if e.delay_params or e.tables or e.events or e.spectral or e.dsp_outlets:
+
+#define XT_SAMPLE double
+% if e.delay_params:
+#include "xtgen_ring.h"     // delay lines of delay params
+% elif e.dsp_outlets:
+#include "xtgen_ring.h"     // report ring of the from_dsp outlets
+% endif
+% if e.tables:
+#include "xtgen_table.h"    // lookup tables shared by all instances
+% endif
+% if e.events:
+#define XT_EVENT_QUEUE ${e.events}
+#include "xtgen_event.h"    // param changes applied at their sample
+% endif
+% if e.spectral:
+#include "xtgen_fft.h"      // short-time fourier transform of spectral frames
+% endif
+% endif
+% if kern:
+#include <new>
+% if kern.header:
+
+#include "${kern.header}"
+% endif
+% endif
 
 #define N_CHANNELS ${e.n_channels}
+% if kern:
+#define KERNEL_ALIGN ${kern.align}
+% endif
+% if e.spectral:
+
+// spectral frames: SPECTRAL_SIZE samples (${e.spectral.window} window) every SPECTRAL_HOP samples
+#define SPECTRAL_SIZE ${e.spectral.size}
+#define SPECTRAL_OVERLAP ${e.spectral.overlap}
+#define SPECTRAL_HOP (SPECTRAL_SIZE / SPECTRAL_OVERLAP)
+% endif
+% if e.dsp_outlets:
+
+// reports of the perform routines to the from_dsp outlets: up to REPORT_QUEUE
+// reports of at most REPORT_SIZE values wait for the report clock
+#define REPORT_QUEUE 64
+#define REPORT_SIZE ${e.report_size}
+% endif
+% if e.poly:
+
+// voice pool: voices are processed in groups of POLY_LANES (the doubles of
+// one simd register), the pool is padded to whole groups
+#define POLY_VOICES ${e.poly}
+#define POLY_LANES 4
+#define POLY_GROUPS ((POLY_VOICES + POLY_LANES - 1) / POLY_LANES)
+#define POLY_SLOTS (POLY_GROUPS * POLY_LANES)
+% endif
+
+#if defined(_MSC_VER)
+#define RESTRICT __restrict
+#else
+#define RESTRICT __restrict__
+#endif
+
+#ifdef XT_PROFILE
+#include "xtgen_profile.h"  // dsp-load stats of the perform routines
+#else
+#define XT_PROFILE_BEGIN()
+#define XT_PROFILE_END(p)
+#endif
+% if e.denormal_ftz:
+
+#include "xtgen_denormal.h"    // flush-to-zero guard of the perform routines
+% endif
+% if e.denormal_dc:
+
+// offset added to the inputs, with a sign flipping every block so no dc
+// builds up, which keeps decaying feedback paths above the subnormal range
+#define DENORMAL_BIAS 1e-20
+% endif
+
+% if e.recomputed_params:
+// dirty flags of params whose derived coefficients are stale
+% for i, p in enumerate(e.recomputed_params):
+#define ${p.dirty_flag} (1UL << ${i})
+% endfor
+#define DIRTY_ALL ((1UL << ${len(e.recomputed_params)}) - 1)
+
+% endif
+% if e.smoothed_params and not e.handoff:
+// flags of smoothed params whose ramp restarts towards a new target
+% for i, p in enumerate(e.smoothed_params):
+#define ${p.ramp_flag} (1UL << ${i})
+% endfor
 
+% endif
+% if kern:
+typedef ${kern.type} t_${e.prefix}_kernel;
+
+% endif
+% if e.handoff:
+// snapshot of the params as published by the main and scheduler threads
+typedef struct _${e.prefix}_params {
+    % for p in e.variable_params:
+    ${p.max_declaration};
+    % endfor
+} t_${e.prefix}_params;
+
+% endif
+% if e.dsp_outlets:
+// a report of the perform routine to a from_dsp outlet
+typedef struct _${e.prefix}_report {
+    long outlet;                // index of the outlet among the from_dsp outlets
+    double values[REPORT_SIZE]; // the first `size` values of the outlet are used
+} t_${e.prefix}_report;
+
+% endif
 typedef struct _${e.prefix} {
     t_pxobject ob;              // the object itself (t_pxobject in MSP instead of t_object)
 
     /* parameters */
-    % for p in e.params:
-    ${p.struct_declaration};    // ${p.desc}
+    % for p in e.object_params:
+    ${p.max_declaration};    // ${p.desc}
     % endfor
+    % if e.handoff:
+
+    /* param handoff (seqlock): writers update `pending` between
+     * ${e.prefix}_params_begin/_end, the perform routine copies it to the
+     * params above once per block */
+    t_${e.prefix}_params pending;
+    std::atomic<unsigned> seq;  // odd while a write is in progress
+    unsigned seq_seen;          // last seq picked up by the perform routine
+    unsigned seq_depth;         // nesting of _params_begin/_end (in the critical region)
+    % endif
+    % if e.recomputed_params:
+
+    /* derived coefficients */
+    % for p in e.recomputed_params:
+    % for d in p.max_derived_declarations:
+    ${d};
+    % endfor
+    % endfor
+    std::atomic<unsigned long> dirty;   // DIRTY_* flags, set by the setters, taken once per block
+    % endif
+    % if e.smoothed_params:
+
+    /* smoothed params */
+    % for p in e.smoothed_params:
+    double ${p.name}_cur;       // ramp value at the start of the block
+    double ${p.name}_step;      // ramp increment per sample
+    long ${p.name}_togo;        // samples left until the target is reached
+    long ${p.name}_ramp;        // ramp length in samples (${p.smooth} ms)
+    % endfor
+    % if not e.handoff:
+    std::atomic<unsigned long> retarget;    // RAMP_* flags, set by the setters, taken once per block
+    % endif
+    % endif
+
+    % if e.signal_params:
+
+    /* params with a signal inlet */
+    % for p in e.signal_params:
+    short ${p.name}_connected;  // 1 if a signal is connected to the inlet (count[] in _dsp64)
+    % endfor
+    % endif
+
+    % if kern:
+
+    /* dsp kernel, placement-new'd into ${kern.storage} on a KERNEL_ALIGN boundary */
+    t_${e.prefix}_kernel *${kern.name};
+    char ${kern.storage}[sizeof(t_${e.prefix}_kernel) + KERNEL_ALIGN - 1];
+    % endif
+    % if e.buffers:
+
+    /* buffers, resized in _dsp64 */
+    % for b in e.buffers:
+    t_double *${b.name};        // ${b.size} samples
+    long ${b.name}_size;
+    % endfor
+    % endif
+    % if e.delay_params:
+
+    /* delay lines of delay params (tap them at x-><param> * x->sr / 1000
+     * samples), reallocated in _dsp64 when the sample rate changes */
+    % for p in e.delay_params:
+    t_xt_delay ${p.delay_line};     // up to ${p.max_ms} ms
+    % endfor
+    % endif
+    % if e.tables:
+
+    /* lookup tables shared by all instances, read them at a phase in [0, 1)
+     * with xt_table_read_linear() or xt_table_read_cubic() */
+    % for t in e.tables:
+    const t_xt_table *${t.name};   // ${t.size} points: ${t.desc or t.source}
+    % endfor
+    % endif
+    % if e.events:
+
+    /* param changes queued by the message handlers with their scheduler
+     * time, applied by the perform routine at the frame they fall on */
+    t_xt_events events;
+    double event_start;         // scheduler time (ms) of the start of the block
+    double event_end;           // scheduler time of its end, later events wait for the next block
+    % endif
+    % if e.table_params:
+
+    /* buffer~ references of table params, which resolve the buffer~ by
+     * name when it is set, so the perform routines only lock its samples */
+    % for p in e.table_params:
+    t_symbol *${p.name};            // name of the buffer~: ${p.desc}
+    t_buffer_ref *${p.name}_ref;
+    % endfor
+    % endif
+    % if e.spectral:
+
+    /* short-time fourier transform: the fft plan, window table, frames and
+     * overlap-add buffers of all channels, created once in _dsp64 */
+    t_xt_stft stft;
+    % endif
+    % if e.dsp_outlets:
+
+    /* from_dsp outlets: the perform routines queue their reports in the
+     * ring (audio thread) and arm the clock, which sends the latest values
+     * of each outlet from its preallocated message (scheduler thread), at
+     * most once per the outlet's rate */
+    t_xt_ring report_ring;          // t_${e.prefix}_report records
+    void *report_clock;
+    t_xt_atomic_u32 report_armed;   // set from arming the clock until its tick
+    % for o in e.dsp_outlets:
+    t_atom out_${o.name}_atoms[${o.size}];   // message of the ${o.name} outlet
+    double out_${o.name}_sent;      // scheduler time it was last sent
+    long out_${o.name}_pending;     // set while a report waits to be sent
+    % endfor
+    % endif
+    % if e.multichannel:
+
+    /* per-channel state: one array per variable (structure of arrays),
+     * resized in _dsp64 when the channel count changes */
+    % for st in e.state:
+    double *${st.name};         // ${st.desc}
+    % endfor
+    long nchans;                // channels of the multichannel inlet, set in _inputchanged
+    long state_nchans;          // channels of the state arrays, set in _dsp64
+    % endif
+    % if e.poly:
+
+    /* voice pool: one array per voice variable (structure of arrays), the
+     * padding voices past POLY_VOICES are never started */
+    double poly_note[POLY_SLOTS];       // pitch of the voice
+    double poly_velocity[POLY_SLOTS];   // velocity of the voice
+    double poly_gate[POLY_SLOTS];       // 1 while the voice plays, else 0
+    unsigned long poly_age[POLY_SLOTS]; // start order: the oldest voice is stolen
+    % for p in e.voice_params:
+    double ${p.name}[POLY_SLOTS];       // ${p.desc}
+    % endfor
+    % for st in e.state:
+    double ${st.name}[POLY_SLOTS];      // ${st.desc}
+    % endfor
+    long poly_active[POLY_GROUPS];      // playing voices per group: idle groups are skipped
+    unsigned long poly_serial;          // age of the last started voice
+    % endif
+
+    % if e.denormal_dc:
+    double denormal_bias;       // DENORMAL_BIAS added to the inputs, its sign flips every block
+    % endif
+    double sr;                  // sample rate, set in _dsp64
+    long vs;                    // maxvectorsize, set in _dsp64 (0 until then)
+#ifdef XT_PROFILE
+    t_xt_profile profile;       // timings of the perform routines, see _stats
+#endif
 
     /* outlets */
     % for o in e.outlets:
     t_outlet *out_${o.name};
     % endfor
-
-    double feedback;            // controls the reverb time, reverb tail becomes infinite when set to 1.0 (range 0.0 to 1.0)
-    double lp_freq;             // controls the internal dampening filter's cutoff frequency. (range: 0.0 to sample_rate / 2)
 } t_${e.prefix};
 
 
@@ -39,13 +306,169 @@ void *${e.prefix}_new(t_symbol *s, long argc, t_atom *argv);
 void ${e.prefix}_free(t_${e.prefix} *x);
 void ${e.prefix}_assist(t_${e.prefix} *x, void *b, long m, long a, char *s);
 void ${e.prefix}_bang(t_${e.prefix} *x);
+#ifdef XT_PROFILE
+void ${e.prefix}_stats(t_${e.prefix} *x);
+#endif
+% if e.signal_params:
+void ${e.prefix}_float(t_${e.prefix} *x, double f);
+% endif
 void ${e.prefix}_anything(t_${e.prefix}* x, t_symbol* s, long argc, t_atom* argv);
+% for m in e.message_methods:
+void ${e.prefix}_${m.name}(t_${e.prefix} *x, t_symbol *s, long argc, t_atom *argv);
+% endfor
+% for p in e.variable_params:
+void ${e.prefix}_set_${p.name}(t_${e.prefix} *x, double f);
+% endfor
+% for p in e.event_params:
+void ${e.prefix}_event_${p.name}(t_${e.prefix} *x, double f);
+% endfor
+% for p in e.table_params:
+void ${e.prefix}_set_${p.name}(t_${e.prefix} *x, t_symbol *s);
+% endfor
+% if e.table_params:
+t_max_err ${e.prefix}_notify(t_${e.prefix} *x, t_symbol *s, t_symbol *msg, void *sender, void *data);
+% endif
+% if e.dsp_outlets:
+void ${e.prefix}_report_tick(t_${e.prefix} *x);
+% endif
+% if e.poly:
+void ${e.prefix}_note(t_${e.prefix} *x, double pitch, double velocity);
+void ${e.prefix}_voice(t_${e.prefix} *x, double voice, double pitch, double velocity);
+% for p in e.voice_params:
+void ${e.prefix}_set_${p.name}(t_${e.prefix} *x, double voice, double f);
+% endfor
+% endif
+% for p in e.attrs:
+t_max_err ${e.prefix}_attr_${p.name}(t_${e.prefix} *x, void *attr, long argc, t_atom *argv);
+% endfor
+% if e.multichannel:
+long ${e.prefix}_multichanneloutputs(t_${e.prefix} *x, long index);
+long ${e.prefix}_inputchanged(t_${e.prefix} *x, long index, long count);
+% endif
 void ${e.prefix}_dsp64(t_${e.prefix} *x, t_object *dsp64, short *count, double samplerate, long maxvectorsize, long flags);
-void ${e.prefix}_perform64(t_${e.prefix} *x, t_object *dsp64, double **ins, long numins, double **outs, long numouts, long sampleframes, long flags, void *userparam);
+% for suffix in (["", "_sig"] if e.signal_params else [""]):
+void ${e.prefix}_perform64${suffix}(t_${e.prefix} *x, t_object *dsp64, double **ins, long numins, double **outs, long numouts, long sampleframes, long flags, void *userparam);
+% if not (e.multichannel or e.poly or e.spectral):
+void ${e.prefix}_perf8${suffix}(t_${e.prefix} *x, t_object *dsp64, double **ins, long numins, double **outs, long numouts, long sampleframes, long flags, void *userparam);
+% endif
+% endfor
 
 
 // global class pointer variable
 static t_class *${e.prefix}_class = NULL;
+% if e.tables:
+
+// lookup tables shared by all instances: filled when the first instance is
+// created and freed with the last one
+% for t in e.tables:
+static t_xt_table ${e.prefix}_${t.name};     // ${t.desc or t.source}
+% endfor
+static long ${e.prefix}_table_refs = 0;
+% for t in e.tables:
+% if t.points:
+
+static const double ${e.prefix}_${t.name}_points[${t.size}] = {
+% for i in range(0, t.size, 8):
+    ${", ".join(t.points[i:i + 8])},
+% endfor
+};
+% endif
+% endfor
+
+static void ${e.prefix}_tables_acquire(void)
+{
+    if (${e.prefix}_table_refs++) {
+        return;
+    }
+    % for t in e.tables:
+    xt_table_init(&${e.prefix}_${t.name}, sysmem_newptrclear((long)xt_table_bytes(${t.size})), ${t.size});
+    % if t.source == "sine":
+    xt_table_fill_sine(&${e.prefix}_${t.name});
+    % elif t.source == "saw":
+    xt_table_fill_saw(&${e.prefix}_${t.name}, ${t.harmonics});
+    % else:
+    for (uint32_t i = 0; i < ${t.size}; i++) {
+        % if t.source == "expr":
+        double p = (double)i / ${t.size};
+        ${e.prefix}_${t.name}.data[i] = (${t.expr});
+        % else:
+        ${e.prefix}_${t.name}.data[i] = ${e.prefix}_${t.name}_points[i];
+        % endif
+    }
+    xt_table_guard(&${e.prefix}_${t.name});
+    % endif
+    % endfor
+}
+
+static void ${e.prefix}_tables_release(void)
+{
+    if (--${e.prefix}_table_refs) {
+        return;
+    }
+    % for t in e.tables:
+    sysmem_freeptr(${e.prefix}_${t.name}.mem);
+    % endfor
+}
+% endif
+
+% if e.smoothed_params:
+
+// length of a ramp of `ms` milliseconds in samples (at least 1)
+static inline long ${e.prefix}_ramp_samples(double ms, double samplerate)
+{
+    long n = (long)(ms * samplerate / 1000.0);
+    return (n < 1) ? 1 : n;
+}
+% endif
+
+
+// selector symbols, interned once in ext_main
+% for m in e.message_methods + e.dispatch_params + e.voice_params + e.table_params:
+static t_symbol *${m.symbol} = NULL;
+% endfor
+
+// selectors handled by ${e.prefix}_anything
+enum {
+    SEL_NONE = 0,
+    % for m in e.message_methods + e.dispatch_params + e.voice_params + e.table_params:
+    ${m.selector},
+    % endfor
+};
+
+// open-addressed table mapping interned symbol pointers to selectors
+#define SELTABLE_SIZE ${e.selector_table_size}
+
+static struct {
+    t_symbol *sym;
+    long sel;
+} ${e.prefix}_seltable[SELTABLE_SIZE];
+
+static inline long ${e.prefix}_selhash(t_symbol *s)
+{
+    return (long)(((uintptr_t)s >> 4) & (SELTABLE_SIZE - 1));
+}
+
+static void ${e.prefix}_seltable_add(t_symbol *s, long sel)
+{
+    long h = ${e.prefix}_selhash(s);
+    while (${e.prefix}_seltable[h].sym) {
+        h = (h + 1) & (SELTABLE_SIZE - 1);
+    }
+    ${e.prefix}_seltable[h].sym = s;
+    ${e.prefix}_seltable[h].sel = sel;
+}
+
+static inline long ${e.prefix}_seltable_find(t_symbol *s)
+{
+    long h = ${e.prefix}_selhash(s);
+    while (${e.prefix}_seltable[h].sym) {
+        if (${e.prefix}_seltable[h].sym == s) {
+            return ${e.prefix}_seltable[h].sel;
+        }
+        h = (h + 1) & (SELTABLE_SIZE - 1);
+    }
+    return SEL_NONE;
+}
 
 
 //-----------------------------------------------------------------------------------------------
@@ -60,8 +483,46 @@ void ext_main(void *r)
 
     class_addmethod(c, (method)${e.prefix}_anything, "anything", A_GIMME,   0);
     class_addmethod(c, (method)${e.prefix}_bang,     "bang",                0);
+    % if e.signal_params:
+    class_addmethod(c, (method)${e.prefix}_float,    "float",    A_FLOAT,   0);
+    % endif
     class_addmethod(c, (method)${e.prefix}_dsp64,    "dsp64",    A_CANT,    0);
+    % if e.multichannel:
+    class_addmethod(c, (method)${e.prefix}_multichanneloutputs, "multichanneloutputs", A_CANT, 0);
+    class_addmethod(c, (method)${e.prefix}_inputchanged, "inputchanged", A_CANT, 0);
+    % endif
+    % if e.poly:
+    class_addmethod(c, (method)${e.prefix}_note,     "note",     A_FLOAT, A_FLOAT, 0);
+    class_addmethod(c, (method)${e.prefix}_voice,    "voice",    A_FLOAT, A_FLOAT, A_FLOAT, 0);
+    % endif
     class_addmethod(c, (method)${e.prefix}_assist,   "assist",   A_CANT,    0);
+    % if e.table_params:
+    class_addmethod(c, (method)${e.prefix}_notify,   "notify",   A_CANT,    0);
+    % endif
+#ifdef XT_PROFILE
+    class_addmethod(c, (method)${e.prefix}_stats,    "stats",               0);
+#endif
+
+    % if e.attrs:
+    // attributes
+    % for p in e.attrs:
+    % if e.handoff:
+    CLASS_ATTR_DOUBLE(c, "${p.name}", 0, t_${e.prefix}, pending.${p.name});
+    % else:
+    CLASS_ATTR_DOUBLE(c, "${p.name}", 0, t_${e.prefix}, ${p.name});
+    % endif
+    CLASS_ATTR_ACCESSORS(c, "${p.name}", NULL, ${e.prefix}_attr_${p.name});
+    % endfor
+
+    % endif
+    // intern selector symbols once, so that dispatch is a pointer lookup
+    % for m in e.message_methods + e.dispatch_params + e.voice_params + e.table_params:
+    ${m.symbol} = gensym("${m.name}");
+    ${e.prefix}_seltable_add(${m.symbol}, ${m.selector});
+    % endfor
+    % if e.table_set:
+    ${e.prefix}_seltable_add(gensym("set"), ${e.table_set.selector});
+    % endif
 
     class_dspinit(c);
     class_register(CLASS_BOX, c);
@@ -73,16 +534,142 @@ void *${e.prefix}_new(t_symbol *s, long argc, t_atom *argv)
     t_${e.prefix} *x = (t_${e.prefix} *)object_alloc(${e.prefix}_class);
 
     if (x) {
+        % if e.outlets:
+        // control outlets: each new outlet is added on the left, so these are
+        // created first (and last to first) to end up right of the signal
+        // outlets, in their declared order, like in pd
+        % for o in reversed(e.outlets):
+        x->out_${o.name} = outlet_new(x, "${o.type}");
+        % endfor
+
+        % endif
+        % if e.multichannel:
+        dsp_setup((t_pxobject *)x, 1 + ${len(e.signal_params)});  // multichannel audio inlet + param signal inlets
+        x->ob.z_misc |= Z_NO_INPLACE | Z_MC_INLETS;  // all channels of an inlet are passed to _perform64
+
+        outlet_new(x, "multichannelsignal");    // channel count from _multichanneloutputs
+        % else:
+        % if e.signal_params:
+        dsp_setup((t_pxobject *)x, N_CHANNELS + ${len(e.signal_params)});  // N_CHANNELS audio inlets + param signal inlets
+        % else:
         dsp_setup((t_pxobject *)x, N_CHANNELS);
+        % endif
+        x->ob.z_misc |= Z_NO_INPLACE;   // ins and outs never alias (required by RESTRICT in _perf8)
 
         for (int i=0; i < N_CHANNELS; ++i) {
             post("signal outlet: %d", i);
             outlet_new(x, "signal");        // signal outlet (note "signal" rather than NULL)
         }
-        
-        x->rev = new daisysp::ReverbSc;
-        x->feedback = 100.0;
-        x->lp_freq = 0.5;
+        % endif
+
+        // initialize variables
+        % for p in e.object_params:
+        x->${p.name} = ${p.initial};
+        % endfor
+        % if e.handoff:
+        % for p in e.variable_params:
+        x->pending.${p.name} = x->${p.name};
+        % endfor
+        x->seq.store(0, std::memory_order_relaxed);
+        x->seq_seen = 0;
+        x->seq_depth = 0;
+        % endif
+        x->sr = sys_getsr();
+        x->vs = 0;
+        % if e.denormal_dc:
+        x->denormal_bias = DENORMAL_BIAS;
+        % endif
+        % if e.recomputed_params:
+        x->dirty.store(DIRTY_ALL, std::memory_order_relaxed);
+        % endif
+        % if kern:
+
+        // construct the kernel inside the object instead of on the heap
+        uintptr_t slot = ((uintptr_t)x->${kern.storage} + KERNEL_ALIGN - 1) & ~(uintptr_t)(KERNEL_ALIGN - 1);
+        x->${kern.name} = new ((void *)slot) t_${e.prefix}_kernel;
+        % endif
+        % for b in e.buffers:
+        x->${b.name} = NULL;
+        x->${b.name}_size = 0;
+        % endfor
+        % for p in e.delay_params:
+        x->${p.delay_line}.mem = NULL;
+        x->${p.delay_line}.nbytes = 0;
+        % endfor
+        % if e.events:
+        xt_events_init(&x->events);
+        x->event_start = x->event_end = gettime_forobject((t_object *)x);
+        % endif
+        % if e.spectral:
+        x->stft.mem = NULL;
+        x->stft.nbytes = 0;
+        % endif
+        % if e.dsp_outlets:
+
+        // the report ring and clock of the from_dsp outlets (the messages are zeroed by object_alloc)
+        xt_ring_init(&x->report_ring, sysmem_newptrclear((long)xt_ring_bytes(REPORT_QUEUE * sizeof(t_${e.prefix}_report))),
+            REPORT_QUEUE * sizeof(t_${e.prefix}_report));
+        x->report_clock = clock_new(x, (method)${e.prefix}_report_tick);
+        xt_store_release(&x->report_armed, 0);
+        % for o in e.dsp_outlets:
+        x->out_${o.name}_sent = -${o.rate};   // the first report is sent at once
+        x->out_${o.name}_pending = 0;
+        % endfor
+        % endif
+        % for p in e.table_params:
+        x->${p.name} = gensym(${p.array_name});
+        x->${p.name}_ref = buffer_ref_new((t_object *)x, x->${p.name});
+        % endfor
+        % if e.tables:
+
+        ${e.prefix}_tables_acquire();
+        % for t in e.tables:
+        x->${t.name} = &${e.prefix}_${t.name};
+        % endfor
+        % endif
+        % if e.multichannel:
+        % for st in e.state:
+        x->${st.name} = NULL;
+        % endfor
+        x->nchans = N_CHANNELS;
+        x->state_nchans = 0;
+        % endif
+        % if e.poly:
+
+        // all voices start idle
+        for (long v = 0; v < POLY_SLOTS; v++) {
+            x->poly_note[v] = 0.0;
+            x->poly_velocity[v] = 0.0;
+            x->poly_gate[v] = 0.0;
+            x->poly_age[v] = 0;
+            % for p in e.voice_params:
+            x->${p.name}[v] = ${p.initial};
+            % endfor
+            % for st in e.state:
+            x->${st.name}[v] = ${st.initial};
+            % endfor
+        }
+        for (long g = 0; g < POLY_GROUPS; g++) {
+            x->poly_active[g] = 0;
+        }
+        x->poly_serial = 0;
+        % endif
+        % for p in e.signal_params:
+        x->${p.name}_connected = 0;
+        % endfor
+        % for p in e.smoothed_params:
+        x->${p.name}_cur = x->${p.name};
+        x->${p.name}_step = 0.0;
+        x->${p.name}_togo = 0;
+        x->${p.name}_ramp = ${e.prefix}_ramp_samples(${p.smooth}, x->sr);
+        % endfor
+        % if e.smoothed_params and not e.handoff:
+        x->retarget.store(0, std::memory_order_relaxed);
+        % endif
+        % if e.attrs:
+
+        attr_args_process(x, (short)argc, argv);
+        % endif
     }
     return (x);
 }
@@ -90,8 +677,45 @@ void *${e.prefix}_new(t_symbol *s, long argc, t_atom *argv)
 
 void ${e.prefix}_free(t_${e.prefix} *x)
 {
-    delete x->rev;
     dsp_free((t_pxobject *)x);
+    % if kern:
+    % if kern.free:
+    ${kern.free.strip()}
+    % endif
+    x->${kern.name}->~t_${e.prefix}_kernel();
+    % endif
+    % for b in e.buffers:
+    if (x->${b.name}) {
+        sysmem_freeptr(x->${b.name});
+    }
+    % endfor
+    % for p in e.delay_params:
+    if (x->${p.delay_line}.mem) {
+        sysmem_freeptr(x->${p.delay_line}.mem);
+    }
+    % endfor
+    % if e.spectral:
+    if (x->stft.mem) {
+        sysmem_freeptr(x->stft.mem);
+    }
+    % endif
+    % if e.dsp_outlets:
+    object_free(x->report_clock);
+    sysmem_freeptr(x->report_ring.mem);
+    % endif
+    % for p in e.table_params:
+    object_free(x->${p.name}_ref);
+    % endfor
+    % if e.tables:
+    ${e.prefix}_tables_release();
+    % endif
+    % if e.multichannel:
+    % for st in e.state:
+    if (x->${st.name}) {
+        sysmem_freeptr(x->${st.name});
+    }
+    % endfor
+    % endif
 }
 
 
@@ -110,44 +734,1114 @@ void ${e.prefix}_bang(t_${e.prefix} *x)
 {
     post("bang");
 }
+#ifdef XT_PROFILE
 
-void ${e.prefix}_anything(t_${e.prefix}* x, t_symbol* s, long argc, t_atom* argv)
+// post the dsp-load stats of the perform routines and start over
+// (read on the main thread while the audio thread updates them, so a line
+// may mix two blocks: good enough for a diagnostic)
+void ${e.prefix}_stats(t_${e.prefix} *x)
+{
+    xt_profile_post(&x->profile, "${e.namespace}.${e.name}~", post);
+}
+#endif
+% if e.signal_params:
+
+// floats sent to a param signal inlet set the param
+void ${e.prefix}_float(t_${e.prefix} *x, double f)
+{
+    switch (proxy_getinlet((t_object *)x)) {
+    % for j, p in enumerate(e.signal_params):
+    case ${"1" if e.multichannel else "N_CHANNELS"} + ${j}:
+        ${e.prefix}_${"event" if p.name in [q.name for q in e.event_params] else "set"}_${p.name}(x, f);
+        break;
+    % endfor
+    default:
+        break;
+    }
+}
+% endif
+
+% for m in e.message_methods:
+void ${e.prefix}_${m.name}(t_${e.prefix} *x, t_symbol *s, long argc, t_atom *argv)
+{
+    % if m.doc:
+    // ${m.doc}
+    % endif
+    % if e.handoff:
+    // write params between ${e.prefix}_params_begin/_end, by assigning
+    // x->pending fields or calling the setters (which nest), to publish
+    // them together
+    % endif
+    post("${m.name} body");
+}
+
+% endfor
+% if e.handoff:
+// param handoff: writers on the main and scheduler threads are serialized by
+// a critical region, and several params written between _begin and _end are
+// picked up together. The perform routine never waits for a writer: it keeps
+// the current params for a block in which it sees a write in progress.
+// _begin/_end nest (the setters called by a method writing several params),
+// only the outermost pair making seq odd and then even again.
+static inline void ${e.prefix}_params_begin(t_${e.prefix} *x)
+{
+    critical_enter(0);
+    if (x->seq_depth++ == 0) {
+        x->seq.store(x->seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+}
+
+static inline void ${e.prefix}_params_end(t_${e.prefix} *x)
+{
+    if (--x->seq_depth == 0) {
+        x->seq.store(x->seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    critical_exit(0);
+}
+
+// copy the latest complete snapshot into `snap`, returns false if there is
+// none or a write is in progress (called from the perform routine only)
+static inline bool ${e.prefix}_params_read(t_${e.prefix} *x, t_${e.prefix}_params *snap)
+{
+    unsigned seq = x->seq.load(std::memory_order_acquire);
+    if (seq == x->seq_seen || (seq & 1)) {
+        return false;
+    }
+    *snap = x->pending;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (x->seq.load(std::memory_order_relaxed) != seq) {
+        return false;
+    }
+    x->seq_seen = seq;
+    return true;
+}
+
+% endif
+// param-setters: clamp at message time so the perform loop never has to
+% if not e.handoff and (e.recomputed_params or e.smoothed_params):
+// and flag the param for the perform routine with an atomic or, which the
+// perform routine takes with an exchange, so no flag set meanwhile is lost
+% endif
+% for p in e.variable_params:
+void ${e.prefix}_set_${p.name}(t_${e.prefix} *x, double f)
+{
+    % if e.handoff:
+    ${e.prefix}_params_begin(x);
+    x->pending.${p.name} = ${p.clamp("f")};
+    ${e.prefix}_params_end(x);
+    % else:
+    x->${p.name} = ${p.clamp("f")};
+    % if p.recompute:
+    x->dirty.fetch_or(${p.dirty_flag}, std::memory_order_release);
+    % endif
+    % if p.smooth:
+    x->retarget.fetch_or(${p.ramp_flag}, std::memory_order_release);
+    % endif
+    % endif
+}
+
+% endfor
+% if e.table_params:
+// table param-setters: <param> <buffer~>${", or set <buffer~> for " + e.table_set.name if e.table_set else ""}
+% for p in e.table_params:
+void ${e.prefix}_set_${p.name}(t_${e.prefix} *x, t_symbol *s)
+{
+    x->${p.name} = s;
+    buffer_ref_set(x->${p.name}_ref, s);
+}
+
+% endfor
+// forward the notifications of the buffer~s to their references
+t_max_err ${e.prefix}_notify(t_${e.prefix} *x, t_symbol *s, t_symbol *msg, void *sender, void *data)
+{
+    % for p in e.table_params:
+    buffer_ref_notify(x->${p.name}_ref, s, msg, sender, data);
+    % endfor
+    return MAX_ERR_NONE;
+}
+
+% endif
+% if e.events:
+// ids of the param events
+enum {
+    % for p in e.event_params:
+    ${p.event_id},
+    % endfor
+};
+
+static void ${e.prefix}_event_apply(t_${e.prefix} *x, int id, double f)
+{
+    switch (id) {
+    % for p in e.event_params:
+    case ${p.event_id}:
+        ${e.prefix}_set_${p.name}(x, f);
+        break;
+    % endfor
+    default:
+        break;
+    }
+}
+
+// queue a param change at the scheduler time of the message. Handlers on
+// the main and scheduler threads are serialized by a critical region. While
+// the dsp of the object is off nothing empties the queue, so its events are
+// applied at once, in order, followed by this one.
+static void ${e.prefix}_event_push(t_${e.prefix} *x, int id, double f)
+{
+    critical_enter(0);
+    if (!sys_getdspobjdspstate((t_object *)x)) {
+        const t_xt_event *ev;
+        while ((ev = xt_events_peek(&x->events))) {
+            ${e.prefix}_event_apply(x, ev->id, ev->value);
+            xt_events_pop(&x->events);
+        }
+        ${e.prefix}_event_apply(x, id, f);
+    } else if (!xt_events_push(&x->events, gettime_forobject((t_object *)x), id, f)) {
+        object_error((t_object *)x, "event queue full (%d events per block), change dropped", XT_EVENT_QUEUE);
+    }
+    critical_exit(0);
+}
+
+// param event handlers: the methods and attributes of the settable params
+% for p in e.event_params:
+void ${e.prefix}_event_${p.name}(t_${e.prefix} *x, double f)
+{
+    ${e.prefix}_event_push(x, ${p.event_id}, f);
+}
+
+% endfor
+% endif
+% if e.poly:
+// returns the index of voice number `voice` (counted from 1, like the voice
+// numbers of poly~), or -1 if it is out of range
+static long ${e.prefix}_voice_index(t_${e.prefix} *x, double voice)
+{
+    long v = (long)voice - 1;
+    if (v < 0 || v >= POLY_VOICES) {
+        object_error((t_object *)x, "no voice %ld (1..%d)", v + 1, POLY_VOICES);
+        return -1;
+    }
+    return v;
+}
+
+// start voice v, a voice which is still playing is retriggered
+static void ${e.prefix}_voice_on(t_${e.prefix} *x, long v, double pitch, double velocity)
+{
+    if (!x->poly_gate[v]) {
+        x->poly_active[v / POLY_LANES]++;
+    }
+    x->poly_note[v] = pitch;
+    x->poly_velocity[v] = velocity;
+    x->poly_gate[v] = 1.0;
+    x->poly_age[v] = ++x->poly_serial;
+    % for st in e.state:
+    x->${st.name}[v] = ${st.initial};
+    % endfor
+}
+
+// stop voice v, its group is skipped by the perform routine once all of its voices are idle
+static void ${e.prefix}_voice_off(t_${e.prefix} *x, long v)
+{
+    if (x->poly_gate[v]) {
+        x->poly_gate[v] = 0.0;
+        x->poly_active[v / POLY_LANES]--;
+    }
+}
+
+// note <pitch> <velocity>: start a voice, taking a free voice if there is one
+// and stealing the oldest voice otherwise. A velocity of 0 stops the voices
+// playing `pitch`.
+void ${e.prefix}_note(t_${e.prefix} *x, double pitch, double velocity)
+{
+    long v, oldest = 0;
+    if (velocity <= 0) {
+        for (v = 0; v < POLY_VOICES; v++) {
+            if (x->poly_gate[v] && x->poly_note[v] == pitch) {
+                ${e.prefix}_voice_off(x, v);
+            }
+        }
+        return;
+    }
+    for (v = 0; v < POLY_VOICES; v++) {
+        if (!x->poly_gate[v]) {
+            break;
+        }
+        if (x->poly_age[v] < x->poly_age[oldest]) {
+            oldest = v;
+        }
+    }
+    ${e.prefix}_voice_on(x, (v < POLY_VOICES) ? v : oldest, pitch, velocity);
+}
+
+// voice <voice> <pitch> <velocity>: start (or with a velocity of 0 stop) the
+// given voice, as allocated by an external voice allocator
+void ${e.prefix}_voice(t_${e.prefix} *x, double voice, double pitch, double velocity)
+{
+    long v = ${e.prefix}_voice_index(x, voice);
+    if (v < 0) {
+        return;
+    }
+    if (velocity > 0) {
+        ${e.prefix}_voice_on(x, v, pitch, velocity);
+    } else {
+        ${e.prefix}_voice_off(x, v);
+    }
+}
+
+// voice param-setters: <param> <voice> <value>
+% for p in e.voice_params:
+void ${e.prefix}_set_${p.name}(t_${e.prefix} *x, double voice, double f)
+{
+    long v = ${e.prefix}_voice_index(x, voice);
+    if (v >= 0) {
+        x->${p.name}[v] = ${p.clamp("f")};
+    }
+}
+
+% endfor
+% endif
+% for p in e.attrs:
+t_max_err ${e.prefix}_attr_${p.name}(t_${e.prefix} *x, void *attr, long argc, t_atom *argv)
 {
-    if (s != gensym("") && argc > 0) {
-        if (s == gensym("feedback")) {
-            x->feedback = atom_getfloat(argv);
+    if (argc && argv) {
+        ${e.prefix}_${"event" if e.events else "set"}_${p.name}(x, atom_getfloat(argv));
+    }
+    return MAX_ERR_NONE;
+}
 
+% endfor
+void ${e.prefix}_anything(t_${e.prefix}* x, t_symbol* s, long argc, t_atom* argv)
+{
+    switch (${e.prefix}_seltable_find(s)) {
+    % for m in e.message_methods:
+    case ${m.selector}:
+        ${e.prefix}_${m.name}(x, s, argc, argv);
+        break;
+    % endfor
+    % for p in e.dispatch_params:
+    case ${p.selector}:
+        if (argc > 0) {
+            ${e.prefix}_${"event" if e.events else "set"}_${p.name}(x, atom_getfloat(argv));
         }
-        else if (s == gensym("lp_freq")) {
-            x->lp_freq = atom_getfloat(argv);
+        break;
+    % endfor
+    % for p in e.voice_params:
+    case ${p.selector}:
+        if (argc > 1) {
+            ${e.prefix}_set_${p.name}(x, atom_getfloat(argv), atom_getfloat(argv + 1));
         }
+        break;
+    % endfor
+    % for p in e.table_params:
+    case ${p.selector}:
+        ${e.prefix}_set_${p.name}(x, (argc > 0) ? atom_getsym(argv) : gensym(""));
+        break;
+    % endfor
+    default:
+        break;
     }
 }
 
 
 
+% if e.multichannel:
+// the multichannel outlet has as many channels as the multichannel inlet
+long ${e.prefix}_multichanneloutputs(t_${e.prefix} *x, long index)
+{
+    return (index == 0) ? x->nchans : 0;
+}
+
+// called before _dsp64 when the channel count of an inlet changes, returns
+// true if that changes the channel count of the outlet
+long ${e.prefix}_inputchanged(t_${e.prefix} *x, long index, long count)
+{
+    if (index == 0 && count != x->nchans) {
+        x->nchans = count;
+        return true;
+    }
+    return false;
+}
+
+
+% endif
 void ${e.prefix}_dsp64(t_${e.prefix} *x, t_object *dsp64, short *count, double samplerate, long maxvectorsize, long flags)
 {
     // post("sample rate: %f", samplerate);
     // post("maxvectorsize: %d", maxvectorsize);
 
-    x->rev->Init(samplerate);
+    // dsp64 is also called on every rebuild of the dsp chain, so state
+    // depending on the sample rate or the vector size is only rebuilt
+    // when one of them has actually changed.
+    if (samplerate != x->sr || maxvectorsize != x->vs) {
+        x->sr = samplerate;
+        x->vs = maxvectorsize;
+        % if e.recomputed_params:
+        x->dirty.fetch_or(DIRTY_ALL, std::memory_order_relaxed);
+        % endif
+        % for p in e.smoothed_params:
+        x->${p.name}_ramp = ${e.prefix}_ramp_samples(${p.smooth}, samplerate);
+        % endfor
+        % for b in e.buffers:
 
+        long ${b.name}_size = ${b.size};
+        if (${b.name}_size != x->${b.name}_size) {
+            if (x->${b.name}) {
+                sysmem_freeptr(x->${b.name});
+            }
+            x->${b.name} = (t_double *)sysmem_newptrclear(${b.name}_size * sizeof(t_double));
+            x->${b.name}_size = ${b.name}_size;
+        }
+        % endfor
+        % for p in e.delay_params:
+
+        uint32_t ${p.name}_max_delay = ${p.max_delay};
+        if (xt_delay_bytes(${p.name}_max_delay) != x->${p.delay_line}.nbytes) {
+            if (x->${p.delay_line}.mem) {
+                sysmem_freeptr(x->${p.delay_line}.mem);
+            }
+            xt_delay_init(&x->${p.delay_line}, sysmem_newptrclear((long)xt_delay_bytes(${p.name}_max_delay)),
+                ${p.name}_max_delay);
+        }
+        % endfor
+        % if kern and kern.init:
+
+        ${kern.init.strip()}
+        % endif
+    }
+    % if e.spectral:
+
+    // the fft plan, window table and frames are made once, by the first _dsp64
+    if (!x->stft.mem) {
+        xt_stft_init(&x->stft, sysmem_newptrclear((long)xt_stft_bytes(SPECTRAL_SIZE, N_CHANNELS)),
+            SPECTRAL_SIZE, SPECTRAL_OVERLAP, N_CHANNELS, ${e.spectral.window_id});
+    }
+    % endif
+    % if e.events:
+
+    // the first block after a restart of the dsp begins now
+    x->event_end = gettime_forobject((t_object *)x);
+    % endif
+    % if e.multichannel:
+
+    // channel state is kept across a change of the channel count, new
+    // channels start from the initial state
+    if (x->nchans != x->state_nchans) {
+        % for st in e.state:
+        double *${st.name} = (double *)sysmem_newptr(x->nchans * sizeof(double));
+        % endfor
+        for (long c = 0; c < x->nchans; c++) {
+            % for st in e.state:
+            ${st.name}[c] = (c < x->state_nchans) ? x->${st.name}[c] : ${st.initial};
+            % endfor
+        }
+        % for st in e.state:
+        if (x->${st.name}) {
+            sysmem_freeptr(x->${st.name});
+        }
+        x->${st.name} = ${st.name};
+        % endfor
+        x->state_nchans = x->nchans;
+    }
+    % endif
+
+    % if e.signal_params:
+
+    // param inlets without a signal connection are read from the struct
+    // by the scalar variants; the vector variants are only used when at
+    // least one param inlet is connected.
+    bool connected = false;
+    % for j, p in enumerate(e.signal_params):
+    x->${p.name}_connected = count[${"1" if e.multichannel else "N_CHANNELS"} + ${j}];
+    connected |= x->${p.name}_connected;
+    % endfor
+    % endif
+
+    % if e.multichannel:
+    % if e.signal_params:
+    object_method(dsp64, gensym("dsp_add64"), x, connected ? ${e.prefix}_perform64_sig : ${e.prefix}_perform64, 0, NULL);
+    % else:
+    object_method(dsp64, gensym("dsp_add64"), x, ${e.prefix}_perform64, 0, NULL);
+    % endif
+    % elif e.poly:
+    % if e.signal_params:
+    object_method(dsp64, gensym("dsp_add64"), x, connected ? ${e.prefix}_perform64_sig : ${e.prefix}_perform64, 0, NULL);
+    % else:
+    object_method(dsp64, gensym("dsp_add64"), x, ${e.prefix}_perform64, 0, NULL);
+    % endif
+    % elif e.spectral:
     object_method(dsp64, gensym("dsp_add64"), x, ${e.prefix}_perform64, 0, NULL);
+    % else:
+    // like pd's builtin *_perf8 routines, the unrolled variant is only
+    // used when the vector size allows it; the scalar loop is the fallback.
+    % if e.signal_params:
+    if (maxvectorsize & 7) {
+        object_method(dsp64, gensym("dsp_add64"), x, connected ? ${e.prefix}_perform64_sig : ${e.prefix}_perform64, 0, NULL);
+    } else {
+        object_method(dsp64, gensym("dsp_add64"), x, connected ? ${e.prefix}_perf8_sig : ${e.prefix}_perf8, 0, NULL);
+    }
+    % else:
+    if (maxvectorsize & 7) {
+        object_method(dsp64, gensym("dsp_add64"), x, ${e.prefix}_perform64, 0, NULL);
+    } else {
+        object_method(dsp64, gensym("dsp_add64"), x, ${e.prefix}_perf8, 0, NULL);
+    }
+    % endif
+    % endif
 }
 
 
+<%
+    nch = e.n_channels
+    nsig = len(e.signal_params)
+    variants = [("", False), ("_sig", True)] if nsig else [("", False)]
+%>
+% if e.table_params:
+// samples of the buffer~ of a table param, locked for one perform call
+typedef struct _${e.prefix}_samples {
+    t_buffer_obj *obj;          // the buffer~, if its samples are locked
+    const float *vec;           // interleaved frames, or silence while there is no buffer~
+    long len;                   // frames
+    long nchans;                // channels of a frame
+} t_${e.prefix}_samples;
+
+// read in place of a missing buffer~, so reads never have to check for one
+static const float ${e.prefix}_silence[4] = {0, 0, 0, 0};
+
+// lock the samples of a buffer~ once per perform call, and unlock them before it returns
+static inline t_${e.prefix}_samples ${e.prefix}_samples_lock(t_buffer_ref *ref)
+{
+    t_${e.prefix}_samples b;
+    b.obj = buffer_ref_getobject(ref);
+    b.vec = b.obj ? buffer_locksamples(b.obj) : NULL;
+    if (!b.vec) {
+        b.obj = NULL;
+    } else {
+        b.len = (long)buffer_getframecount(b.obj);
+        b.nchans = (long)buffer_getchannelcount(b.obj);
+    }
+    if (!b.vec || b.len < 4) {
+        b.vec = ${e.prefix}_silence;
+        b.len = 4;
+        b.nchans = 1;
+    }
+    return b;
+}
+
+static inline void ${e.prefix}_samples_unlock(t_${e.prefix}_samples *b)
+{
+    if (b->obj) {
+        buffer_unlocksamples(b->obj);
+    }
+}
+
+// reads of channel `chan` of a locked buffer~ at a position in frames,
+// clamped to the buffer~: _read() truncates the position, _read_linear()
+// interpolates between 2 frames and _read_cubic() between 4 (hermite, so
+// like tabread4~ it clamps to [1, len - 2])
+static inline double ${e.prefix}_samples_read(const t_${e.prefix}_samples *b, long chan, double pos)
+{
+    long i = (long)pos;
+    i = (i < 0) ? 0 : (i >= b->len) ? b->len - 1 : i;
+    return b->vec[i * b->nchans + chan % b->nchans];
+}
+
+static inline double ${e.prefix}_samples_read_linear(const t_${e.prefix}_samples *b, long chan, double pos)
+{
+    const float *vec = b->vec + chan % b->nchans;
+    long nc = b->nchans;
+    pos = (pos < 0) ? 0 : (pos > b->len - 1) ? b->len - 1 : pos;
+    long i = (long)pos;
+    if (i > b->len - 2) {
+        i = b->len - 2;
+    }
+    double f = pos - i;
+    return vec[i * nc] + f * (vec[(i + 1) * nc] - vec[i * nc]);
+}
+
+static inline double ${e.prefix}_samples_read_cubic(const t_${e.prefix}_samples *b, long chan, double pos)
+{
+    const float *vec = b->vec + chan % b->nchans;
+    long nc = b->nchans;
+    pos = (pos < 1) ? 1 : (pos > b->len - 2) ? b->len - 2 : pos;
+    long i = (long)pos;
+    if (i > b->len - 3) {
+        i = b->len - 3;
+    }
+    double f = pos - i;
+    double y0 = vec[(i - 1) * nc], y1 = vec[i * nc], y2 = vec[(i + 1) * nc], y3 = vec[(i + 2) * nc];
+    double c1 = 0.5 * (y2 - y0);
+    double c2 = y0 - 2.5 * y1 + 2 * y2 - 0.5 * y3;
+    double c3 = 0.5 * (y3 - y0) + 1.5 * (y1 - y2);
+    return ((c3 * f + c2) * f + c1) * f + y1;
+}
+
+% endif
+% if e.dsp_outlets:
+// report clock: send the values last reported to each from_dsp outlet,
+// unless it was sent less than its rate ago, and arm the clock again for
+// the outlets which have to wait. The armed flag is cleared before the
+// ring is read, so a report queued after that arms the clock itself.
+void ${e.prefix}_report_tick(t_${e.prefix} *x)
+{
+    t_${e.prefix}_report r;
+    double now = gettime_forobject((t_object *)x);
+    double wait = -1;   // ms until the next waiting outlet is due (-1: none waits)
+
+    xt_exchange(&x->report_armed, 0);
+    while (xt_ring_read_space(&x->report_ring) >= sizeof(r)) {
+        xt_ring_read(&x->report_ring, &r, sizeof(r));
+        switch (r.outlet) {
+        % for i, o in enumerate(e.dsp_outlets):
+        case ${i}:
+            for (long k = 0; k < ${o.size}; k++) {
+                atom_setfloat(x->out_${o.name}_atoms + k, r.values[k]);
+            }
+            x->out_${o.name}_pending = 1;
+            break;
+        % endfor
+        default:
+            break;
+        }
+    }
+    % for o in e.dsp_outlets:
+    if (x->out_${o.name}_pending) {
+        double since = now - x->out_${o.name}_sent;
+        if (since >= ${o.rate}) {
+            x->out_${o.name}_pending = 0;
+            x->out_${o.name}_sent = now;
+            % if o.type == "float":
+            outlet_float(x->out_${o.name}, atom_getfloat(x->out_${o.name}_atoms));
+            % else:
+            outlet_list(x->out_${o.name}, NULL, ${o.size}, x->out_${o.name}_atoms);
+            % endif
+        } else if (wait < 0 || ${o.rate} - since < wait) {
+            wait = ${o.rate} - since;
+        }
+    }
+    % endfor
+    if (wait >= 0 && !xt_exchange(&x->report_armed, 1)) {
+        clock_fdelay(x->report_clock, wait);
+    }
+}
+
+// (perform routines) report values to a from_dsp outlet: the report is
+// queued (or dropped while REPORT_QUEUE reports wait) and the clock armed
+// unless it already is, so reporting every vector costs a copy and an
+// atomic exchange. Reports the clock has not sent yet are replaced.
+% for i, o in enumerate(e.dsp_outlets):
+% if o.type == "float":
+static inline void ${e.prefix}_report_${o.name}(t_${e.prefix} *x, double f)
+% else:
+static inline void ${e.prefix}_report_${o.name}(t_${e.prefix} *x, const double *values)   // ${o.size} values
+% endif
+{
+    t_${e.prefix}_report r;
+    r.outlet = ${i};
+    % if o.type == "float":
+    r.values[0] = f;
+    % else:
+    memcpy(r.values, values, ${o.size} * sizeof(double));
+    % endif
+    if (xt_ring_write_space(&x->report_ring) >= sizeof(r)) {
+        xt_ring_write(&x->report_ring, &r, sizeof(r));
+    }
+    if (!xt_exchange(&x->report_armed, 1)) {
+        clock_fdelay(x->report_clock, 0);
+    }
+}
+
+% endfor
+% endif
+// begin a block of n samples: ${"pick up the params published by the setters, " if e.handoff else ""}recompute
+// the derived coefficients of params flagged as dirty and advance the ramps
+// of smoothed params, so that a ramp ends on its target after `ramp` samples
+// (or at the end of the block in which it runs out)
+static void ${e.prefix}_prepare(t_${e.prefix} *x, long n)
+{
+    % if e.denormal_dc:
+    x->denormal_bias = -x->denormal_bias;
+    % endif
+    % if e.recomputed_params:
+    // take the flags once: a setter running meanwhile flags the next block
+    unsigned long dirty = x->dirty.exchange(0, std::memory_order_acquire);
+    % endif
+    % if e.smoothed_params and not e.handoff:
+    unsigned long retarget = x->retarget.exchange(0, std::memory_order_acquire);
+    % for p in e.smoothed_params:
+    if (retarget & ${p.ramp_flag}) {
+        x->${p.name}_togo = x->${p.name}_ramp;
+    }
+    % endfor
+    % endif
+    % if e.handoff:
+    t_${e.prefix}_params snap;
+    if (${e.prefix}_params_read(x, &snap)) {
+        % for p in e.variable_params:
+        if (snap.${p.name} != x->${p.name}) {
+            x->${p.name} = snap.${p.name};
+            % if p.recompute:
+            dirty |= ${p.dirty_flag};
+            % endif
+            % if p.smooth:
+            x->${p.name}_togo = x->${p.name}_ramp;
+            % endif
+        }
+        % endfor
+    }
+    % endif
+    % if e.recomputed_params:
+    if (dirty) {
+        % for p in e.recomputed_params:
+        if (dirty & ${p.dirty_flag}) {
+            ${p.recompute.strip()}
+        }
+        % endfor
+    }
+    % endif
+    % for p in e.smoothed_params:
+    if (x->${p.name}_togo > 0) {
+        long m = (x->${p.name}_togo > n) ? x->${p.name}_togo : n;
+        x->${p.name}_step = (x->${p.name} - x->${p.name}_cur) / m;
+        x->${p.name}_togo = (x->${p.name}_togo > n) ? x->${p.name}_togo - n : 0;
+    } else {
+        x->${p.name}_cur = x->${p.name};
+        x->${p.name}_step = 0.0;
+    }
+    % endfor
+}
+% if e.events:
+
+// apply the queued events due at frame i of the block of n samples, returns
+// the frame of the next event in the block (or n if there is none)
+static long ${e.prefix}_events_due(t_${e.prefix} *x, long i, long n)
+{
+    const t_xt_event *ev;
+    while ((ev = xt_events_peek(&x->events)) && ev->time < x->event_end) {
+        long at = xt_event_frame(ev, x->event_start, x->sr, (int)i, (int)n);
+        if (at > i) {
+            return at;
+        }
+        ${e.prefix}_event_apply(x, ev->id, ev->value);
+        xt_events_pop(&x->events);
+    }
+    return n;
+}
+% endif
+
+
+% if e.multichannel:
+% for suffix, vector in variants:
+// multichannel perform routine: processes all channels in one call${"," if e.signal_params else ""}
+% if vector:
+// used when a signal is connected to a param inlet.
+% elif e.signal_params:
+// used when no signal is connected to a param inlet.
+% endif
+// ins holds the channels of the multichannel inlet followed by the param
+// inlets. Channels are the inner loop, so per-channel state is read from
+// contiguous arrays and the loop can be vectorized across channels.
+void ${e.prefix}_perform64${suffix}(t_${e.prefix} *x, t_object *dsp64, double **ins, long numins, double **outs, long numouts, long sampleframes, long flags, void *userparam)
+{
+    long nchans = (x->state_nchans < numouts) ? x->state_nchans : numouts;
+    % for st in e.state:
+    double *RESTRICT ${st.name} = x->${st.name};
+    % endfor
+    long n = sampleframes;
+    XT_PROFILE_BEGIN();
+    % if e.denormal_ftz:
+    t_xt_fpmode fpmode = xt_ftz_begin();
+    % endif
+
+    ${e.prefix}_prepare(x, n);
+    % if e.denormal_dc:
+    t_double bias = x->denormal_bias;
+    % endif
+    % for p in e.frame_params:
+    % if p.smooth:
+    t_double ${p.name}_0 = x->${p.name}_cur, ${p.name}_step = x->${p.name}_step;
+    % else:
+    t_double ${p.name}_0 = x->${p.name};
+    % endif
+    % endfor
+    % if vector:
+    % for j, p in enumerate(e.signal_params):
+    t_double *${p.name}_in = x->${p.name}_connected ? ins[numins - ${nsig - j}] : NULL;
+    % endfor
+    % endif
+
+    for (long i = 0; i < n; i++) {
+        % for p in e.frame_params:
+        t_double ${p.name} = ${p.sample_value(0, vector)};
+        % endfor
+        for (long c = 0; c < nchans; c++) {
+            t_double f = ins[c][i]${dc};
+            outs[c][i] = f;
+        }
+    }
+    % if e.smoothed_params:
+
+    % for p in e.smoothed_params:
+    x->${p.name}_cur = ${p.name}_0 + ${p.name}_step * n;
+    % endfor
+    % endif
+    % if e.denormal_ftz:
+    xt_ftz_end(fpmode);
+    % endif
+    XT_PROFILE_END(&x->profile);
+}
+
+
+% endfor
+% elif e.poly:
+% for suffix, vector in variants:
+// polyphonic perform routine: mixes the playing voices onto the inputs${"," if e.signal_params else "."}
+% if vector:
+// used when a signal is connected to a param inlet.
+% elif e.signal_params:
+// used when no signal is connected to a param inlet.
+% endif
+// Voices are processed in groups of POLY_LANES: the voice arrays are
+// structures of arrays, so the inner loop over the lanes of a group reads
+// contiguous memory and can be vectorized across voices, with idle lanes
+// muted by their gate. Groups without a playing voice are skipped.
+void ${e.prefix}_perform64${suffix}(t_${e.prefix} *x, t_object *dsp64, double **ins, long numins, double **outs, long numouts, long sampleframes, long flags, void *userparam)
+{
+    % for c in range(nch):
+    t_double *in${c} = ins[${c}];
+    % endfor
+    % for c in range(nch):
+    t_double *out${c} = outs[${c}];
+    % endfor
+    long n = sampleframes;
+    XT_PROFILE_BEGIN();
+    % if e.denormal_ftz:
+    t_xt_fpmode fpmode = xt_ftz_begin();
+    % endif
+
+    ${e.prefix}_prepare(x, n);
+    % if e.denormal_dc:
+    t_double bias = x->denormal_bias;
+    % endif
+    % for p in e.frame_params:
+    % if p.smooth:
+    t_double ${p.name}_0 = x->${p.name}_cur, ${p.name}_step = x->${p.name}_step;
+    % else:
+    t_double ${p.name}_0 = x->${p.name};
+    % endif
+    % endfor
+    % if vector:
+    % for j, p in enumerate(e.signal_params):
+    t_double *${p.name}_in = x->${p.name}_connected ? ins[${nch + j}] : NULL;
+    % endfor
+    % endif
+
+    // the inputs pass through (ins and outs never alias, see Z_NO_INPLACE),
+    // the voices are added on top
+    for (long i = 0; i < n; i++) {
+        % for c in range(nch):
+        out${c}[i] = in${c}[i]${dc};
+        % endfor
+    }
+
+    for (long g = 0; g < POLY_GROUPS; g++) {
+        if (!x->poly_active[g]) {
+            continue;
+        }
+        const double *RESTRICT note = x->poly_note + g * POLY_LANES;
+        const double *RESTRICT velocity = x->poly_velocity + g * POLY_LANES;
+        const double *RESTRICT gate = x->poly_gate + g * POLY_LANES;
+        % for p in e.voice_params:
+        const double *RESTRICT ${p.name} = x->${p.name} + g * POLY_LANES;
+        % endfor
+        % for st in e.state:
+        double *RESTRICT ${st.name} = x->${st.name} + g * POLY_LANES;
+        % endfor
+
+        for (long i = 0; i < n; i++) {
+            % for p in e.frame_params:
+            t_double ${p.name} = ${p.sample_value(0, vector)};
+            % endfor
+            t_double mix = 0.0;
+            for (long l = 0; l < POLY_LANES; l++) {
+                t_double v = 0.0;   // sample of voice l of the group
+                mix += gate[l] * v;
+            }
+            % for c in range(nch):
+            out${c}[i] += mix;
+            % endfor
+        }
+    }
+    % if e.smoothed_params:
+
+    % for p in e.smoothed_params:
+    x->${p.name}_cur = ${p.name}_0 + ${p.name}_step * n;
+    % endfor
+    % endif
+    % if e.denormal_ftz:
+    xt_ftz_end(fpmode);
+    % endif
+    XT_PROFILE_END(&x->profile);
+}
+
+
+% endfor
+% elif e.spectral:
+// process the spectrum of channel c in place: bins[0] and bins[1] are the
+// real dc and nyquist bins, bins[2 k] and bins[2 k + 1] the real and
+// imaginary parts of bin k (0 < k < SPECTRAL_SIZE / 2). A spectrum left
+// unchanged resynthesizes the input.
+static void ${e.prefix}_spectrum(t_${e.prefix} *x, double *RESTRICT bins, long c)
+{
+    for (long k = 1; k < SPECTRAL_SIZE / 2; k++) {
+        double re = bins[2 * k], im = bins[2 * k + 1];
+        bins[2 * k] = re;
+        bins[2 * k + 1] = im;
+    }
+}
+
+// works for any vector size, hops may span vectors and vectors may hold
+// several hops: the vector is copied through the frames in spans ending on
+// a hop, and every hop transforms the frames of all channels with the plan
+// made in _dsp64, so nothing is allocated or planned here
 void ${e.prefix}_perform64(t_${e.prefix} *x, t_object *dsp64, double **ins, long numins, double **outs, long numouts, long sampleframes, long flags, void *userparam)
 {
-    t_double *inL = ins[0];     // we get audio for each inlet of the object from the **ins argument
-    t_double *inR = ins[1];     // we get audio for each inlet of the object from the **ins argument
-    t_double *outL = outs[0];   // we get audio for each outlet of the object from the **outs argument
-    t_double *outR = outs[1];   // we get audio for each outlet of the object from the **outs argument
+    % for c in range(nch):
+    t_double *in${c} = ins[${c}];
+    % endfor
+    % for c in range(nch):
+    t_double *out${c} = outs[${c}];
+    % endfor
+    long n = sampleframes;
+    long m;
+    XT_PROFILE_BEGIN();
+    % if e.denormal_ftz:
+    t_xt_fpmode fpmode = xt_ftz_begin();
+    % endif
+
+    ${e.prefix}_prepare(x, n);
+    for (long i = 0; i < n; i += m) {
+        m = (long)xt_stft_span(&x->stft, (uint32_t)(n - i));
+        % for c in range(nch):
+        xt_stft_write(&x->stft, ${c}, in${c} + i, (uint32_t)m);
+        % endfor
+        % for c in range(nch):
+        xt_stft_read(&x->stft, ${c}, out${c} + i, (uint32_t)m);
+        % endfor
+        if (xt_stft_advance(&x->stft, (uint32_t)m)) {
+            % for c in range(nch):
+            ${e.prefix}_spectrum(x, xt_stft_analyze(&x->stft, ${c}), ${c});
+            xt_stft_synthesize(&x->stft, ${c});
+            % endfor
+        }
+    }
+
+    % if e.denormal_ftz:
+    xt_ftz_end(fpmode);
+    % endif
+    XT_PROFILE_END(&x->profile);
+}
+
+% else:
+% for suffix, vector in variants:
+% if vector:
+// used when a signal is connected to a param inlet
+% elif e.signal_params:
+// used when no signal is connected to a param inlet
+% endif
+void ${e.prefix}_perform64${suffix}(t_${e.prefix} *x, t_object *dsp64, double **ins, long numins, double **outs, long numouts, long sampleframes, long flags, void *userparam)
+{
+    % for c in range(nch):
+    t_double *in${c} = ins[${c}];       // we get audio for each inlet of the object from the **ins argument
+    % endfor
+    % for c in range(nch):
+    t_double *out${c} = outs[${c}];     // we get audio for each outlet of the object from the **outs argument
+    % endfor
+    long n = sampleframes;      // n = 64
+    % for p in e.table_params:
+    t_${e.prefix}_samples ${p.name} = ${e.prefix}_samples_lock(x->${p.name}_ref);    // read with ${e.prefix}_samples_read*(&${p.name}, chan, pos)
+    % endfor
+    XT_PROFILE_BEGIN();
+    % if e.denormal_ftz:
+    t_xt_fpmode fpmode = xt_ftz_begin();
+    % endif
+    % if e.events:
+    % if vector:
+
+    % for j, p in enumerate(e.signal_params):
+    t_double *${p.name}_in = x->${p.name}_connected ? ins[${nch + j}] : NULL;
+    % endfor
+    % endif
+
+    // the block is split at the frames of its events, each span is begun
+    // like a block of its own (smoothed params keep their `_0` origin at
+    // frame 0, so sample_value() holds for the frames of any span)
+    x->event_start = x->event_end;
+    x->event_end = gettime_forobject((t_object *)x);
+    for (long start = 0, end; start < n; start = end) {
+        end = ${e.prefix}_events_due(x, start, n);
+        ${e.prefix}_prepare(x, end - start);
+        % if e.denormal_dc:
+        t_double bias = x->denormal_bias;
+        % endif
+        % for p in e.frame_params:
+        % if p.smooth:
+        t_double ${p.name}_step = x->${p.name}_step, ${p.name}_0 = x->${p.name}_cur - ${p.name}_step * start;
+        % else:
+        t_double ${p.name}_0 = x->${p.name};
+        % endif
+        % endfor
+
+        // inputs and outputs of a frame are read before any output is written
+        for (long i = start; i < end; i++) {
+            % for p in e.frame_params:
+            t_double ${p.name} = ${p.sample_value(0, vector)};
+            % endfor
+            % for c in range(nch):
+            t_double f${c} = in${c}[i]${dc};
+            % endfor
+            % for c in range(nch):
+            out${c}[i] = f${c};
+            % endfor
+        }
+        % for p in e.smoothed_params:
+        x->${p.name}_cur = ${p.name}_0 + ${p.name}_step * end;
+        % endfor
+    }
+    % else:
+
+    ${e.prefix}_prepare(x, n);
+    % if e.denormal_dc:
+    t_double bias = x->denormal_bias;
+    % endif
+    % for p in e.frame_params:
+    % if p.smooth:
+    t_double ${p.name}_0 = x->${p.name}_cur, ${p.name}_step = x->${p.name}_step;
+    % else:
+    t_double ${p.name}_0 = x->${p.name};
+    % endif
+    % endfor
+    % if vector:
+    % for j, p in enumerate(e.signal_params):
+    t_double *${p.name}_in = x->${p.name}_connected ? ins[${nch + j}] : NULL;
+    % endfor
+    % endif
+
+    // inputs and outputs of a frame are read before any output is written
+    for (long i = 0; i < n; i++) {
+        % for p in e.frame_params:
+        t_double ${p.name} = ${p.sample_value(0, vector)};
+        % endfor
+        % for c in range(nch):
+        t_double f${c} = in${c}[i]${dc};
+        % endfor
+        % for c in range(nch):
+        out${c}[i] = f${c};
+        % endfor
+    }
+    % if e.smoothed_params:
+
+    % for p in e.smoothed_params:
+    x->${p.name}_cur = ${p.name}_0 + ${p.name}_step * n;
+    % endfor
+    % endif
+    % endif
+    % if e.denormal_ftz:
+    xt_ftz_end(fpmode);
+    % endif
+    XT_PROFILE_END(&x->profile);
+    % for p in e.table_params:
+    ${e.prefix}_samples_unlock(&${p.name});
+    % endfor
+}
+
+
+void ${e.prefix}_perf8${suffix}(t_${e.prefix} *x, t_object *dsp64, double **ins, long numins, double **outs, long numouts, long sampleframes, long flags, void *userparam)
+{
+    % for c in range(nch):
+    const t_double *RESTRICT in${c} = ins[${c}];
+    % endfor
+    % for c in range(nch):
+    t_double *RESTRICT out${c} = outs[${c}];
+    % endfor
+    long n = sampleframes;
+    long i = 0;
+    % if e.events:
+
+    // the scalar routine splits a block with events at their frames
+    if (xt_events_peek(&x->events)) {
+        ${e.prefix}_perform64${suffix}(x, dsp64, ins, numins, outs, numouts, sampleframes, flags, userparam);
+        return;
+    }
+    % endif
+    % for p in e.table_params:
+    t_${e.prefix}_samples ${p.name} = ${e.prefix}_samples_lock(x->${p.name}_ref);
+    % endfor
+    XT_PROFILE_BEGIN();
+    % if e.denormal_ftz:
+    t_xt_fpmode fpmode = xt_ftz_begin();
+    % endif
+    % if e.events:
 
-    int n = sampleframes;       // n = 64
+    x->event_start = x->event_end;
+    x->event_end = gettime_forobject((t_object *)x);
+    % endif
 
-    while (n--) {
-        *outL++ = *inL++;
-        *outR++ = *inR++;
+    ${e.prefix}_prepare(x, n);
+    % if e.denormal_dc:
+    t_double bias = x->denormal_bias;
+    % endif
+    % for p in e.frame_params:
+    % if p.smooth:
+    t_double ${p.name}_0 = x->${p.name}_cur, ${p.name}_step = x->${p.name}_step;
+    % else:
+    t_double ${p.name}_0 = x->${p.name};
+    % endif
+    % endfor
+    % if vector:
+    % for j, p in enumerate(e.signal_params):
+    const t_double *RESTRICT ${p.name}_in = x->${p.name}_connected ? ins[${nch + j}] : NULL;
+    % endfor
+    % endif
+
+    // unrolled by 8 so the compiler can vectorize the loop
+    for (; i + 8 <= n; i += 8) {
+        % for k in range(8):
+        {
+            % for p in e.frame_params:
+            t_double ${p.name} = ${p.sample_value(k, vector)};
+            % endfor
+            % for c in range(nch):
+            out${c}[i + ${k}] = in${c}[i + ${k}]${dc};
+            % endfor
+        }
+        % endfor
+    }
+
+    // a vector that is shorter than maxvectorsize may leave a tail
+    for (; i < n; i++) {
+        % for p in e.frame_params:
+        t_double ${p.name} = ${p.sample_value(0, vector)};
+        % endfor
+        % for c in range(nch):
+        out${c}[i] = in${c}[i]${dc};
+        % endfor
     }
+    % if e.smoothed_params:
+
+    % for p in e.smoothed_params:
+    x->${p.name}_cur = ${p.name}_0 + ${p.name}_step * n;
+    % endfor
+    % endif
+    % if e.denormal_ftz:
+    xt_ftz_end(fpmode);
+    % endif
+    XT_PROFILE_END(&x->profile);
+    % for p in e.table_params:
+    ${e.prefix}_samples_unlock(&${p.name});
+    % endfor
 }
+
+
+% endfor
+% endif
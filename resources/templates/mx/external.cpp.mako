@@ -15,6 +15,8 @@
 #include "ext_obex.h"
 #include "z_dsp.h"
 
+#include <stdint.h>
+
 #define N_CHANNELS ${e.n_channels}
 
 typedef struct _${e.prefix} {
@@ -29,9 +31,6 @@ typedef struct _${e.prefix} {
     % for o in e.outlets:
     t_outlet *out_${o.name};
     % endfor
-
-    double feedback;            // controls the reverb time, reverb tail becomes infinite when set to 1.0 (range 0.0 to 1.0)
-    double lp_freq;             // controls the internal dampening filter's cutoff frequency. (range: 0.0 to sample_rate / 2)
 } t_${e.prefix};
 
 
@@ -41,6 +40,9 @@ void ${e.prefix}_free(t_${e.prefix} *x);
 void ${e.prefix}_assist(t_${e.prefix} *x, void *b, long m, long a, char *s);
 void ${e.prefix}_bang(t_${e.prefix} *x);
 void ${e.prefix}_anything(t_${e.prefix}* x, t_symbol* s, long argc, t_atom* argv);
+% for m in e.message_methods:
+void ${e.prefix}_${m.name}(t_${e.prefix} *x, t_symbol *s, long argc, t_atom *argv);
+% endfor
 void ${e.prefix}_dsp64(t_${e.prefix} *x, t_object *dsp64, short *count, double samplerate, long maxvectorsize, long flags);
 void ${e.prefix}_perform64(t_${e.prefix} *x, t_object *dsp64, double **ins, long numins, double **outs, long numouts, long sampleframes, long flags, void *userparam);
 
@@ -49,6 +51,55 @@ void ${e.prefix}_perform64(t_${e.prefix} *x, t_object *dsp64, double **ins, long
 static t_class *${e.prefix}_class = NULL;
 
 
+// selector symbols, interned once in ext_main
+% for m in e.message_methods + e.dispatch_params:
+static t_symbol *${m.symbol} = NULL;
+% endfor
+
+// selectors handled by ${e.prefix}_anything
+enum {
+    SEL_NONE = 0,
+    % for m in e.message_methods + e.dispatch_params:
+    ${m.selector},
+    % endfor
+};
+
+// open-addressed table mapping interned symbol pointers to selectors
+#define SELTABLE_SIZE ${e.selector_table_size}
+
+static struct {
+    t_symbol *sym;
+    long sel;
+} ${e.prefix}_seltable[SELTABLE_SIZE];
+
+static inline long ${e.prefix}_selhash(t_symbol *s)
+{
+    return (long)(((uintptr_t)s >> 4) & (SELTABLE_SIZE - 1));
+}
+
+static void ${e.prefix}_seltable_add(t_symbol *s, long sel)
+{
+    long h = ${e.prefix}_selhash(s);
+    while (${e.prefix}_seltable[h].sym) {
+        h = (h + 1) & (SELTABLE_SIZE - 1);
+    }
+    ${e.prefix}_seltable[h].sym = s;
+    ${e.prefix}_seltable[h].sel = sel;
+}
+
+static inline long ${e.prefix}_seltable_find(t_symbol *s)
+{
+    long h = ${e.prefix}_selhash(s);
+    while (${e.prefix}_seltable[h].sym) {
+        if (${e.prefix}_seltable[h].sym == s) {
+            return ${e.prefix}_seltable[h].sel;
+        }
+        h = (h + 1) & (SELTABLE_SIZE - 1);
+    }
+    return SEL_NONE;
+}
+
+
 //-----------------------------------------------------------------------------------------------
 
 void ext_main(void *r)
@@ -64,6 +115,20 @@ void ext_main(void *r)
     class_addmethod(c, (method)${e.prefix}_dsp64,    "dsp64",    A_CANT,    0);
     class_addmethod(c, (method)${e.prefix}_assist,   "assist",   A_CANT,    0);
 
+    % if e.attrs:
+    // attributes
+    % for p in e.attrs:
+    CLASS_ATTR_FLOAT(c, "${p.name}", 0, t_${e.prefix}, ${p.name});
+    CLASS_ATTR_FILTER_CLIP(c, "${p.name}", ${p.min}, ${p.max});
+    % endfor
+
+    % endif
+    // intern selector symbols once, so that dispatch is a pointer lookup
+    % for m in e.message_methods + e.dispatch_params:
+    ${m.symbol} = gensym("${m.name}");
+    ${e.prefix}_seltable_add(${m.symbol}, ${m.selector});
+    % endfor
+
     class_dspinit(c);
     class_register(CLASS_BOX, c);
     ${e.prefix}_class = c;
@@ -80,10 +145,15 @@ void *${e.prefix}_new(t_symbol *s, long argc, t_atom *argv)
             post("signal outlet: %d", i);
             outlet_new(x, "signal");        // signal outlet (note "signal" rather than NULL)
         }
-        
-        x->rev = new daisysp::ReverbSc;
-        x->feedback = 100.0;
-        x->lp_freq = 0.5;
+
+        // initialize variables
+        % for p in e.params:
+        x->${p.name} = ${p.initial};
+        % endfor
+        % if e.attrs:
+
+        attr_args_process(x, (short)argc, argv);
+        % endif
     }
     return (x);
 }
@@ -91,7 +161,6 @@ void *${e.prefix}_new(t_symbol *s, long argc, t_atom *argv)
 
 void ${e.prefix}_free(t_${e.prefix} *x)
 {
-    delete x->rev;
     dsp_free((t_pxobject *)x);
 }
 
@@ -112,16 +181,33 @@ void ${e.prefix}_bang(t_${e.prefix} *x)
     post("bang");
 }
 
-void ${e.prefix}_anything(t_${e.prefix}* x, t_symbol* s, long argc, t_atom* argv)
+% for m in e.message_methods:
+void ${e.prefix}_${m.name}(t_${e.prefix} *x, t_symbol *s, long argc, t_atom *argv)
 {
-    if (s != gensym("") && argc > 0) {
-        if (s == gensym("feedback")) {
-            x->feedback = atom_getfloat(argv);
+    % if m.doc:
+    // ${m.doc}
+    % endif
+    post("${m.name} body");
+}
 
+% endfor
+void ${e.prefix}_anything(t_${e.prefix}* x, t_symbol* s, long argc, t_atom* argv)
+{
+    switch (${e.prefix}_seltable_find(s)) {
+    % for m in e.message_methods:
+    case ${m.selector}:
+        ${e.prefix}_${m.name}(x, s, argc, argv);
+        break;
+    % endfor
+    % for p in e.dispatch_params:
+    case ${p.selector}:
+        if (argc > 0) {
+            x->${p.name} = atom_getfloat(argv);
         }
-        else if (s == gensym("lp_freq")) {
-            x->lp_freq = atom_getfloat(argv);
-        }
+        break;
+    % endfor
+    default:
+        break;
     }
 }
 
@@ -132,8 +218,6 @@ void ${e.prefix}_dsp64(t_${e.prefix} *x, t_object *dsp64, short *count, double s
     // post("sample rate: %f", samplerate);
     // post("maxvectorsize: %d", maxvectorsize);
 
-    x->rev->Init(samplerate);
-
     object_method(dsp64, gensym("dsp_add64"), x, ${e.prefix}_perform64, 0, NULL);
 }
 
@@ -2,12 +2,59 @@
 
 lib.name = ${e.name}
 
-class.sources = ${e.name}.c
+class.sources = ${e.name}${"~" if e.is_dsp else ""}.c
 
 datafiles = ${e.name}-help.pd README.md
 
 suppress-wunused = true
 
+# build profile: make PROFILE=release|debug. CFLAGS given on the command
+# line still replace the flags of the profile (and pd-lib-builder's).
+PROFILE ?= ${e.build.profile}
+MARCH ?=
+
+# the binary is portable by default: MARCH (e.g. native) tunes it for a cpu,
+# replacing the -march or -mcpu of pd-lib-builder's arch.c.flags
+march.flags = $(if $(MARCH),$(filter-out -march=% -mcpu=%,$(arch.c.flags)) -march=$(MARCH),$(arch.c.flags))
+
+profile.release.flags = ${e.build.release_flags}
+profile.release.ldflags = ${"$(march.flags) $(profile.release.flags)" if e.build.lto else ""}
+profile.debug.flags = -O0 -g
+profile.debug.ldflags =
+
+ifneq ($(origin CFLAGS), command line)
+override CFLAGS = $(warn.flags) $(march.flags) $(profile.$(PROFILE).flags) $(pgo.flags)
+endif
+ldflags = $(profile.$(PROFILE).ldflags) $(pgo.flags)
+% if e.threaded:
+
+ldlibs = -lpthread
+% endif
+
+% if e.signal_params:
+# the signal inlets include pd's m_imp.h and g_canvas.h, which xtgen does not
+# bundle (only m_pd.h): PDINCLUDEDIR must point at the headers of a full pd,
+# the src/ of a pd source tree or the include/pd of an installed pd
+# (pd-lib-builder's default)
+% endif
 include Makefile.pdlibbuilder
+% if e.is_dsp:
+
+# profile-guided build (gcc): the benchmark harness, built with
+# -fprofile-generate, runs the perform routines as the training workload,
+# then the external is rebuilt with the profile written by the run
+pgo.train = -n 64,256,1024 -i 1,16
+pgo.use = -fprofile-use -fprofile-correction -Wno-missing-profile -Wno-error=coverage-mismatch
+
+pgo:
+	$(MAKE) -C bench clean
+	$(MAKE) -C bench bench OPT="$(march.flags) $(profile.release.flags) -fprofile-generate"
+	cd bench && ./bench $(pgo.train) > /dev/null
+	cp bench/${e.name}~.gcda .
+	$(MAKE) clean
+	$(MAKE) PROFILE=release pgo.flags="$(pgo.use)"
+
+.PHONY: pgo
+% endif
 
  
@@ -0,0 +1,34 @@
+# Makefile for the ${e.name}~ benchmark harness (see xtbench.h)
+#
+# links the generated perform routines against stubs of the pd api:
+#
+#   make run                                    # default configurations
+#   make CPPFLAGS=-I<dir> LDLIBS=-l<lib> ...    # external dsp libraries
+#   ./bench -n 64,256,1024 -i 1,16,128 -f csv   # custom configurations
+#   make FLOATSIZE=64 clean run                 # double precision build
+#
+# built with the flags of the release profile of ../Makefile by default,
+# for the cpu of MARCH (e.g. make MARCH=native) if it is given.
+
+CC ?= cc
+MARCH ?=
+OPT ?= ${e.build.release_flags}$(if $(MARCH), -march=$(MARCH))
+FLOATSIZE ?= 32
+
+CFLAGS = -std=gnu99 $(OPT) -I. -DPD_FLOATSIZE=$(FLOATSIZE) -DXT_SETUP=${e.c_name}_setup
+
+bench: xtbench_pd.c xtbench.h ${e.name}~.o
+	$(CC) $(CFLAGS) $(CPPFLAGS) -o $@ xtbench_pd.c ${e.name}~.o $(LDFLAGS) $(LDLIBS) -lm${" -pthread" if e.threaded else ""}
+
+# compiled on its own and from .. like the external, so that the profile
+# of a pgo run (${e.name}~.gcda) matches the external's build
+${e.name}~.o: ../${e.name}~.c
+	cd .. && $(CC) -Ibench $(CFLAGS) $(CPPFLAGS) -c -o bench/$@ ${e.name}~.c
+
+run: bench
+	./bench -n 64,256,1024 -i 1,16,128
+
+clean:
+	@rm -f bench ${e.name}~.o *.gcda
+
+.PHONY: run clean
@@ -11,9 +11,114 @@ Author: ${e.meta['author']}
 Repo: ${e.meta['repo']}
 
 */
+<%
+    kern = e.kernel("pd")
+    dc = " + bias" if e.denormal_dc else ""    # denormal offset of the input reads
+%>
+#include <math.h>
+% if kern:
+#include <stdint.h>
+% endif
 
 #include "m_pd.h"
+% if e.signal_params:
+#include "m_imp.h"      // obj_findsignalscalar(), obj_issignaloutlet()
+#include "g_canvas.h"   // linetraverser_*()
+% endif
+% if e.delay_params or e.tables or e.events or e.threaded or e.spectral or e.dsp_outlets:
 
+#define XT_SAMPLE t_sample
+% if e.delay_params:
+#include "xtgen_ring.h"     // delay lines of delay params
+% elif e.dsp_outlets:
+#include "xtgen_ring.h"     // report ring of the from_dsp outlets
+% endif
+% if e.tables:
+#include "xtgen_table.h"    // lookup tables shared by all instances
+% endif
+% if e.events:
+#define XT_EVENT_QUEUE ${e.events}
+#include "xtgen_event.h"    // param changes applied at their sample
+% endif
+% if e.threaded:
+#include "xtgen_thread.h"   // worker thread of the perform routine
+% endif
+% if e.spectral:
+#include "xtgen_fft.h"      // short-time fourier transform of spectral frames
+% endif
+% endif
+% if lib:
+
+#include "${lib.name}.h"   // symbols and lookup tables shared by the classes of ${lib.name}
+% endif
+% if kern and kern.header:
+
+#include "${kern.header}"
+% endif
+
+#define N_CHANNELS ${e.n_channels}
+% if kern:
+#define KERNEL_ALIGN ${kern.align}
+% endif
+% if e.spectral:
+
+/* spectral frames: SPECTRAL_SIZE samples (${e.spectral.window} window) every SPECTRAL_HOP samples */
+#define SPECTRAL_SIZE ${e.spectral.size}
+#define SPECTRAL_OVERLAP ${e.spectral.overlap}
+#define SPECTRAL_HOP (SPECTRAL_SIZE / SPECTRAL_OVERLAP)
+% endif
+% if e.dsp_outlets:
+
+/* reports of the perform routine to the from_dsp outlets: up to REPORT_QUEUE
+ * reports of at most REPORT_SIZE values wait for the report clock */
+#define REPORT_QUEUE 64
+#define REPORT_SIZE ${e.report_size}
+% endif
+% if e.poly:
+
+/* voice pool: voices are processed in groups of POLY_LANES (the samples of
+ * one simd register), the pool is padded to whole groups */
+#define POLY_VOICES ${e.poly}
+#if PD_FLOATSIZE == 64
+#define POLY_LANES 4
+#else
+#define POLY_LANES 8
+#endif
+#define POLY_GROUPS ((POLY_VOICES + POLY_LANES - 1) / POLY_LANES)
+#define POLY_SLOTS (POLY_GROUPS * POLY_LANES)
+% endif
+
+#if defined(_MSC_VER)
+#define RESTRICT __restrict
+#else
+#define RESTRICT __restrict__
+#endif
+
+#ifdef XT_PROFILE
+#include "xtgen_profile.h"  // dsp-load stats of the perform routine
+#else
+#define XT_PROFILE_BEGIN()
+#define XT_PROFILE_END(p)
+#endif
+% if e.denormal_ftz:
+
+#include "xtgen_denormal.h"    // flush-to-zero guard of the perform routines
+% endif
+% if e.denormal_dc:
+
+/* offset added to the inputs, with a sign flipping every block so no dc
+ * builds up, which keeps decaying feedback paths above the subnormal range */
+#define DENORMAL_BIAS 1e-20
+% endif
+
+% if e.recomputed_params:
+/* dirty flags of params whose derived coefficients are stale */
+% for i, p in enumerate(e.recomputed_params):
+#define ${p.dirty_flag} (1UL << ${i})
+% endfor
+#define DIRTY_ALL ((1UL << ${len(e.recomputed_params)}) - 1)
+
+% endif
 /*
  * ${e.name} class object
  * ---------------------------------------------------------------------------
@@ -21,6 +126,86 @@ Repo: ${e.meta['repo']}
 
 static t_class *${e.name}_tilde_class;
 
+% if e.tables and not lib:
+/* lookup tables shared by all instances: filled when the first instance is
+ * created and freed with the last one */
+% for t in e.tables:
+static t_xt_table ${e.name}_tilde_${t.name};  // ${t.desc or t.source}
+% endfor
+static int ${e.name}_tilde_table_refs;
+% for t in e.tables:
+% if t.points:
+
+static const t_sample ${e.name}_tilde_${t.name}_points[${t.size}] = {
+% for i in range(0, t.size, 8):
+    ${", ".join(t.points[i:i + 8])},
+% endfor
+};
+% endif
+% endfor
+
+static void ${e.name}_tilde_tables_acquire(void)
+{
+    if (${e.name}_tilde_table_refs++)
+        return;
+    % for t in e.tables:
+    xt_table_init(&${e.name}_tilde_${t.name}, getbytes(xt_table_bytes(${t.size})), ${t.size});
+    % if t.source == "sine":
+    xt_table_fill_sine(&${e.name}_tilde_${t.name});
+    % elif t.source == "saw":
+    xt_table_fill_saw(&${e.name}_tilde_${t.name}, ${t.harmonics});
+    % else:
+    for (uint32_t i = 0; i < ${t.size}; i++) {
+        % if t.source == "expr":
+        double p = (double)i / ${t.size};
+        ${e.name}_tilde_${t.name}.data[i] = (t_sample)(${t.expr});
+        % else:
+        ${e.name}_tilde_${t.name}.data[i] = ${e.name}_tilde_${t.name}_points[i];
+        % endif
+    }
+    xt_table_guard(&${e.name}_tilde_${t.name});
+    % endif
+    % endfor
+}
+
+static void ${e.name}_tilde_tables_release(void)
+{
+    if (--${e.name}_tilde_table_refs)
+        return;
+    % for t in e.tables:
+    freebytes(${e.name}_tilde_${t.name}.mem, ${e.name}_tilde_${t.name}.nbytes);
+    % endfor
+}
+
+% endif
+% if e.smoothed_params:
+/* length of a ramp of `ms` milliseconds in samples (at least 1) */
+static int ${e.name}_tilde_ramp_samples(t_float ms, t_float sr)
+{
+    int n = (int)(ms * sr / 1000.);
+    return (n < 1) ? 1 : n;
+}
+
+% endif
+% if e.threaded:
+/* params as written by the setters, copied into the object for the worker
+ * thread by the perform routine of the dsp thread */
+typedef struct _${e.name}_tilde_params {
+    % for p in e.variable_params:
+    ${p.struct_declaration};
+    % endfor
+} t_${e.name}_tilde_params;
+
+% endif
+% if e.dsp_outlets:
+/* a report of the perform routine to a from_dsp outlet */
+typedef struct _${e.name}_tilde_report {
+    int outlet;                     // index of the outlet among the from_dsp outlets
+    t_float values[REPORT_SIZE];    // the first `size` values of the outlet are used
+} t_${e.name}_tilde_report;
+
+% endif
+
 
 /*
  * ${e.name} class struct (data-space)
@@ -32,9 +217,160 @@ typedef struct _${e.name}_tilde {
     t_float x_f; // main signal in
 
     /* parameters */
-    % for p in e.params:
+    % for p in e.object_params:
     ${p.struct_declaration};
     % endfor
+    % if e.recomputed_params:
+
+    /* derived coefficients */
+    % for p in e.recomputed_params:
+    % for d in p.derived_declarations:
+    ${d};
+    % endfor
+    % endfor
+    unsigned long dirty; // DIRTY_* flags, cleared once per block
+    % endif
+    % if e.smoothed_params:
+
+    /* smoothed params */
+    % for p in e.smoothed_params:
+    t_sample ${p.name}_cur;  // ramp value at the start of the block
+    t_sample ${p.name}_step; // ramp increment per sample
+    int ${p.name}_togo;      // samples left until the target is reached
+    int ${p.name}_ramp;      // ramp length in samples (${p.smooth} ms)
+    % endfor
+    % endif
+
+    % if e.signal_params:
+
+    /* params with a signal inlet */
+    % for p in e.signal_params:
+    t_float *${p.name}_scalar;   // value of the inlet when no signal is connected
+    t_float ${p.name}_last;      // last value picked up from ${p.name}_scalar
+    int ${p.name}_connected;     // 1 if a signal is connected to the inlet
+    % endfor
+    t_canvas *x_canvas;
+    % endif
+
+    % if kern:
+
+    /* dsp kernel, constructed in ${kern.storage} on a KERNEL_ALIGN boundary */
+    ${kern.type} *${kern.name};
+    unsigned char ${kern.storage}[sizeof(${kern.type}) + KERNEL_ALIGN - 1];
+    % endif
+    % if e.buffers:
+
+    /* buffers, resized by the dsp method */
+    % for b in e.buffers:
+    t_sample *${b.name};    // ${b.size} samples
+    int ${b.name}_size;
+    % endfor
+    % endif
+    % if e.delay_params:
+
+    /* delay lines of delay params (tap them at x-><param> * x->sr / 1000
+     * samples), reallocated by the dsp method when the sample rate changes */
+    % for p in e.delay_params:
+    t_xt_delay ${p.delay_line}; // up to ${p.max_ms} ms
+    % endfor
+    % endif
+    % if e.tables:
+
+    /* lookup tables shared by all instances, read them at a phase in [0, 1)
+     * with xt_table_read_linear() or xt_table_read_cubic() */
+    % for t in e.tables:
+    const t_xt_table *${t.name};   // ${t.size} points: ${t.desc or t.source}
+    % endfor
+    % endif
+    % if e.table_params:
+
+    /* arrays of table params, looked up by name by the dsp method and the
+     * param messages, so the perform routine reads the cached samples */
+    % for p in e.table_params:
+    t_symbol *${p.name};        // name of the array: ${p.desc}
+    t_word *${p.name}_vec;      // its samples (4 zeros while there is no such array)
+    int ${p.name}_len;          // number of samples
+    % endfor
+    % endif
+    % if e.events:
+
+    /* param changes queued by the message handlers with their logical time,
+     * applied by the perform routine at the frame they fall on */
+    t_xt_events events;
+    double event_start; // logical time (ms) of the start of the block
+    double event_end;   // logical time of its end, later events wait for the next block
+    % endif
+    % if e.threaded:
+
+    /* worker thread: the perform routine hands it each block and outputs
+     * the block it computed from the previous one */
+    t_${e.name}_tilde_params pending;   // written by the setters
+    t_xt_thread thread;
+    t_xt_sem thread_wake;               // posted for every block handed to the worker
+    t_xt_atomic_u32 thread_done;        // blocks finished by the worker
+    uint32_t thread_posted;             // blocks handed to the worker
+    int thread_started;
+    int thread_quit;                    // stops the worker when it is woken up
+    t_perfroutine thread_perform;       // perform-routine run by the worker
+    t_int thread_w[${3 + 2 * e.n_channels + len(e.signal_params)}];  // its argument vector, pointing into thread_buf
+    t_sample *thread_buf;   // input and output vectors of the worker
+    int thread_n;           // length of the vectors in thread_buf
+    % endif
+    % if e.spectral:
+
+    /* short-time fourier transform: the fft plan, window table, frames and
+     * overlap-add buffers of all channels, created once by the dsp method */
+    t_xt_stft stft;
+    % endif
+    % if e.dsp_outlets:
+
+    /* from_dsp outlets: the perform routine queues its reports in the ring
+     * and arms the clock, which sends the latest values of each outlet from
+     * its preallocated message, at most once per the outlet's rate */
+    t_xt_ring report_ring;          // t_${e.name}_tilde_report records
+    t_clock *report_clock;
+    t_xt_atomic_u32 report_armed;   // set from arming the clock until its tick
+    % for o in e.dsp_outlets:
+    t_atom out_${o.name}_atoms[${o.size}];   // message of the ${o.name} outlet
+    double out_${o.name}_sent;      // logical time it was last sent
+    int out_${o.name}_pending;      // set while a report waits to be sent
+    % endfor
+    % endif
+    % if e.multichannel:
+
+    /* per-channel state: one array per variable (structure of arrays),
+     * resized by the dsp method when the channel count changes */
+    % for c in e.state:
+    t_sample *${c.name};  // ${c.desc}
+    % endfor
+    int nchans; // channels of the multichannel signals, set in the dsp method
+    % endif
+    % if e.poly:
+
+    /* voice pool: one array per voice variable (structure of arrays), the
+     * padding voices past POLY_VOICES are never started */
+    t_sample poly_note[POLY_SLOTS];     // pitch of the voice
+    t_sample poly_velocity[POLY_SLOTS]; // velocity of the voice
+    t_sample poly_gate[POLY_SLOTS];     // 1 while the voice plays, else 0
+    unsigned long poly_age[POLY_SLOTS]; // start order: the oldest voice is stolen
+    % for p in e.voice_params:
+    t_sample ${p.name}[POLY_SLOTS];     // ${p.desc}
+    % endfor
+    % for st in e.state:
+    t_sample ${st.name}[POLY_SLOTS];    // ${st.desc}
+    % endfor
+    int poly_active[POLY_GROUPS];       // playing voices per group: idle groups are skipped
+    unsigned long poly_serial;          // age of the last started voice
+    % endif
+
+    % if e.denormal_dc:
+    t_sample denormal_bias; // DENORMAL_BIAS added to the inputs, its sign flips every block
+    % endif
+    t_float sr; // sample rate, set in the dsp method
+    int vs;     // block size, set in the dsp method (0 until then)
+#ifdef XT_PROFILE
+    t_xt_profile profile;   // timings of the perform routine, see _stats
+#endif
 
     /* outlets */
     % for o in e.outlets:
@@ -64,62 +400,1187 @@ void ${e.name}_tilde_${method.name}(${method.args})
     % if method.doc:
     // ${method.doc}
     % endif
+    % if e.threaded:
+    // the worker thread may be running: write params to x->pending
+    % endif
     post("${method.name} body");
 }
 
 % endfor
 
+#ifdef XT_PROFILE
+// post the dsp-load stats of the perform routine and start over
+void ${e.name}_tilde_stats(t_${e.name}_tilde *x)
+{
+    xt_profile_post(&x->profile, "${e.name}~", post);
+}
+
+#endif
+// param-setters: clamp at message time so the perform loop never has to
+% for p in e.variable_params:
+void ${e.name}_tilde_set_${p.name}(t_${e.name}_tilde *x, t_floatarg f)
+{
+    % if e.threaded:
+    x->pending.${p.name} = ${p.clamp("f")};
+    % else:
+    x->${p.name} = ${p.clamp("f")};
+    % if p.recompute:
+    x->dirty |= ${p.dirty_flag};
+    % endif
+    % if p.smooth:
+    x->${p.name}_togo = x->${p.name}_ramp;
+    % endif
+    % endif
+}
+
+% endfor
+% if e.events:
+// ids of the param events
+enum {
+    % for p in e.event_params:
+    ${p.event_id},
+    % endfor
+};
+
+static void ${e.name}_tilde_event_apply(t_${e.name}_tilde *x, int id, t_floatarg f)
+{
+    switch (id) {
+    % for p in e.event_params:
+    case ${p.event_id}:
+        ${e.name}_tilde_set_${p.name}(x, f);
+        break;
+    % endfor
+    default:
+        break;
+    }
+}
+
+/**
+ * queue a param change at the logical time of the message. The handlers
+ * run in the thread of the perform routine, so when no blocks are being
+ * processed (the dsp is off, or the object is in a switched off subpatch:
+ * no block has ended within the last two) or the queue is full (a block
+ * gets more events than it holds) the queued events are applied at once,
+ * in order, followed by this one.
+ */
+static void ${e.name}_tilde_event_push(t_${e.name}_tilde *x, int id, t_floatarg f)
+{
+    const t_xt_event *ev;
+    int running = canvas_dspstate && x->vs
+        && clock_gettimesince(x->event_end) <= 2000. * x->vs / x->sr;
+    if (running && xt_events_push(&x->events, clock_gettimesince(0), id, f))
+        return;
+    while ((ev = xt_events_peek(&x->events))) {
+        ${e.name}_tilde_event_apply(x, ev->id, ev->value);
+        xt_events_pop(&x->events);
+    }
+    ${e.name}_tilde_event_apply(x, id, f);
+}
+
+// param event handlers: the methods of the settable params
+% for p in e.event_params:
+void ${e.name}_tilde_event_${p.name}(t_${e.name}_tilde *x, t_floatarg f)
+{
+    ${e.name}_tilde_event_push(x, ${p.event_id}, f);
+}
+
+% endfor
+% endif
+% if e.table_params:
+// read in place of a missing array, so reads never have to check for one
+static t_word ${e.name}_tilde_silence[4];
+
+/**
+ * look an array up by name and cache its samples, which stay valid until
+ * the next dsp method: garray_usedindsp() has pd call it again when the
+ * array is resized. Without a usable array the samples are silence.
+ */
+static void ${e.name}_tilde_array_lookup(t_${e.name}_tilde *x, t_symbol *name, t_word **vec, int *len)
+{
+    t_garray *a = (t_garray *)pd_findbyclass(name, garray_class);
+    if (!a) {
+        if (*name->s_name)
+            pd_error(x, "${e.name}~: %s: no such array", name->s_name);
+    } else if (!garray_getfloatwords(a, len, vec)) {
+        pd_error(x, "${e.name}~: %s: bad template for an array", name->s_name);
+    } else if (*len < 4) {
+        pd_error(x, "${e.name}~: %s: an array of at least 4 points is needed", name->s_name);
+    } else {
+        garray_usedindsp(a);
+        return;
+    }
+    *vec = ${e.name}_tilde_silence;
+    *len = 4;
+}
+
+// table param-setters: <param> <array>${", or set <array> for " + e.table_set.name if e.table_set else ""}
+% for p in e.table_params:
+void ${e.name}_tilde_set_${p.name}(t_${e.name}_tilde *x, t_symbol *s)
+{
+    x->${p.name} = s;
+    ${e.name}_tilde_array_lookup(x, s, &x->${p.name}_vec, &x->${p.name}_len);
+}
+
+% endfor
+% endif
+% if e.poly:
+/**
+ * returns the index of voice number `voice` (counted from 1, like the
+ * voice numbers of [poly]), or -1 if it is out of range
+ */
+static int ${e.name}_tilde_voice_index(t_${e.name}_tilde *x, t_floatarg voice)
+{
+    int v = (int)voice - 1;
+    if (v < 0 || v >= POLY_VOICES) {
+        pd_error(x, "${e.name}~: no voice %d (1..%d)", v + 1, POLY_VOICES);
+        return -1;
+    }
+    return v;
+}
+
+// start voice v, a voice which is still playing is retriggered
+static void ${e.name}_tilde_voice_on(t_${e.name}_tilde *x, int v, t_float pitch, t_float velocity)
+{
+    if (!x->poly_gate[v])
+        x->poly_active[v / POLY_LANES]++;
+    x->poly_note[v] = pitch;
+    x->poly_velocity[v] = velocity;
+    x->poly_gate[v] = 1;
+    x->poly_age[v] = ++x->poly_serial;
+    % for st in e.state:
+    x->${st.name}[v] = ${st.initial};
+    % endfor
+}
+
+// stop voice v, its group is skipped by the perform routine once all of its voices are idle
+static void ${e.name}_tilde_voice_off(t_${e.name}_tilde *x, int v)
+{
+    if (x->poly_gate[v]) {
+        x->poly_gate[v] = 0;
+        x->poly_active[v / POLY_LANES]--;
+    }
+}
+
+/**
+ * note <pitch> <velocity>: start a voice, taking a free voice if there is
+ * one and stealing the oldest voice otherwise. A velocity of 0 stops the
+ * voices playing `pitch`.
+ */
+void ${e.name}_tilde_note(t_${e.name}_tilde *x, t_floatarg pitch, t_floatarg velocity)
+{
+    int v, oldest = 0;
+    if (velocity <= 0) {
+        for (v = 0; v < POLY_VOICES; v++)
+            if (x->poly_gate[v] && x->poly_note[v] == pitch)
+                ${e.name}_tilde_voice_off(x, v);
+        return;
+    }
+    for (v = 0; v < POLY_VOICES; v++) {
+        if (!x->poly_gate[v])
+            break;
+        if (x->poly_age[v] < x->poly_age[oldest])
+            oldest = v;
+    }
+    ${e.name}_tilde_voice_on(x, (v < POLY_VOICES) ? v : oldest, pitch, velocity);
+}
+
+/**
+ * voice <voice> <pitch> <velocity>: start (or with a velocity of 0 stop)
+ * the given voice, as allocated by [poly]
+ */
+void ${e.name}_tilde_voice(t_${e.name}_tilde *x, t_floatarg voice, t_floatarg pitch, t_floatarg velocity)
+{
+    int v = ${e.name}_tilde_voice_index(x, voice);
+    if (v < 0)
+        return;
+    if (velocity > 0)
+        ${e.name}_tilde_voice_on(x, v, pitch, velocity);
+    else
+        ${e.name}_tilde_voice_off(x, v);
+}
+
+// voice param-setters: <param> <voice> <value>
+% for p in e.voice_params:
+void ${e.name}_tilde_set_${p.name}(t_${e.name}_tilde *x, t_floatarg voice, t_floatarg f)
+{
+    int v = ${e.name}_tilde_voice_index(x, voice);
+    if (v >= 0)
+        x->${p.name}[v] = ${p.clamp("f")};
+}
+
+% endfor
+% endif
+
 /*
- * ${e.name} dsp operaitions
+ * ${e.name} dsp operations
  * ---------------------------------------------------------------------------
  */
 
+<%
+    nch = e.n_channels
+    nio = 1 if e.multichannel else nch   # audio inlets and outlets
+    nsig = len(e.signal_params)
+    nin = nio + nsig
+    variants = [("", False), ("_sig", True)] if nsig else [("", False)]
+%>
+% if e.signal_params:
+/**
+ * returns the inlets of the object into which a signal is connected, bit i
+ * for inlet i, in a single pass over the connections of the canvas (which
+ * m_pd.h offers no query of); control connections, of a number box into a
+ * signal_or_float inlet, leave the inlet scalar
+ */
+static unsigned long ${e.name}_tilde_connected(t_${e.name}_tilde *x)
+{
+    unsigned long inlets = 0;
+    t_linetraverser t;
+    linetraverser_start(&t, x->x_canvas);
+    while (linetraverser_next(&t)) {
+        if (t.tr_ob2 == &x->x_obj && t.tr_inno < ${nin}
+            && obj_issignaloutlet(t.tr_ob, t.tr_outno))
+            inlets |= 1UL << t.tr_inno;
+    }
+    return inlets;
+}
+
+% endif
+% if e.table_params:
+/**
+ * reads of the samples of a table param at a position in samples, clamped
+ * to the array: _array_read() truncates the position, _array_read_linear()
+ * interpolates between 2 points and _array_read_cubic() between 4 (hermite,
+ * so like tabread4~ it clamps to [1, len - 2])
+ */
+static inline t_sample ${e.name}_tilde_array_read(const t_word *vec, int len, t_sample pos)
+{
+    int i = (int)pos;
+    return vec[(i < 0) ? 0 : (i >= len) ? len - 1 : i].w_float;
+}
+
+static inline t_sample ${e.name}_tilde_array_read_linear(const t_word *vec, int len, t_sample pos)
+{
+    int i;
+    t_sample f;
+    pos = (pos < 0) ? 0 : (pos > len - 1) ? len - 1 : pos;
+    i = (int)pos;
+    if (i > len - 2)
+        i = len - 2;
+    f = pos - i;
+    return vec[i].w_float + f * (vec[i + 1].w_float - vec[i].w_float);
+}
 
+static inline t_sample ${e.name}_tilde_array_read_cubic(const t_word *vec, int len, t_sample pos)
+{
+    int i;
+    t_sample f, y0, y1, y2, y3, c1, c2, c3;
+    pos = (pos < 1) ? 1 : (pos > len - 2) ? len - 2 : pos;
+    i = (int)pos;
+    if (i > len - 3)
+        i = len - 3;
+    f = pos - i;
+    y0 = vec[i - 1].w_float;
+    y1 = vec[i].w_float;
+    y2 = vec[i + 1].w_float;
+    y3 = vec[i + 2].w_float;
+    c1 = (t_sample)0.5 * (y2 - y0);
+    c2 = y0 - (t_sample)2.5 * y1 + 2 * y2 - (t_sample)0.5 * y3;
+    c3 = (t_sample)0.5 * (y3 - y0) + (t_sample)1.5 * (y1 - y2);
+    return ((c3 * f + c2) * f + c1) * f + y1;
+}
+
+% endif
+% if e.dsp_outlets:
+/**
+ * report clock: send the values last reported to each from_dsp outlet,
+ * unless it was sent less than its rate ago, and arm the clock again for
+ * the outlets which have to wait. The armed flag is cleared before the
+ * ring is read, so a report queued after that arms the clock itself.
+ */
+static void ${e.name}_tilde_report_tick(t_${e.name}_tilde *x)
+{
+    t_${e.name}_tilde_report r;
+    double wait = -1;   // ms until the next waiting outlet is due (-1: none waits)
+    int k;
+    xt_exchange(&x->report_armed, 0);
+    while (xt_ring_read_space(&x->report_ring) >= sizeof(r)) {
+        xt_ring_read(&x->report_ring, &r, sizeof(r));
+        switch (r.outlet) {
+        % for i, o in enumerate(e.dsp_outlets):
+        case ${i}:
+            for (k = 0; k < ${o.size}; k++)
+                SETFLOAT(&x->out_${o.name}_atoms[k], r.values[k]);
+            x->out_${o.name}_pending = 1;
+            break;
+        % endfor
+        default:
+            break;
+        }
+    }
+    % for o in e.dsp_outlets:
+    if (x->out_${o.name}_pending) {
+        double since = clock_gettimesince(x->out_${o.name}_sent);
+        if (since >= ${o.rate}) {
+            x->out_${o.name}_pending = 0;
+            x->out_${o.name}_sent = clock_getlogicaltime();
+            % if o.type == "float":
+            outlet_float(x->out_${o.name}, atom_getfloat(x->out_${o.name}_atoms));
+            % else:
+            outlet_list(x->out_${o.name}, &s_list, ${o.size}, x->out_${o.name}_atoms);
+            % endif
+        } else if (wait < 0 || ${o.rate} - since < wait) {
+            wait = ${o.rate} - since;
+        }
+    }
+    % endfor
+    if (wait >= 0 && !xt_exchange(&x->report_armed, 1))
+        clock_delay(x->report_clock, wait);
+}
+
+/**
+ * (perform routine) report values to a from_dsp outlet: the report is
+ * queued (or dropped while REPORT_QUEUE reports wait) and the clock armed
+ * unless it already is, so reporting every block costs a copy and an
+ * atomic exchange. Reports the clock has not sent yet are replaced.
+ */
+% for i, o in enumerate(e.dsp_outlets):
+% if o.type == "float":
+static inline void ${e.name}_tilde_report_${o.name}(t_${e.name}_tilde *x, t_float f)
+% else:
+static inline void ${e.name}_tilde_report_${o.name}(t_${e.name}_tilde *x, const t_float *values)   // ${o.size} values
+% endif
+{
+    t_${e.name}_tilde_report r;
+    r.outlet = ${i};
+    % if o.type == "float":
+    r.values[0] = f;
+    % else:
+    memcpy(r.values, values, ${o.size} * sizeof(t_float));
+    % endif
+    if (xt_ring_write_space(&x->report_ring) >= sizeof(r))
+        xt_ring_write(&x->report_ring, &r, sizeof(r));
+    if (!xt_exchange(&x->report_armed, 1))
+        clock_delay(x->report_clock, 0);
+}
+
+% endfor
+% endif
+/**
+ * begin a block of n samples:
+% if e.signal_params and not e.threaded:
+ * pick up floats sent to unconnected signal inlets,
+% endif
+ * recompute the derived coefficients of params flagged as dirty and
+ * advance the ramps of smoothed params, so that a ramp ends on its target
+ * after `ramp` samples (or at the end of the block in which it runs out)
+ */
+static void ${e.name}_tilde_prepare(t_${e.name}_tilde *x, int n)
+{
+    % if e.denormal_dc:
+    x->denormal_bias = -x->denormal_bias;
+    % endif
+    % if not e.threaded:
+    % for p in e.signal_params:
+    if (*x->${p.name}_scalar != x->${p.name}_last) {
+        x->${p.name}_last = *x->${p.name}_scalar;
+        ${e.name}_tilde_set_${p.name}(x, x->${p.name}_last);
+    }
+    % endfor
+    % endif
+    % if e.recomputed_params:
+    if (x->dirty) {
+        % for p in e.recomputed_params:
+        if (x->dirty & ${p.dirty_flag}) {
+            ${p.recompute.strip()}
+        }
+        % endfor
+        x->dirty = 0;
+    }
+    % endif
+    % for p in e.smoothed_params:
+    if (x->${p.name}_togo > 0) {
+        int m = (x->${p.name}_togo > n) ? x->${p.name}_togo : n;
+        x->${p.name}_step = (x->${p.name} - x->${p.name}_cur) / m;
+        x->${p.name}_togo = (x->${p.name}_togo > n) ? x->${p.name}_togo - n : 0;
+    } else {
+        x->${p.name}_cur = x->${p.name};
+        x->${p.name}_step = 0;
+    }
+    % endfor
+}
+
+% if e.events:
+/**
+ * apply the queued events due at frame i of the block of n samples,
+ * returns the frame of the next event in the block (or n if there is none)
+ */
+static int ${e.name}_tilde_events_due(t_${e.name}_tilde *x, int i, int n)
+{
+    const t_xt_event *ev;
+    while ((ev = xt_events_peek(&x->events)) && ev->time < x->event_end) {
+        int at = xt_event_frame(ev, x->event_start, x->sr, i, n);
+        if (at > i)
+            return at;
+        ${e.name}_tilde_event_apply(x, ev->id, ev->value);
+        xt_events_pop(&x->events);
+    }
+    return n;
+}
+
+% endif
+% if e.multichannel:
+% for suffix, vector in variants:
+/**
+ * multichannel perform-routine: processes all channels in one call
+% if vector:
+ * (used when a signal is connected to a param inlet)
+% elif e.signal_params:
+ * (used when no signal is connected to a param inlet)
+% endif
+ *
+ * the argument vector holds the objects data-space, the input vector,
+% if e.signal_params:
+ * ${nsig} param input vectors, the output vector, the length of a channel
+ * and the number of channels.
+% else:
+ * the output vector, the length of a channel and the number of channels.
+% endif
+ * Channel c of a multichannel vector starts at c * n. Channels are the
+ * inner loop, so per-channel state is read from contiguous arrays and
+ * the loop can be vectorized across channels. Input and output may share
+ * memory, so each sample is read before it is written.
+ */
+t_int *${e.name}_tilde_perform${suffix}(t_int *w)
+{
+    t_${e.name}_tilde *x = (t_${e.name}_tilde *)(w[1]);
+    t_sample *in = (t_sample *)(w[2]);
+    t_sample *out = (t_sample *)(w[${3 + nsig}]);
+    int n = (int)(w[${4 + nsig}]);
+    int nchans = (int)(w[${5 + nsig}]);
+    % for c in e.state:
+    t_sample *RESTRICT ${c.name} = x->${c.name};
+    % endfor
+    int i, c;
+    XT_PROFILE_BEGIN();
+    % if e.denormal_ftz:
+    t_xt_fpmode fpmode = xt_ftz_begin();
+    % endif
+
+    ${e.name}_tilde_prepare(x, n);
+    % if e.denormal_dc:
+    t_sample bias = x->denormal_bias;
+    % endif
+    % for j, p in enumerate(e.frame_params):
+    % if p.smooth:
+    t_sample ${p.name}_0 = x->${p.name}_cur, ${p.name}_step = x->${p.name}_step;
+    % else:
+    t_sample ${p.name}_0 = x->${p.name};
+    % endif
+    % endfor
+    % if vector:
+    % for j, p in enumerate(e.signal_params):
+    t_sample *${p.name}_in = x->${p.name}_connected ? (t_sample *)(w[${3 + j}]) : 0;
+    % endfor
+    % endif
+
+    for (i = 0; i < n; i++) {
+        % for p in e.frame_params:
+        t_sample ${p.name} = ${p.sample_value(0, vector)};
+        % endfor
+        for (c = 0; c < nchans; c++) {
+            t_sample f = in[c * n + i]${dc};
+            out[c * n + i] = f;
+        }
+    }
+    % if e.smoothed_params:
+
+    % for p in e.smoothed_params:
+    x->${p.name}_cur = ${p.name}_0 + ${p.name}_step * n;
+    % endfor
+    % endif
+    % if e.denormal_ftz:
+    xt_ftz_end(fpmode);
+    % endif
+    XT_PROFILE_END(&x->profile);
+
+    return (w + ${6 + nsig});
+}
+
+% endfor
+% elif e.poly:
+% for suffix, vector in variants:
+/**
+ * polyphonic perform-routine: mixes the playing voices onto the inputs
+% if vector:
+ * (used when a signal is connected to a param inlet)
+% elif e.signal_params:
+ * (used when no signal is connected to a param inlet)
+% endif
+ *
+ * the argument vector holds the objects data-space, N_CHANNELS input
+% if e.signal_params:
+ * vectors, ${nsig} param input vectors, N_CHANNELS output vectors and the
+ * length of the vectors.
+% else:
+ * vectors, N_CHANNELS output vectors and the length of the vectors.
+% endif
+ * Voices are processed in groups of POLY_LANES: the voice arrays are
+ * structures of arrays, so the inner loop over the lanes of a group reads
+ * contiguous memory and can be vectorized across voices, with idle lanes
+ * muted by their gate. Groups without a playing voice are skipped.
+ */
+t_int *${e.name}_tilde_perform${suffix}(t_int *w)
+{
+    t_${e.name}_tilde *x = (t_${e.name}_tilde *)(w[1]);
+    % for c in range(nch):
+    t_sample *in${c} = (t_sample *)(w[${2 + c}]);
+    % endfor
+    % for c in range(nch):
+    t_sample *out${c} = (t_sample *)(w[${2 + nin + c}]);
+    % endfor
+    int n = (int)(w[${2 + nin + nch}]);
+    int i, g, l;
+    XT_PROFILE_BEGIN();
+    % if e.denormal_ftz:
+    t_xt_fpmode fpmode = xt_ftz_begin();
+    % endif
+
+    ${e.name}_tilde_prepare(x, n);
+    % if e.denormal_dc:
+    t_sample bias = x->denormal_bias;
+    % endif
+    % for j, p in enumerate(e.frame_params):
+    % if p.smooth:
+    t_sample ${p.name}_0 = x->${p.name}_cur, ${p.name}_step = x->${p.name}_step;
+    % else:
+    t_sample ${p.name}_0 = x->${p.name};
+    % endif
+    % endfor
+    % if vector:
+    % for j, p in enumerate(e.signal_params):
+    t_sample *${p.name}_in = x->${p.name}_connected ? (t_sample *)(w[${2 + nch + j}]) : 0;
+    % endfor
+    % endif
+
+    // inputs and outputs may share memory: the inputs pass through first
+    for (i = 0; i < n; i++) {
+        % for c in range(nch):
+        t_sample f${c} = in${c}[i]${dc};
+        % endfor
+        % for c in range(nch):
+        out${c}[i] = f${c};
+        % endfor
+    }
+
+    for (g = 0; g < POLY_GROUPS; g++) {
+        if (!x->poly_active[g])
+            continue;
+        const t_sample *RESTRICT note = x->poly_note + g * POLY_LANES;
+        const t_sample *RESTRICT velocity = x->poly_velocity + g * POLY_LANES;
+        const t_sample *RESTRICT gate = x->poly_gate + g * POLY_LANES;
+        % for p in e.voice_params:
+        const t_sample *RESTRICT ${p.name} = x->${p.name} + g * POLY_LANES;
+        % endfor
+        % for st in e.state:
+        t_sample *RESTRICT ${st.name} = x->${st.name} + g * POLY_LANES;
+        % endfor
+
+        for (i = 0; i < n; i++) {
+            % for p in e.frame_params:
+            t_sample ${p.name} = ${p.sample_value(0, vector)};
+            % endfor
+            t_sample mix = 0;
+            for (l = 0; l < POLY_LANES; l++) {
+                t_sample v = 0;     // sample of voice l of the group
+                mix += gate[l] * v;
+            }
+            % for c in range(nch):
+            out${c}[i] += mix;
+            % endfor
+        }
+    }
+    % if e.smoothed_params:
+
+    % for p in e.smoothed_params:
+    x->${p.name}_cur = ${p.name}_0 + ${p.name}_step * n;
+    % endfor
+    % endif
+    % if e.denormal_ftz:
+    xt_ftz_end(fpmode);
+    % endif
+    XT_PROFILE_END(&x->profile);
+
+    return (w + ${3 + nin + nch});
+}
+
+% endfor
+% elif e.spectral:
+/**
+ * process the spectrum of channel c in place: bins[0] and bins[1] are the
+ * real dc and nyquist bins, bins[2 k] and bins[2 k + 1] the real and
+ * imaginary parts of bin k (0 < k < SPECTRAL_SIZE / 2). A spectrum left
+ * unchanged resynthesizes the input.
+ */
+static void ${e.name}_tilde_spectrum(t_${e.name}_tilde *x, t_sample *RESTRICT bins, int c)
+{
+    int k;
+    for (k = 1; k < SPECTRAL_SIZE / 2; k++) {
+        t_sample re = bins[2 * k], im = bins[2 * k + 1];
+        bins[2 * k] = re;
+        bins[2 * k + 1] = im;
+    }
+}
+
+/**
+ * spectral perform-routine: works for any block size, hops may span blocks
+ * and blocks may hold several hops
+ *
+ * the argument vector holds the objects data-space, N_CHANNELS input
+ * vectors, N_CHANNELS output vectors and the length of the vectors. The
+ * block is copied through the frames in spans ending on a hop, and every
+ * hop transforms the frames of all channels with the plan made by the dsp
+ * method: nothing is allocated or planned here. Inputs and outputs may
+ * share memory, so all inputs of a span are copied before any output.
+ */
 t_int *${e.name}_tilde_perform(t_int *w)
 {
-  /* the first element is a pointer to the dataspace of this object */
-  t_xfade_tilde *x = (t_xfade_tilde *)(w[1]);
-  /* here is a pointer to the t_sample arrays that hold the 2 input signals */
-  t_sample    *in1 =      (t_sample *)(w[2]);
-  t_sample    *in2 =      (t_sample *)(w[3]);
-  /* here comes the signalblock that will hold the output signal */
-  t_sample    *out =      (t_sample *)(w[4]);
-  /* all signalblocks are of the same length */
-  int            n =             (int)(w[5]);
-  /* get (and clip) the mixing-factor */
-  t_sample pan = (x->x_pan<0)?0.0:(x->x_pan>1)?1.0:x->x_pan;
-  /* just a counter */
-  int i;
+    t_${e.name}_tilde *x = (t_${e.name}_tilde *)(w[1]);
+    % for c in range(nch):
+    t_sample *in${c} = (t_sample *)(w[${2 + c}]);
+    % endfor
+    % for c in range(nch):
+    t_sample *out${c} = (t_sample *)(w[${2 + nin + c}]);
+    % endfor
+    int n = (int)(w[${2 + nin + nch}]);
+    int i, m;
+    XT_PROFILE_BEGIN();
+    % if e.denormal_ftz:
+    t_xt_fpmode fpmode = xt_ftz_begin();
+    % endif
 
-  /* this is the main routine:
-   * mix the 2 input signals into the output signal
-   */
-  for(i=0; i<n; i++)
-    {
-      out[i]=in1[i]*(1-pan)+in2[i]*pan;
+    ${e.name}_tilde_prepare(x, n);
+    for (i = 0; i < n; i += m) {
+        m = (int)xt_stft_span(&x->stft, (uint32_t)(n - i));
+        % for c in range(nch):
+        xt_stft_write(&x->stft, ${c}, in${c} + i, m);
+        % endfor
+        % for c in range(nch):
+        xt_stft_read(&x->stft, ${c}, out${c} + i, m);
+        % endfor
+        if (xt_stft_advance(&x->stft, m)) {
+            % for c in range(nch):
+            ${e.name}_tilde_spectrum(x, xt_stft_analyze(&x->stft, ${c}), ${c});
+            xt_stft_synthesize(&x->stft, ${c});
+            % endfor
+        }
     }
 
-  /* return a pointer to the dataspace for the next dsp-object */
-  return (w+6);
+    % if e.denormal_ftz:
+    xt_ftz_end(fpmode);
+    % endif
+    XT_PROFILE_END(&x->profile);
+
+    return (w + ${3 + nin + nch});
 }
+% else:
+% for suffix, vector in variants:
+/**
+ * scalar perform-routine: works for any block size
+% if vector:
+ * (used when a signal is connected to a param inlet)
+% elif e.signal_params:
+ * (used when no signal is connected to a param inlet)
+% endif
+ *
+ * the argument vector holds the objects data-space, N_CHANNELS input
+% if e.signal_params:
+ * vectors, ${nsig} param input vectors, N_CHANNELS output vectors and the
+ * length of the vectors.
+% else:
+ * vectors, N_CHANNELS output vectors and the length of the vectors.
+% endif
+ * Inputs and outputs may share memory, so all inputs of a frame are read
+ * before any output of that frame is written.
+ */
+t_int *${e.name}_tilde_perform${suffix}(t_int *w)
+{
+    t_${e.name}_tilde *x = (t_${e.name}_tilde *)(w[1]);
+    % for c in range(nch):
+    t_sample *in${c} = (t_sample *)(w[${2 + c}]);
+    % endfor
+    % for c in range(nch):
+    t_sample *out${c} = (t_sample *)(w[${2 + nin + c}]);
+    % endfor
+    int n = (int)(w[${2 + nin + nch}]);
+    int i;
+    % if e.events:
+    int start, end;
+    % endif
+    % for p in e.table_params:
+    const t_word *${p.name} = x->${p.name}_vec;    // read with ${e.name}_tilde_array_read*(${p.name}, ${p.name}_len, pos)
+    int ${p.name}_len = x->${p.name}_len;
+    % endfor
+    XT_PROFILE_BEGIN();
+    % if e.denormal_ftz:
+    t_xt_fpmode fpmode = xt_ftz_begin();
+    % endif
+    % if e.events:
+    % if vector:
+
+    % for j, p in enumerate(e.signal_params):
+    t_sample *${p.name}_in = x->${p.name}_connected ? (t_sample *)(w[${2 + nch + j}]) : 0;
+    % endfor
+    % endif
+
+    /* the block is split at the frames of its events, each span is begun
+     * like a block of its own (smoothed params keep their `_0` origin at
+     * frame 0, so sample_value() holds for the frames of any span) */
+    x->event_start = x->event_end;
+    x->event_end = clock_gettimesince(0);
+    for (start = 0; start < n; start = end) {
+        end = ${e.name}_tilde_events_due(x, start, n);
+        ${e.name}_tilde_prepare(x, end - start);
+        % if e.denormal_dc:
+        t_sample bias = x->denormal_bias;
+        % endif
+        % for j, p in enumerate(e.frame_params):
+        % if p.smooth:
+        t_sample ${p.name}_step = x->${p.name}_step, ${p.name}_0 = x->${p.name}_cur - ${p.name}_step * start;
+        % else:
+        t_sample ${p.name}_0 = x->${p.name};
+        % endif
+        % endfor
+
+        for (i = start; i < end; i++) {
+            % for p in e.frame_params:
+            t_sample ${p.name} = ${p.sample_value(0, vector)};
+            % endfor
+            % for c in range(nch):
+            t_sample f${c} = in${c}[i]${dc};
+            % endfor
+            % for c in range(nch):
+            out${c}[i] = f${c};
+            % endfor
+        }
+        % for p in e.smoothed_params:
+        x->${p.name}_cur = ${p.name}_0 + ${p.name}_step * end;
+        % endfor
+    }
+    % else:
+
+    ${e.name}_tilde_prepare(x, n);
+    % if e.denormal_dc:
+    t_sample bias = x->denormal_bias;
+    % endif
+    % for j, p in enumerate(e.frame_params):
+    % if p.smooth:
+    t_sample ${p.name}_0 = x->${p.name}_cur, ${p.name}_step = x->${p.name}_step;
+    % else:
+    t_sample ${p.name}_0 = x->${p.name};
+    % endif
+    % endfor
+    % if vector:
+    % for j, p in enumerate(e.signal_params):
+    t_sample *${p.name}_in = x->${p.name}_connected ? (t_sample *)(w[${2 + nch + j}]) : 0;
+    % endfor
+    % endif
+
+    for (i = 0; i < n; i++) {
+        % for p in e.frame_params:
+        t_sample ${p.name} = ${p.sample_value(0, vector)};
+        % endfor
+        % for c in range(nch):
+        t_sample f${c} = in${c}[i]${dc};
+        % endfor
+        % for c in range(nch):
+        out${c}[i] = f${c};
+        % endfor
+    }
+    % if e.smoothed_params:
+
+    % for p in e.smoothed_params:
+    x->${p.name}_cur = ${p.name}_0 + ${p.name}_step * n;
+    % endfor
+    % endif
+    % endif
+
+    % if e.denormal_ftz:
+    xt_ftz_end(fpmode);
+    % endif
+    XT_PROFILE_END(&x->profile);
+
+    /* return a pointer to the dataspace for the next dsp-object */
+    return (w + ${3 + nin + nch});
+}
+
+/**
+ * unrolled perform-routine: requires a block size that is a multiple of 8.
+ * Like pd's builtin *_perf8 routines, it loads all 8 frames of the inputs
+ * before storing any output, so it is safe when they share memory.
+ */
+t_int *${e.name}_tilde_perf8${suffix}(t_int *w)
+{
+    t_${e.name}_tilde *x = (t_${e.name}_tilde *)(w[1]);
+    % for c in range(nch):
+    const t_sample *in${c} = (t_sample *)(w[${2 + c}]);
+    % endfor
+    % for c in range(nch):
+    t_sample *out${c} = (t_sample *)(w[${2 + nin + c}]);
+    % endfor
+    int n = (int)(w[${2 + nin + nch}]);
+    int i;
+    % for p in e.table_params:
+    const t_word *${p.name} = x->${p.name}_vec;
+    int ${p.name}_len = x->${p.name}_len;
+    % endfor
+    % if e.events:
+
+    // the scalar routine splits a block with events at their frames
+    if (xt_events_peek(&x->events))
+        return ${e.name}_tilde_perform${suffix}(w);
+    % endif
+    XT_PROFILE_BEGIN();
+    % if e.denormal_ftz:
+    t_xt_fpmode fpmode = xt_ftz_begin();
+    % endif
+    % if e.events:
+
+    x->event_start = x->event_end;
+    x->event_end = clock_gettimesince(0);
+    % endif
+
+    ${e.name}_tilde_prepare(x, n);
+    % if e.denormal_dc:
+    t_sample bias = x->denormal_bias;
+    % endif
+    % for j, p in enumerate(e.frame_params):
+    % if p.smooth:
+    t_sample ${p.name}_0 = x->${p.name}_cur, ${p.name}_step = x->${p.name}_step;
+    % else:
+    t_sample ${p.name}_0 = x->${p.name};
+    % endif
+    % endfor
+    % if vector:
+    % for j, p in enumerate(e.signal_params):
+    const t_sample *${p.name}_in = x->${p.name}_connected ? (t_sample *)(w[${2 + nch + j}]) : 0;
+    % endfor
+    % endif
+
+    for (i = 0; i < n; i += 8) {
+        % for c in range(nch):
+        t_sample ${", ".join(f"in{c}_{k} = in{c}[i + {k}]" if k else f"in{c}_0 = in{c}[i]" for k in range(8))};
+        % endfor
+        % for p in e.frame_params:
+        t_sample ${", ".join(f"{p.name}_f{k} = {p.sample_value(k, vector)}" for k in range(8))};
+        % endfor
+        % for k in range(8):
+        {
+            % for p in e.frame_params:
+            t_sample ${p.name} = ${p.name}_f${k};
+            % endfor
+            % for c in range(nch):
+            out${c}[i + ${k}] = in${c}_${k}${dc};
+            % endfor
+        }
+        % endfor
+    }
+    % if e.smoothed_params:
+
+    % for p in e.smoothed_params:
+    x->${p.name}_cur = ${p.name}_0 + ${p.name}_step * n;
+    % endfor
+    % endif
+    % if e.denormal_ftz:
+    xt_ftz_end(fpmode);
+    % endif
+    XT_PROFILE_END(&x->profile);
+
+    return (w + ${3 + nin + nch});
+}
+
+% endfor
+% endif
+% if e.threaded:
+
+/**
+ * the worker thread: runs the perform-routine chosen by the dsp method on
+ * the vectors in thread_buf, whenever the dsp thread hands it a block
+ */
+static XT_THREAD_FN(${e.name}_tilde_worker, arg)
+{
+    t_${e.name}_tilde *x = (t_${e.name}_tilde *)arg;
+    for (;;) {
+        xt_sem_wait(&x->thread_wake);
+        if (x->thread_quit)
+            break;
+        x->thread_perform(x->thread_w);
+        xt_store_release(&x->thread_done, xt_load_relaxed(&x->thread_done) + 1);
+    }
+    return 0;
+}
+
+/**
+ * wait until the worker has finished the last block handed to it, after
+ * which only the dsp thread touches the object until the next handoff
+ */
+static void ${e.name}_tilde_thread_wait(t_${e.name}_tilde *x)
+{
+    unsigned spins = 0;
+    while (xt_load_acquire(&x->thread_done) != x->thread_posted)
+        xt_backoff(&spins);
+}
+
+/**
+ * copy the params written by the setters since the last block into the
+ * object, for the worker's next block
+% if e.signal_params:
+ * (floats sent to unconnected signal inlets are picked up here too)
+% endif
+ */
+static void ${e.name}_tilde_thread_sync(t_${e.name}_tilde *x)
+{
+    % for p in e.signal_params:
+    if (*x->${p.name}_scalar != x->${p.name}_last) {
+        x->${p.name}_last = *x->${p.name}_scalar;
+        ${e.name}_tilde_set_${p.name}(x, x->${p.name}_last);
+    }
+    % endfor
+    % for p in e.variable_params:
+    if (x->pending.${p.name} != x->${p.name}) {
+        x->${p.name} = x->pending.${p.name};
+        % if p.recompute:
+        x->dirty |= ${p.dirty_flag};
+        % endif
+        % if p.smooth:
+        x->${p.name}_togo = x->${p.name}_ramp;
+        % endif
+    }
+    % endfor
+}
+
+/**
+ * point the worker's argument vector at thread_buf, (re)allocated for
+ * blocks of n samples, and start the worker the first time. Returns 0 if
+ * the worker cannot be started.
+ */
+static int ${e.name}_tilde_thread_setup(t_${e.name}_tilde *x, t_perfroutine perform, int n)
+{
+    int c;
+    if (n != x->thread_n) {
+        if (x->thread_buf)
+            freebytes(x->thread_buf, ${nin + nch} * x->thread_n * sizeof(t_sample));
+        x->thread_buf = (t_sample *)getbytes(${nin + nch} * n * sizeof(t_sample));
+        x->thread_n = n;
+    }
+    x->thread_perform = perform;
+    x->thread_w[1] = (t_int)x;
+    for (c = 0; c < ${nin + nch}; c++)
+        x->thread_w[2 + c] = (t_int)(x->thread_buf + c * n);
+    x->thread_w[${2 + nin + nch}] = n;
+    if (!x->thread_started) {
+        xt_sem_init(&x->thread_wake);
+        if (xt_thread_start(&x->thread, ${e.name}_tilde_worker, x)) {
+            xt_sem_destroy(&x->thread_wake);
+            pd_error(x, "${e.name}~: cannot start the worker thread, running on the dsp thread");
+            return 0;
+        }
+        x->thread_started = 1;
+    }
+    return 1;
+}
+
+/**
+ * perform-routine of the dsp thread: outputs the block the worker computed
+ * from the previous input block and hands the worker the current one, so
+ * the object runs in parallel with the rest of the dsp chain with one
+ * block of latency. The argument vector is the one of the other
+ * perform-routines.
+ */
+t_int *${e.name}_tilde_perform_threaded(t_int *w)
+{
+    t_${e.name}_tilde *x = (t_${e.name}_tilde *)(w[1]);
+    int n = (int)(w[${2 + nin + nch}]);
+    int c;
+
+    ${e.name}_tilde_thread_wait(x);
+    /* inputs and outputs may share memory, so all inputs are copied before
+     * any output is written */
+    for (c = 0; c < ${nin}; c++)
+        memcpy(x->thread_buf + c * n, (t_sample *)(w[2 + c]), n * sizeof(t_sample));
+    for (c = ${nin}; c < ${nin + nch}; c++)
+        memcpy((t_sample *)(w[2 + c]), x->thread_buf + c * n, n * sizeof(t_sample));
+    ${e.name}_tilde_thread_sync(x);
+    x->thread_posted++;
+    xt_sem_post(&x->thread_wake);
+
+    return (w + ${3 + nin + nch});
+}
+% endif
 
 
 /**
  * register a special perform-routine at the dsp-engine
  * this function gets called whenever the DSP is turned ON
- * the name of this function is registered in xfade_tilde_setup()
+ * the name of this function is registered in ${e.name}_tilde_setup()
  */
-void ${e.name}_tilde_dsp(t_xfade_tilde *x, t_signal **sp)
+void ${e.name}_tilde_dsp(t_${e.name}_tilde *x, t_signal **sp)
 {
-  /* add xfade_tilde_perform() to the DSP-tree;
-   * the xfade_tilde_perform() will expect "5" arguments (packed into an
-   * t_int-array), which are:
-   * the objects data-space, 3 signal vectors (which happen to be
-   * 2 input signals and 1 output signal) and the length of the
-   * signal vectors (all vectors are of the same length)
-   */
-  dsp_add(${e.name}_tilde_perform, 5, x,
-          sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[0]->s_n);
+    t_perfroutine perform = ${e.name}_tilde_perform;
+    % if e.signal_params:
+    unsigned long inlets = ${e.name}_tilde_connected(x);
+    int connected = 0;
+    % endif
+    % if e.multichannel:
+#if PD_MINOR_VERSION >= 54
+    int nchans = sp[0]->s_nchans;
+    signal_setmultiout(&sp[${nin}], nchans);    // as many output channels as input channels
+#else
+    int nchans = 1;
+#endif
+    % endif
+    % if e.threaded:
+
+    // the worker may still be processing the last block of the old dsp chain
+    ${e.name}_tilde_thread_wait(x);
+    % endif
+
+    /* the dsp method is also called on every change of the dsp graph, so
+     * state depending on the sample rate or the block size is only
+     * rebuilt when one of them has actually changed.
+     */
+    if (sp[0]->s_sr != x->sr || sp[0]->s_n != x->vs) {
+        x->sr = sp[0]->s_sr;
+        x->vs = sp[0]->s_n;
+        % if e.recomputed_params:
+        x->dirty = DIRTY_ALL;
+        % endif
+        % for p in e.smoothed_params:
+        x->${p.name}_ramp = ${e.name}_tilde_ramp_samples(${p.smooth}, x->sr);
+        % endfor
+        % for b in e.buffers:
+        {
+            int size = ${b.size};
+            if (size != x->${b.name}_size) {
+                x->${b.name} = x->${b.name}
+                    ? (t_sample *)resizebytes(x->${b.name}, x->${b.name}_size * sizeof(t_sample), size * sizeof(t_sample))
+                    : (t_sample *)getbytes(size * sizeof(t_sample));
+                x->${b.name}_size = size;
+            }
+        }
+        % endfor
+        % for p in e.delay_params:
+        {
+            uint32_t max_delay = ${p.max_delay};
+            if (xt_delay_bytes(max_delay) != x->${p.delay_line}.nbytes) {
+                if (x->${p.delay_line}.mem)
+                    freebytes(x->${p.delay_line}.mem, x->${p.delay_line}.nbytes);
+                xt_delay_init(&x->${p.delay_line}, getbytes(xt_delay_bytes(max_delay)), max_delay);
+            }
+        }
+        % endfor
+        % if kern and kern.init:
+        ${kern.init.strip()}
+        % endif
+    }
+    % if e.table_params:
+
+    // arrays are looked up again on every dsp method, which pd also calls when one is resized
+    % for p in e.table_params:
+    ${e.name}_tilde_array_lookup(x, x->${p.name}, &x->${p.name}_vec, &x->${p.name}_len);
+    % endfor
+    % endif
+    % if e.spectral:
+
+    // the fft plan, window table and frames are made once, by the first dsp method
+    if (!x->stft.mem)
+        xt_stft_init(&x->stft, getbytes(xt_stft_bytes(SPECTRAL_SIZE, N_CHANNELS)),
+                     SPECTRAL_SIZE, SPECTRAL_OVERLAP, N_CHANNELS, ${e.spectral.window_id});
+    % endif
+    % if e.events:
+
+    // the first block after a restart of the dsp begins now
+    x->event_end = clock_gettimesince(0);
+    % endif
+    % if e.multichannel:
+
+    /* channel state is kept across a change of the channel count, new
+     * channels start from the initial state */
+    if (nchans != x->nchans) {
+        % if e.state:
+        int c;
+        % for st in e.state:
+        x->${st.name} = x->${st.name}
+            ? (t_sample *)resizebytes(x->${st.name}, x->nchans * sizeof(t_sample), nchans * sizeof(t_sample))
+            : (t_sample *)getbytes(nchans * sizeof(t_sample));
+        % endfor
+        for (c = x->nchans; c < nchans; c++) {
+            % for st in e.state:
+            x->${st.name}[c] = ${st.initial};
+            % endfor
+        }
+        % endif
+        x->nchans = nchans;
+    }
+    % endif
+    % if e.signal_params:
+
+    /* param inlets without a signal connection are read from the struct
+     * by the scalar variants; the vector variants are only used when at
+     * least one param inlet is connected.
+     */
+    % for j, p in enumerate(e.signal_params):
+    x->${p.name}_connected = (inlets >> ${nio + j}) & 1;
+    connected |= x->${p.name}_connected;
+    % endfor
+    % endif
+
+    % if e.multichannel:
+    % if e.signal_params:
+    if (connected)
+        perform = ${e.name}_tilde_perform_sig;
+    % endif
+
+    dsp_add(perform, ${5 + nsig}, x,
+            % for c in range(nin + 1):
+            sp[${c}]->s_vec,
+            % endfor
+            sp[0]->s_n, nchans);
+    % elif e.poly:
+    % if e.signal_params:
+    if (connected)
+        perform = ${e.name}_tilde_perform_sig;
+    % endif
+
+    dsp_add(perform, ${2 + nin + nch}, x,
+            % for c in range(nin + nch):
+            sp[${c}]->s_vec,
+            % endfor
+            sp[0]->s_n);
+    % else:
+    % if not e.spectral:
+    /* like pd's builtin *_perf8 routines, the unrolled variant is only
+     * used when the block size allows it; the scalar loop is the fallback.
+     */
+    % if e.signal_params:
+    if (!(sp[0]->s_n & 7))
+        perform = connected ? ${e.name}_tilde_perf8_sig : ${e.name}_tilde_perf8;
+    else if (connected)
+        perform = ${e.name}_tilde_perform_sig;
+    % else:
+    if (!(sp[0]->s_n & 7))
+        perform = ${e.name}_tilde_perf8;
+    % endif
+    % endif
+    % if e.threaded:
+    if (${e.name}_tilde_thread_setup(x, perform, sp[0]->s_n))
+        perform = ${e.name}_tilde_perform_threaded;
+    % endif
+
+    dsp_add(perform, ${2 + nin + nch}, x,
+            % for c in range(nin + nch):
+            sp[${c}]->s_vec,
+            % endfor
+            sp[0]->s_n);
+    % endif
 }
 
 
@@ -128,19 +1589,56 @@ void ${e.name}_tilde_dsp(t_xfade_tilde *x, t_signal **sp)
  * ---------------------------------------------------------------------------
  */
 
-
 /**
  * this is the "destructor" of the class;
  * it allows us to free dynamically allocated ressources
+ * (inlets and outlets are freed by pd)
  */
 void ${e.name}_tilde_free(t_${e.name}_tilde *x)
 {
-  /* free any ressources associated with the given inlet */
-  inlet_free(x->x_in2);
-  inlet_free(x->x_in3);
-
-  /* free any ressources associated with the given outlet */
-  outlet_free(x->x_out);
+    % if e.threaded:
+    if (x->thread_started) {
+        ${e.name}_tilde_thread_wait(x);
+        x->thread_quit = 1;
+        xt_sem_post(&x->thread_wake);
+        xt_thread_join(x->thread);
+        xt_sem_destroy(&x->thread_wake);
+    }
+    if (x->thread_buf)
+        freebytes(x->thread_buf, ${nin + nch} * x->thread_n * sizeof(t_sample));
+    % endif
+    % if e.spectral:
+    if (x->stft.mem)
+        freebytes(x->stft.mem, x->stft.nbytes);
+    % endif
+    % if e.dsp_outlets:
+    clock_free(x->report_clock);
+    freebytes(x->report_ring.mem, x->report_ring.nbytes);
+    % endif
+    % if kern and kern.free:
+    ${kern.free.strip()}
+    % endif
+    % for b in e.buffers:
+    if (x->${b.name})
+        freebytes(x->${b.name}, x->${b.name}_size * sizeof(t_sample));
+    % endfor
+    % for p in e.delay_params:
+    if (x->${p.delay_line}.mem)
+        freebytes(x->${p.delay_line}.mem, x->${p.delay_line}.nbytes);
+    % endfor
+    % if e.tables and lib:
+    % for t in e.tables:
+    ${lib.table(t)}_release();
+    % endfor
+    % elif e.tables:
+    ${e.name}_tilde_tables_release();
+    % endif
+    % if e.multichannel:
+    % for st in e.state:
+    if (x->${st.name})
+        freebytes(x->${st.name}, x->nchans * sizeof(t_sample));
+    % endfor
+    % endif
 }
 
 
@@ -154,21 +1652,149 @@ void *${e.name}_tilde_new(${e.class_new_args})
     t_${e.name}_tilde *x = (t_${e.name}_tilde *)pd_new(${e.name}_tilde_class);
 
     // initialize variables
-    % for p in e.params:
+    % for p in e.object_params:
     x->${p.name} = ${p.initial};
     % endfor
+    x->sr = sys_getsr();
+    x->vs = 0;
+    % if e.denormal_dc:
+    x->denormal_bias = DENORMAL_BIAS;
+    % endif
+    % if e.recomputed_params:
+    x->dirty = DIRTY_ALL;
+    % endif
+    % for p in e.smoothed_params:
+    x->${p.name}_cur = x->${p.name};
+    x->${p.name}_step = 0;
+    x->${p.name}_togo = 0;
+    x->${p.name}_ramp = ${e.name}_tilde_ramp_samples(${p.smooth}, x->sr);
+    % endfor
+    % if kern:
+
+    // the kernel lives in the object (zeroed by pd_new), aligned to KERNEL_ALIGN
+    x->${kern.name} = (${kern.type} *)(((uintptr_t)x->${kern.storage} + KERNEL_ALIGN - 1) & ~(uintptr_t)(KERNEL_ALIGN - 1));
+    % endif
+    % for b in e.buffers:
+    x->${b.name} = 0;
+    x->${b.name}_size = 0;
+    % endfor
+    % for p in e.delay_params:
+    x->${p.delay_line}.mem = 0;
+    x->${p.delay_line}.nbytes = 0;
+    % endfor
+    % if e.events:
+    xt_events_init(&x->events);
+    x->event_start = x->event_end = clock_gettimesince(0);
+    % endif
+    % if e.threaded:
+
+    // the worker thread is started by the dsp method
+    % for p in e.variable_params:
+    x->pending.${p.name} = x->${p.name};
+    % endfor
+    xt_store_release(&x->thread_done, 0);
+    x->thread_posted = 0;
+    x->thread_started = 0;
+    x->thread_quit = 0;
+    x->thread_buf = 0;
+    x->thread_n = 0;
+    % endif
+    % if e.spectral:
+    x->stft.mem = 0;
+    x->stft.nbytes = 0;
+    % endif
+    % if e.dsp_outlets:
+
+    // the report ring and clock of the from_dsp outlets (the messages are zeroed by pd_new)
+    xt_ring_init(&x->report_ring, getbytes(xt_ring_bytes(REPORT_QUEUE * sizeof(t_${e.name}_tilde_report))),
+        REPORT_QUEUE * sizeof(t_${e.name}_tilde_report));
+    x->report_clock = clock_new(x, (t_method)${e.name}_tilde_report_tick);
+    xt_store_release(&x->report_armed, 0);
+    % for o in e.dsp_outlets:
+    x->out_${o.name}_sent = clock_getsystimeafter(-${o.rate});    // the first report is sent at once
+    x->out_${o.name}_pending = 0;
+    % endfor
+    % endif
+    % if e.table_params:
+
+    // arrays may be created after the object: they are looked up by the dsp method
+    % for p in e.table_params:
+    x->${p.name} = ${sym(p.initial or "")};
+    x->${p.name}_vec = ${e.name}_tilde_silence;
+    x->${p.name}_len = 4;
+    % endfor
+    % endif
+    % if e.tables and lib:
+
+    // filled by the first instance of a class of ${lib.name} reading them
+    % for t in e.tables:
+    x->${t.name} = ${lib.table(t)}_acquire();
+    % endfor
+    % elif e.tables:
+
+    ${e.name}_tilde_tables_acquire();
+    % for t in e.tables:
+    x->${t.name} = &${e.name}_tilde_${t.name};
+    % endfor
+    % endif
+    % if e.multichannel:
+    % for st in e.state:
+    x->${st.name} = 0;
+    % endfor
+    x->nchans = 0;
+    % endif
+    % if e.poly:
+
+    // all voices start idle (the pool is zeroed by pd_new)
+    for (int v = 0; v < POLY_SLOTS; v++) {
+        % for p in e.voice_params:
+        x->${p.name}[v] = ${p.initial};
+        % endfor
+        % for st in e.state:
+        x->${st.name}[v] = ${st.initial};
+        % endfor
+    }
+    x->poly_serial = 0;
+    % endif
 
     // populate variables
     % if len(e.args) > 0:
     // switch stmt here
     % endif
 
-    // create inlets
-    // inlet_new(&x->x_obj, &x->x_obj.ob_pd, gensym("list"), gensym("bound"));
+    % if not e.multichannel:
+    // create signal inlets (the main signal inlet is created by pd)
+    for (int i = 1; i < N_CHANNELS; i++) {
+        inlet_new(&x->x_obj, &x->x_obj.ob_pd, &s_signal, &s_signal);
+    }
+    % endif
+    % if e.signal_params:
+
+    // create param signal inlets, which may also receive floats
+    x->x_canvas = canvas_getcurrent();
+    % for j, p in enumerate(e.signal_params):
+    signalinlet_new(&x->x_obj, x->${p.name});
+    x->${p.name}_scalar = obj_findsignalscalar(&x->x_obj, ${nio + j});
+    x->${p.name}_last = x->${p.name};
+    x->${p.name}_connected = 0;
+    % endfor
+    % endif
+
+    // create inlets (routed to the param-setters)
     % for i in e.inlets:
-    ${i.type}inlet_new(&x->x_obj, &x->${i.name});
+    inlet_new(&x->x_obj, &x->x_obj.ob_pd, &s_float, ${sym(i.name)});
     % endfor
 
+    % if e.multichannel:
+    // create the multichannel signal outlet (its channels are set by the dsp method)
+    outlet_new(&x->x_obj, &s_signal);
+    % else:
+    // create signal outlets
+    for (int i = 0; i < N_CHANNELS; i++) {
+        outlet_new(&x->x_obj, &s_signal);
+    }
+    % endif
+
     // initialize outlets
     % for o in e.outlets:
     x->out_${o.name} = outlet_new(&x->x_obj, &s_${o.type});
@@ -178,9 +1804,6 @@ void *${e.name}_tilde_new(${e.class_new_args})
 }
 
 
-
-
-
 /*
  * ${e.name} class setup
  * ---------------------------------------------------------------------------
@@ -188,35 +1811,71 @@ void *${e.name}_tilde_new(${e.class_new_args})
 
 void ${e.name}_tilde_setup(void) 
 {
-    ${e.name}_tilde_class = class_new(gensym("${e.name}~"),
+    ${e.name}_tilde_class = class_new(${sym(e.name + "~")},
                             (t_newmethod)${e.name}_tilde_new,
-                            ${e.name}_tilde_free,
+                            (t_method)${e.name}_tilde_free,
                             sizeof(t_${e.name}_tilde),
+                            % if e.multichannel:
+#if PD_MINOR_VERSION >= 54
+                            CLASS_DEFAULT | CLASS_MULTICHANNEL,
+#else
+                            CLASS_DEFAULT,
+#endif
+                            % else:
                             CLASS_DEFAULT,
+                            % endif
                             ${e.class_type_signature});
 
     // typed methods
     %for m in e.type_methods:
-    ${m.class_addmethod};
+    ${m.addmethod(sym)};
     % endfor
 
     // message methods
     %for m in e.message_methods:
-    ${m.class_addmethod};
+    ${m.addmethod(sym)};
+    % endfor
+
+    // param-setters
+    % for p in e.settable_params:
+    % if e.events:
+    class_addmethod(${e.klass}, (t_method)${e.name}_tilde_event_${p.name}, ${sym(p.name)}, A_FLOAT, 0);
+    % else:
+    class_addmethod(${e.klass}, (t_method)${e.name}_tilde_set_${p.name}, ${sym(p.name)}, A_FLOAT, 0);
+    % endif
     % endfor
+    % for p in e.table_params:
+    class_addmethod(${e.klass}, (t_method)${e.name}_tilde_set_${p.name}, ${sym(p.name)}, A_DEFSYMBOL, 0);
+    % endfor
+    % if e.table_set:
+    class_addmethod(${e.klass}, (t_method)${e.name}_tilde_set_${e.table_set.name}, ${sym("set")}, A_DEFSYMBOL, 0);
+    % endif
+    % if e.poly:
+
+    // voice messages
+    class_addmethod(${e.klass}, (t_method)${e.name}_tilde_note, ${sym("note")}, A_FLOAT, A_FLOAT, 0);
+    class_addmethod(${e.klass}, (t_method)${e.name}_tilde_voice, ${sym("voice")}, A_FLOAT, A_FLOAT, A_FLOAT, 0);
+    % for p in e.voice_params:
+    class_addmethod(${e.klass}, (t_method)${e.name}_tilde_set_${p.name}, ${sym(p.name)}, A_FLOAT, A_FLOAT, 0);
+    % endfor
+    % endif
+
+#ifdef XT_PROFILE
+    class_addmethod(${e.klass}, (t_method)${e.name}_tilde_stats, ${sym("stats")}, 0);
 
+#endif
     // set main signal in
-    CLASS_MAINSIGNALIN(${e.name}_tilde_class, ${e.name}_tilde, x_f);
+    CLASS_MAINSIGNALIN(${e.name}_tilde_class, t_${e.name}_tilde, x_f);
 
     /* Bind the DSP method, which is called when the DACs are turned on */
-    class_addmethod(${e.name}_tilde_class, (t_method){e.name}_tilde_dsp, gensym("dsp"), 0);
+    class_addmethod(${e.name}_tilde_class, (t_method)${e.name}_tilde_dsp, ${sym("dsp")}, 0);
 
     % if e.alias:
     // set the alias to external
-    ${e.class_addcreator};
+    ${e.addcreator(sym)};
     % endif
 
     // set name of default help file
-    class_sethelpsymbol(${e.name}_tilde_class, gensym("${e.help}"));
+    class_sethelpsymbol(${e.name}_tilde_class, ${sym(e.help)});
 }
 
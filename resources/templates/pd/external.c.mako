@@ -13,6 +13,9 @@ Repo: ${e.meta['repo']}
 */
 
 #include "m_pd.h"
+% if lib:
+#include "${lib.name}.h"   // symbols shared by the classes of ${lib.name}
+% endif
 
 /*
  * ${e.name} class object
@@ -110,7 +113,7 @@ void *${e.name}_new(${e.class_new_args})
 
 void ${e.name}_setup(void) 
 {
-    ${e.name}_class = class_new(gensym("${e.name}"),
+    ${e.name}_class = class_new(${sym(e.name)},
                             (t_newmethod)${e.name}_new,
                             0, // destructor
                             sizeof(t_${e.name}),
@@ -119,20 +122,20 @@ void ${e.name}_setup(void)
 
     // typed methods
     %for m in e.type_methods:
-    ${m.class_addmethod};
+    ${m.addmethod(sym)};
     % endfor
 
     // message methods
     %for m in e.message_methods:
-    ${m.class_addmethod};
+    ${m.addmethod(sym)};
     % endfor
 
     % if e.alias:
     // set the alias to external
-    ${e.class_addcreator};
+    ${e.addcreator(sym)};
     % endif
 
     // set name of default help file
-    class_sethelpsymbol(${e.name}_class, gensym("${e.help}"));
+    class_sethelpsymbol(${e.name}_class, ${sym(e.help)});
 }
 
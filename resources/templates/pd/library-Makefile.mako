@@ -0,0 +1,44 @@
+# Makefile for the ${lib.name} library: all classes in one binary
+
+lib.name = ${lib.name}
+
+lib.setup.sources = ${lib.name}.c
+
+class.sources = ${" ".join(lib.sources)}
+
+make-lib-executable = yes
+
+datafiles = ${" ".join(e.name + "-help.pd" for e in lib.externals)}
+
+suppress-wunused = true
+
+# build profile: make PROFILE=release|debug. CFLAGS given on the command
+# line still replace the flags of the profile (and pd-lib-builder's).
+PROFILE ?= ${lib.build.profile}
+MARCH ?=
+
+# the binary is portable by default: MARCH (e.g. native) tunes it for a cpu,
+# replacing the -march or -mcpu of pd-lib-builder's arch.c.flags
+march.flags = $(if $(MARCH),$(filter-out -march=% -mcpu=%,$(arch.c.flags)) -march=$(MARCH),$(arch.c.flags))
+
+profile.release.flags = ${lib.build.release_flags}
+profile.release.ldflags = ${"$(march.flags) $(profile.release.flags)" if lib.build.lto else ""}
+profile.debug.flags = -O0 -g
+profile.debug.ldflags =
+
+ifneq ($(origin CFLAGS), command line)
+override CFLAGS = $(warn.flags) $(march.flags) $(profile.$(PROFILE).flags) $(pgo.flags)
+endif
+ldflags = $(profile.$(PROFILE).ldflags) $(pgo.flags)
+% if any(e.threaded for e in lib.externals):
+
+ldlibs = -lpthread
+% endif
+
+% if any(e.signal_params for e in lib.externals):
+# the signal inlets include pd's m_imp.h and g_canvas.h, which xtgen does not
+# bundle (only m_pd.h): PDINCLUDEDIR must point at the headers of a full pd,
+# the src/ of a pd source tree or the include/pd of an installed pd
+# (pd-lib-builder's default)
+% endif
+include Makefile.pdlibbuilder
@@ -0,0 +1,83 @@
+/* ${lib.name}.c
+
+Setup of the ${lib.name} library: a single binary registering all of its
+classes, loaded by pd with `-lib ${lib.name}` or [declare -lib ${lib.name}].
+
+*/
+
+#include "${lib.name}.h"
+
+% for name, c in lib.symbols.items():
+t_symbol *${c};
+% endfor
+% if lib.tables:
+
+/*
+ * lookup tables shared by the classes
+ * ---------------------------------------------------------------------------
+ */
+% for c, t in lib.tables:
+
+static t_xt_table ${c};   // ${t.desc or t.source}
+static int ${c}_refs;
+% if t.points:
+
+static const t_sample ${c}_points[${t.size}] = {
+% for i in range(0, t.size, 8):
+    ${", ".join(t.points[i:i + 8])},
+% endfor
+};
+% endif
+
+const t_xt_table *${c}_acquire(void)
+{
+    if (${c}_refs++)
+        return &${c};
+    xt_table_init(&${c}, getbytes(xt_table_bytes(${t.size})), ${t.size});
+    % if t.source == "sine":
+    xt_table_fill_sine(&${c});
+    % elif t.source == "saw":
+    xt_table_fill_saw(&${c}, ${t.harmonics});
+    % else:
+    for (uint32_t i = 0; i < ${t.size}; i++) {
+        % if t.source == "expr":
+        double p = (double)i / ${t.size};
+        ${c}.data[i] = (t_sample)(${t.expr});
+        % else:
+        ${c}.data[i] = ${c}_points[i];
+        % endif
+    }
+    xt_table_guard(&${c});
+    % endif
+    return &${c};
+}
+
+void ${c}_release(void)
+{
+    if (--${c}_refs)
+        return;
+    freebytes(${c}.mem, ${c}.nbytes);
+}
+% endfor
+% endif
+
+
+/*
+ * ${lib.name} library setup
+ * ---------------------------------------------------------------------------
+ */
+
+% for e in lib.externals:
+void ${e.c_name}_setup(void);
+% endfor
+
+void ${lib.name}_setup(void)
+{
+    % for name, c in lib.symbols.items():
+    ${c} = gensym("${name}");
+    % endfor
+
+    % for e in lib.externals:
+    ${e.c_name}_setup();
+    % endfor
+}
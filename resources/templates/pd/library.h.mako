@@ -0,0 +1,40 @@
+/* ${lib.name}.h
+
+Symbols and lookup tables shared by the classes of the ${lib.name} library,
+defined in ${lib.name}.c.
+
+Classes:
+% for e in lib.externals:
+- ${e.name}${"~" if e.is_dsp else ""}
+% endfor
+
+*/
+
+#ifndef ${lib.guard}
+#define ${lib.guard}
+
+#include "m_pd.h"
+% if lib.tables:
+
+#ifndef XT_SAMPLE
+#define XT_SAMPLE t_sample
+#endif
+#include "xtgen_table.h"
+% endif
+
+/* selectors and names of all classes, interned once by ${lib.name}_setup() */
+% for name, c in lib.symbols.items():
+extern t_symbol *${c};    // ${name}
+% endfor
+% if lib.tables:
+
+/* lookup tables with the same points are shared by all classes: acquire
+ * fills a table for the first instance reading it, release frees it with
+ * the last one */
+% for c, t in lib.tables:
+const t_xt_table *${c}_acquire(void);   // ${t.size} points: ${t.desc or t.source}
+void ${c}_release(void);
+% endfor
+% endif
+
+#endif // ${lib.guard}
@@ -4,6 +4,8 @@
 */
 #include "oscillator.h"
 #include <cstdlib>
+#include <new>
+#include <stdint.h>
 
 #include "ext.h"
 #include "ext_obex.h"
@@ -22,7 +24,9 @@ enum {
 // struct to represent the object's state
 typedef struct _mdsp {
     t_pxobject ob;              // the object itself (t_pxobject in MSP instead of t_object)
-    daisysp::Oscillator* osc;   // daisy osc object
+    daisysp::Oscillator* osc;   // daisy osc object, constructed in osc_storage
+    char osc_storage[sizeof(daisysp::Oscillator) + 63]; // room to align osc to a cache line
+    double sr;                  // sample rate osc was initialized with (0 until dsp64)
     double freq;                // Changes the frequency of the Oscillator, and recalculates phase increment.
     double amp;                 // Sets the amplitude of the waveform.
     int waveform;               // Sets the waveform to be synthesized by the Process() function.
@@ -88,7 +92,8 @@ void *mdsp_new(t_symbol *s, long argc, t_atom *argv)
             x->inlets[i] = proxy_new((t_object *)x, i, &x->m_in);
         }
 
-        x->osc = new daisysp::Oscillator;
+        x->osc = new ((void *)(((uintptr_t)x->osc_storage + 63) & ~(uintptr_t)63)) daisysp::Oscillator;
+        x->sr = 0.0;
         x->freq = 100.0;
         x->amp = 0.5;
         x->waveform = daisysp::Oscillator::WAVE_SIN;
@@ -101,8 +106,8 @@ void *mdsp_new(t_symbol *s, long argc, t_atom *argv)
 
 void mdsp_free(t_mdsp *x)
 {
-    delete x->osc;
     dsp_free((t_pxobject *)x);
+    x->osc->~Oscillator();
     for(int i = (MAX_INLET_INDEX - 1); i > 0; i--) {
         object_free(x->inlets[i]);
     }
@@ -164,8 +169,12 @@ void mdsp_dsp64(t_mdsp *x, t_object *dsp64, short *count, double samplerate, lon
     post("sample rate: %f", samplerate);
     post("maxvectorsize: %d", maxvectorsize);
 
-    x->osc->Init(samplerate);
-    x->osc->Reset();
+    // dsp64 runs on every rebuild of the dsp chain: only re-init on a new sample rate
+    if (samplerate != x->sr) {
+        x->osc->Init(samplerate);
+        x->osc->Reset();
+        x->sr = samplerate;
+    }
 
     object_method(dsp64, gensym("dsp_add64"), x, mdsp_perform64, 0, NULL);
 }
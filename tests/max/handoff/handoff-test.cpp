@@ -0,0 +1,69 @@
+/*
+ * handoff-test.cpp
+ *
+ * checks the seqlock param handoff of the Max wrapper (handoff: seqlock) on
+ * the generated bound~: a message setting two params by calling their
+ * setters between bnd_params_begin/_end must be published as one snapshot,
+ * the perform routine never seeing one bound without the other.
+ *
+ *   make test
+ *
+ * The generated external is compiled into this file, against the stubs of
+ * the max api of the benchmark harness, to reach its static functions.
+ */
+
+#define main xtbench_main   // the harness' own driver is not used
+#include "xtbench_mx.cpp"
+#undef main
+
+#include "bound~.c"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            fprintf(stderr, "%s:%d: failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+int main(void)
+{
+    t_bnd_params snap;
+
+    ext_main(0);
+    t_bnd *x = (t_bnd *)bnd_new(gensym("bound~"), 0, 0);
+
+    // a setter on its own publishes its param
+    bnd_set_lower(x, 0.25);
+    CHECK(bnd_params_read(x, &snap) && snap.lower == 0.25);
+    CHECK(!bnd_params_read(x, &snap));          // picked up once
+
+    // the body of "bound 0.5 0.75": the pairs of the setters nest in the
+    // outer one, which alone publishes
+    bnd_params_begin(x);
+    bnd_params_begin(x);                        // inside bnd_set_lower
+    x->pending.lower = 0.5;
+    CHECK(!bnd_params_read(x, &snap));          // not the lower bound alone
+    bnd_params_end(x);
+    CHECK(!bnd_params_read(x, &snap));
+    bnd_set_upper(x, 0.75);
+    CHECK(!bnd_params_read(x, &snap));
+    bnd_params_end(x);
+    CHECK(bnd_params_read(x, &snap) && snap.lower == 0.5 && snap.upper == 0.75);
+
+    // the perform routine applies the snapshot at the start of a block
+    bnd_set_upper(x, 0.8);
+    bnd_prepare(x, 64);
+    CHECK(x->lower == 0.5 && x->upper == 0.8);
+
+    bnd_free(x);
+    free(x);
+    if (failures) {
+        fprintf(stderr, "handoff-test: %d failure(s)\n", failures);
+        return 1;
+    }
+    printf("handoff-test: ok\n");
+    return 0;
+}
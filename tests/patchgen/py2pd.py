@@ -4,6 +4,9 @@ A pure python to pd transpiler.
 
 """
 
+import json
+import os
+
 class Mixin:
     def __repr__(self):
         return f"<{self.__class__.__name__}: '{self}'>"
@@ -25,12 +28,14 @@ class canvas(Mixin):
     def __init__(self, x_pos=None, y_pos=None, x_size=None, y_size=None, font_size=None):
         self.chunk_type = "#N"
         self.type = "canvas"
-        self.x_pos = x_pos if x_pos else self.DEFAULT_X_POS
-        self.y_pos = y_pos if y_pos else self.DEFAULT_Y_POS
-        self.x_size = x_size if x_size else self.DEFAULT_X_SIZE
-        self.y_size = x_size if y_size else self.DEFAULT_Y_SIZE
-        self.font_size = font_size if font_size else self.DEFAULT_FONT_SIZE
+        self.x_pos = x_pos if x_pos is not None else self.DEFAULT_X_POS
+        self.y_pos = y_pos if y_pos is not None else self.DEFAULT_Y_POS
+        self.x_size = x_size if x_size is not None else self.DEFAULT_X_SIZE
+        self.y_size = y_size if y_size is not None else self.DEFAULT_Y_SIZE
+        self.font_size = font_size if font_size is not None else self.DEFAULT_FONT_SIZE
 
+    def __str__(self):
+        return " ".join(str(i) for i in self.property_list) + ";"
 
     @property
     def property_list(self):
@@ -57,7 +62,7 @@ class subcanvas(canvas):
     def __init__(self, name='', x_pos=None, y_pos=None, x_size=None, y_size=None, font_size=None, open_on_load=None):
         super().__init__(x_pos, y_pos, x_size, y_size, font_size)
         self.name = name
-        self.open_on_load = open_on_load if open_on_load else self.DEFAULT_OPEN_ON_LOAD
+        self.open_on_load = open_on_load if open_on_load is not None else self.DEFAULT_OPEN_ON_LOAD
 
     @property
     def property_list(self):
@@ -188,6 +193,344 @@ class bng(PdObject):
 
     """
 
+
+class text(PdObject):
+    """pd comment
+
+    #X text <x_pos> <y_pos> <text>
+
+    >>> t = text("load", "%")
+    >>> str(t)
+    '#X text 20 20 load %;'
+
+    """
+
+    def __init__(self, *args, **kwds):
+        super().__init__("X", "text", *args, **kwds)
+
+
+class connect(Mixin):
+    """connection from an outlet to an inlet, objects being numbered in
+    the order of their canvas
+
+    #X connect <source> <outlet> <sink> <inlet>
+
+    >>> str(connect(1, 0, 0, 0))
+    '#X connect 1 0 0 0;'
+
+    """
+
+    def __init__(self, source, outlet, sink, inlet):
+        self.source = source
+        self.outlet = outlet
+        self.sink = sink
+        self.inlet = inlet
+
+    @property
+    def property_list(self):
+        return ["#X", "connect", self.source, self.outlet, self.sink, self.inlet]
+
+    def __str__(self):
+        return " ".join(str(i) for i in self.property_list) + ";"
+
+
+_canvas = canvas     # shadowed by the arguments of Patch
+
+
+class Canvas:
+    """the objects a canvas can be built with, by Patch and PatchWriter"""
+
+    def add_obj(self, name, *args, **kwds) -> int:
+        return self.add(obj(name, *args, **kwds))
+
+    def add_msg(self, *args, **kwds) -> int:
+        return self.add(msg(*args, **kwds))
+
+    def add_number(self, label='-', min=0, max=0, **kwds) -> int:
+        return self.add(floatatom(label, min, max, **kwds))
+
+    def add_text(self, *args, **kwds) -> int:
+        return self.add(text(*args, **kwds))
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, error, *exc):
+        if error is None:       # no half-built patch
+            self.close()
+
+
+class Patch(Canvas):
+    """a pd canvas: its objects, subpatches and connections
+
+    Objects are referred to by their index in the canvas, which is what
+    `#X connect` records use. A subpatch is an object of its parent canvas
+    holding a Patch of its own. Dollar signs and semicolons of object and
+    message text are given escaped (`\\$0`, `\\;`), as pd files hold them.
+
+    >>> p = Patch('demo.pd')
+    >>> osc = p.add_obj('osc~', 440)
+    >>> freq = p.add_number('freq', min=0, max=500)
+    >>> dac = p.add_obj('dac~')
+    >>> p.link(freq, osc)
+    >>> p.link(osc, dac)
+    >>> p.link(osc, dac, inlet=1)
+    >>> print(p, end="")
+    #N canvas 394 140 445 318 12;
+    #X obj 20 40 osc~ 440;
+    #X floatatom 20 40 5 0 500 0 freq - - 0;
+    #X obj 20 40 dac~;
+    #X connect 1 0 0 0;
+    #X connect 0 0 2 0;
+    #X connect 0 0 2 1;
+
+    """
+
+    def __init__(self, path=None, canvas=None, x=0, y=0):
+        self.path = path
+        self.canvas = canvas if canvas else _canvas()
+        self.x = x      # position of a subpatch in its parent
+        self.y = y
+        self.objects = []
+        self.connections = []
+
+    def __len__(self):
+        return len(self.objects)
+
+    def add(self, o) -> int:
+        self.objects.append(o)
+        return len(self.objects) - 1
+
+    def add_subpatch(self, name, x=20, y=40) -> 'Patch':
+        """a subpatch (closed on load) added to this canvas"""
+        sub = Patch(canvas=subcanvas(name, open_on_load=0), x=x, y=y)
+        self.add(sub)
+        return sub
+
+    subpatch = add_subpatch     # as PatchWriter.subpatch(), usable in a with block
+
+    def link(self, source: int, sink: int, outlet=0, inlet=0):
+        self.connections.append(connect(source, outlet, sink, inlet))
+
+    def records(self):
+        """the records of the canvas, subpatches included"""
+        yield str(self.canvas)
+        for o in self.objects:
+            if isinstance(o, Patch):
+                yield from o.records()
+                yield f"#X restore {o.x} {o.y} pd {o.canvas.name};"
+            else:
+                yield str(o)
+        for c in self.connections:
+            yield str(c)
+
+    def __str__(self):
+        return "".join(r + "\n" for r in self.records())
+
+    def save(self, path=None):
+        with open(path or self.path, "w") as f:
+            for r in self.records():
+                f.write(r + "\n")
+
+    def close(self):
+        """saves a patch which has a path (subpatches are saved by their parent)"""
+        if self.path:
+            self.save()
+
+
+class PatchWriter(Canvas):
+    """a pd patch written to its file record by record, as it is built
+
+    Nothing but the object count of the open canvases is kept in memory:
+    objects and connections are written as they are added (pd only needs
+    both ends of a connection to exist when it reads it), so patches of
+    tens of thousands of objects are written in constant memory and in the
+    order pd reads them. A subpatch is written in place by the writer
+    `subpatch()` returns, until it is closed (by `close()` or the end of a
+    `with` block), which restores it into its parent.
+
+    >>> import io
+    >>> f = io.StringIO()
+    >>> with PatchWriter(f) as p:
+    ...     noise = p.add_obj('noise~')
+    ...     with p.subpatch('out') as sub:
+    ...         sub.link(sub.add_obj('inlet~'), sub.add_obj('dac~'))
+    ...     p.link(noise, 1)
+    >>> print(f.getvalue(), end="")
+    #N canvas 394 140 445 318 12;
+    #X obj 20 40 noise~;
+    #N canvas 394 140 445 318 out 0;
+    #X obj 20 40 inlet~;
+    #X obj 20 40 dac~;
+    #X connect 0 0 1 0;
+    #X restore 20 40 pd out;
+    #X connect 0 0 1 0;
+
+    """
+
+    def __init__(self, file, canvas=None, parent=None, x=0, y=0):
+        self.file = open(file, "w") if isinstance(file, (str, os.PathLike)) else file
+        self.owns_file = self.file is not file
+        self.canvas = canvas if canvas else _canvas()
+        self.parent = parent
+        self.x = x
+        self.y = y
+        self.count = 0
+        self.writing = None     # the subpatch being written
+        self.file.write(str(self.canvas) + "\n")
+
+    def __len__(self):
+        return self.count
+
+    def write(self, record: str):
+        assert self.writing is None, f"subpatch {self.writing.canvas.name} is not closed"
+        self.file.write(record + "\n")
+
+    def add(self, o) -> int:
+        self.write(str(o))
+        self.count += 1
+        return self.count - 1
+
+    def link(self, source: int, sink: int, outlet=0, inlet=0):
+        assert source < self.count and sink < self.count, "connection to an object not written yet"
+        self.write(str(connect(source, outlet, sink, inlet)))
+
+    def subpatch(self, name, x=20, y=40) -> 'PatchWriter':
+        """the writer of a subpatch (closed on load), the next object of this canvas"""
+        assert self.writing is None, f"subpatch {self.writing.canvas.name} is not closed"
+        sub = PatchWriter(self.file, subcanvas(name, open_on_load=0), self, x, y)
+        self.writing = sub
+        return sub
+
+    def close(self):
+        """restores a subpatch into its parent, or closes the file of the patch"""
+        assert self.writing is None, f"subpatch {self.writing.canvas.name} is not closed"
+        if self.parent:
+            self.parent.writing = None
+            self.parent.add(f"#X restore {self.x} {self.y} pd {self.canvas.name};")
+        elif self.owns_file:
+            self.file.close()
+
+
+class Abstractions:
+    """repeated structures written once, as abstraction files of `directory`
+
+    Instead of a copy of each repeated subpatch, a patch instantiates an
+    abstraction by name, its arguments (`\\$1`, `\\$2`... inside, `#1` in
+    Max) making the instances differ. `writer` opens a patch of a path
+    (PatchWriter for pd, MaxPatch for Max, with `extension`).
+
+    >>> import tempfile
+    >>> abstractions = Abstractions(tempfile.mkdtemp())
+    >>> def voice(p):
+    ...     p.link(p.add_obj('osc~', '\\$1'), p.add_obj('outlet~'))
+    >>> abstractions.get('voice', voice)
+    'voice'
+    >>> print(open(os.path.join(abstractions.directory, 'voice.pd')).read(), end="")
+    #N canvas 394 140 445 318 12;
+    #X obj 20 40 osc~ \\$1;
+    #X obj 20 40 outlet~;
+    #X connect 0 0 1 0;
+
+    """
+
+    def __init__(self, directory, writer=PatchWriter, extension=".pd"):
+        self.directory = directory
+        self.writer = writer
+        self.extension = extension
+        self.written = set()
+
+    def get(self, name: str, build) -> str:
+        """the name to instantiate abstraction `name` with, written by
+        `build(patch)` the first time it is asked for"""
+        if name not in self.written:
+            with self.writer(os.path.join(self.directory, name + self.extension)) as p:
+                build(p)
+            self.written.add(name)
+        return name
+
+
+class MaxPatch:
+    """the Max counterpart of Patch, saved as a .maxpat (json) patcher
+
+    Boxes are referred to by their index as in Patch, and a subpatcher
+    ([p <name>]) is a box holding a MaxPatch of its own.
+
+    >>> p = MaxPatch()
+    >>> osc = p.add_obj('cycle~', 440)
+    >>> dac = p.add_obj('ezdac~')
+    >>> p.link(osc, dac)
+    >>> p.patcher["lines"][0]
+    {'patchline': {'source': ['obj-1', 0], 'destination': ['obj-2', 0]}}
+
+    """
+
+    def __init__(self, path=None, x=20, y=40):
+        self.path = path
+        self.x = x
+        self.y = y
+        self.boxes = []
+        self.lines = []
+
+    def __len__(self):
+        return len(self.boxes)
+
+    def add(self, box: dict, x=20, y=40) -> int:
+        box["id"] = f"obj-{len(self.boxes) + 1}"
+        box["patching_rect"] = [x, y, 100.0, 22.0]
+        self.boxes.append(box)
+        return len(self.boxes) - 1
+
+    def add_obj(self, name, *args, x=20, y=40) -> int:
+        return self.add({"maxclass": "newobj",
+                         "text": " ".join(str(i) for i in (name,) + args)}, x, y)
+
+    def add_msg(self, *args, x=20, y=40) -> int:
+        return self.add({"maxclass": "message", "text": " ".join(str(i) for i in args)}, x, y)
+
+    def add_number(self, x=20, y=40) -> int:
+        return self.add({"maxclass": "flonum"}, x, y)
+
+    def add_text(self, *args, x=20, y=40) -> int:
+        return self.add({"maxclass": "comment", "text": " ".join(str(i) for i in args)}, x, y)
+
+    def add_subpatch(self, name, x=20, y=40) -> 'MaxPatch':
+        sub = MaxPatch(x=x, y=y)
+        self.add({"maxclass": "newobj", "text": f"p {name}", "patcher": sub}, x, y)
+        return sub
+
+    subpatch = add_subpatch
+
+    def link(self, source: int, sink: int, outlet=0, inlet=0):
+        self.lines.append({"patchline": {"source": [self.boxes[source]["id"], outlet],
+                                         "destination": [self.boxes[sink]["id"], inlet]}})
+
+    @property
+    def patcher(self) -> dict:
+        boxes = []
+        for box in self.boxes:
+            if "patcher" in box:
+                box = dict(box, patcher=box["patcher"].patcher)
+            boxes.append({"box": box})
+        return {"fileversion": 1, "rect": [100.0, 100.0, 640.0, 480.0],
+                "boxes": boxes, "lines": self.lines}
+
+    def save(self, path=None):
+        with open(path or self.path, "w") as f:
+            json.dump({"patcher": self.patcher}, f, indent=1)
+
+    def close(self):
+        if self.path:
+            self.save()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, error, *exc):
+        if error is None:
+            self.close()
+
+
 if __name__ == "__main__":
     import doctest
     doctest.testmod()
@@ -0,0 +1,312 @@
+"""stress.py
+
+Generates load patches of an external from its xtgen spec, to measure
+how the cost of an external scales with its instance count.
+
+    python3 tests/patchgen/stress.py resources/examples/lop~.yml -n 10,100,1000
+
+For each count and layout, `<name>-<layout>-<count>.pd` (and `.maxpat`)
+is written into the `stress/` directory of the generated project (see
+`-o`), next to the external it loads. The patches start dsp on load,
+feed every instance the same noise and random values of its settable
+params every `--rate` ms (as `<param> <value>` messages, or bangs when
+it has none), sum the outputs (muted) and show the cpu load: in pd the
+[cputime] / [realtime] ratio every second, as pd's load meter does, in
+Max [adstatus cpu].
+
+In the `flat` layout all instances are in the main patch. In the `nested`
+layout they are grouped by `--fanout` into subpatches of subpatches, each
+group taking the signal and the messages from its inlets and summing the
+outputs of its children into its outlets. The `abstraction` layout has the
+same groups, but each group size is written once, as the abstraction
+`<name>-group<size>-f<fanout>` which the patches of every count share,
+instantiated with the arguments of the external.
+
+The pd patches are streamed to their file as they are built (see
+py2pd.PatchWriter), so that large counts take no more memory than small ones.
+"""
+
+import argparse
+import math
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "..", ".."))
+
+import xtgen
+from py2pd import PatchWriter, MaxPatch, Abstractions, canvas
+
+
+class Host:
+    """the objects of the load patches in pd"""
+
+    inlet_signal = "inlet~"
+    outlet_signal = "outlet~"
+    argument = "\\$%d"
+    extension = ".pd"
+
+    def __init__(self, model: xtgen.External):
+        self.model = model
+
+    @property
+    def name(self) -> str:
+        return self.model.name + ("~" if self.model.is_dsp else "")
+
+    def new(self, path) -> PatchWriter:
+        patch = PatchWriter(path, canvas(x_size=900, y_size=760))
+        patch.add_obj("declare", "-path", "..", x=20, y=0)      # the project of the external
+        return patch
+
+    def dsp_on(self, patch, loadbang):
+        patch.link(loadbang, patch.add_msg("\\;", "pd", "dsp", 1, x=20, y=50))
+
+    def value(self, patch, p, x, y) -> tuple[int, int]:
+        """(in, out) of a random number in the range of param `p`"""
+        lo = p.min if p.min is not None else 0
+        hi = p.max if p.max is not None else 1
+        rnd = patch.add_obj("random", 1000, x=x, y=y)
+        scale = patch.add_obj("expr", f"{lo} + \\$f1 * {hi - lo} / 1000", x=x, y=y + 25)
+        patch.link(rnd, scale)
+        return rnd, scale
+
+    def message(self, patch, selector, x, y) -> int:
+        return patch.add_msg(selector, "\\$1", x=x, y=y)
+
+    def cpu_meter(self, patch, x, y) -> int:
+        """load in % of the time spent in the pd process, once a second"""
+        metro = patch.add_obj("metro", 1000, x=x, y=y)
+        trigger = patch.add_obj("t", "b", "b", "b", "b", x=x, y=y + 25)
+        cputime = patch.add_obj("cputime", x=x, y=y + 50)
+        realtime = patch.add_obj("realtime", x=x + 80, y=y + 50)
+        ratio = patch.add_obj("/", x=x, y=y + 75)
+        percent = patch.add_obj("*", 100, x=x, y=y + 100)
+        load = patch.add_number("load%", x=x, y=y + 125)
+        patch.link(metro, trigger)
+        patch.link(trigger, realtime, outlet=3, inlet=1)    # the elapsed times, real first (cold)
+        patch.link(trigger, cputime, outlet=2, inlet=1)
+        patch.link(trigger, realtime, outlet=1)             # then start over
+        patch.link(trigger, cputime, outlet=0)
+        patch.link(realtime, ratio, inlet=1)
+        patch.link(cputime, ratio)
+        patch.link(ratio, percent)
+        patch.link(percent, load)
+        return metro
+
+    def output(self, patch, x, y) -> int:
+        """the (muted) sum of one channel of all instances"""
+        mute = patch.add_obj("*~", 0, x=x, y=y)
+        dac = patch.add_obj("dac~", x=x, y=y + 25)
+        patch.link(mute, dac)
+        patch.link(mute, dac, inlet=1)
+        return mute
+
+
+class MaxHost(Host):
+    """the objects of the load patches in Max"""
+
+    inlet_signal = "inlet"
+    outlet_signal = "outlet"
+    argument = "#%d"
+    extension = ".maxpat"
+
+    @property
+    def name(self) -> str:
+        return f"{self.model.namespace}.{self.model.name}~"     # as the max templates register it
+
+    def new(self, path) -> MaxPatch:
+        return MaxPatch(path)
+
+    def dsp_on(self, patch, loadbang):
+        patch.link(loadbang, patch.add_msg(";", "dsp", "start", x=20, y=50))
+
+    def value(self, patch, p, x, y) -> tuple[int, int]:
+        lo = float(p.min if p.min is not None else 0)
+        hi = float(p.max if p.max is not None else 1)
+        rnd = patch.add_obj("random", 1000, x=x, y=y)
+        scale = patch.add_obj("scale", 0, 1000, lo, hi, x=x, y=y + 25)
+        patch.link(rnd, scale)
+        return rnd, scale
+
+    def message(self, patch, selector, x, y) -> int:
+        return patch.add_msg(selector, "$1", x=x, y=y)
+
+    def cpu_meter(self, patch, x, y) -> int:
+        metro = patch.add_obj("metro", 1000, x=x, y=y)
+        cpu = patch.add_obj("adstatus", "cpu", x=x, y=y + 25)
+        load = patch.add_number(x=x, y=y + 50)
+        patch.link(metro, cpu)
+        patch.link(cpu, load)
+        return metro
+
+    def output(self, patch, x, y) -> int:
+        mute = patch.add_obj("*~", 0.0, x=x, y=y)
+        dac = patch.add_obj("dac~", 1, 2, x=x, y=y + 25)
+        patch.link(mute, dac)
+        patch.link(mute, dac, inlet=1)
+        return mute
+
+
+def group_size(count: int, fanout: int) -> int:
+    """the size of the subgroups of a group of `count` > `fanout` instances:
+    the largest power of `fanout` below `count`, so that there are at most
+    `fanout` subgroups (integer arithmetic: math.log(125, 5) is not 3)
+
+    >>> group_size(100, 10), group_size(101, 10), group_size(1000, 10)
+    (10, 100, 100)
+    >>> group_size(125, 5), group_size(216, 6), group_size(15625, 5)
+    (25, 36, 3125)
+    >>> group_size(3, 2)
+    2
+    """
+    size = fanout
+    while size * fanout < count:
+        size *= fanout
+    return size
+
+
+class StressPatch:
+    """a load patch of `count` instances of an external in `layout`"""
+
+    layouts = ("flat", "nested", "abstraction")
+
+    def __init__(self, host: Host, count: int, layout="flat", fanout=10, rate=10,
+                 abstractions: Abstractions = None):
+        assert layout in self.layouts, f"unknown layout: {layout}"
+        assert fanout >= 2 and count >= 1
+        self.host = host
+        self.model = e = host.model
+        self.count = count
+        self.layout = layout
+        self.fanout = fanout
+        self.rate = rate
+        # signal inlets and outlets of an instance, which come first
+        self.n_signals = 0 if not e.is_dsp else 1 if e.multichannel else e.n_channels
+        self.args = [p.initial for p in e.args]
+        # the abstractions of the groups, shared by the patches of a directory
+        self.abstractions = abstractions
+        assert layout != "abstraction" or abstractions, "abstraction layout without a directory"
+
+    @property
+    def filename(self) -> str:
+        return f"{self.model.name}-{self.layout}-{self.count}{self.host.extension}"
+
+    def instances(self, patch, count: int, args, y=80) -> list[int]:
+        """`count` instances in rows of 10"""
+        return [patch.add_obj(self.host.name, *args, x=20 + 120 * (i % 10), y=y + 40 * (i // 10))
+                for i in range(count)]
+
+    def wire(self, patch, children, source, traffic, outputs, groups=False):
+        """connects the noise and the messages to the children (instances
+        or groups, which have a single signal inlet), and their signal
+        outlets to `outputs`, one per channel"""
+        for child in children:
+            if source is not None:
+                for i in range(1 if groups else self.n_signals):
+                    patch.link(source, child, inlet=i)
+            for t in traffic:
+                patch.link(t, child, inlet=1 if groups and source is not None else 0)
+            for c, out in enumerate(outputs):
+                patch.link(child, out, outlet=c)
+
+    def abstraction(self, count: int) -> str:
+        """the group of `count` instances as an abstraction, its instances
+        taking the arguments of the abstraction"""
+        args = [self.host.argument % (i + 1) for i in range(len(self.args))]
+        name = f"{self.model.name}-group{count}-f{self.fanout}"
+        return self.abstractions.get(name, lambda patch: self.group(patch, count, args))
+
+    def subgroup(self, patch, i: int, count: int, args) -> int:
+        x, y = 20 + 120 * (i % 10), 80 + 40 * (i // 10)
+        if self.layout == "abstraction":
+            return patch.add_obj(self.abstraction(count), *args, x=x, y=y)
+        with patch.subpatch(f"group{i}", x=x, y=y) as sub:
+            self.group(sub, count, args)
+        return len(patch) - 1
+
+    def group(self, patch, count: int, args):
+        """`count` instances, in subgroups if there are more than `fanout`"""
+        host = self.host
+        # the inlets and outlets of a subpatch are ordered by their x position
+        source = patch.add_obj(host.inlet_signal, x=20, y=20) if self.n_signals else None
+        traffic = patch.add_obj("inlet", x=120, y=20)
+        if count <= self.fanout:
+            children = self.instances(patch, count, args)
+        else:
+            size = group_size(count, self.fanout)
+            children = [self.subgroup(patch, i, min(size, count - start), args)
+                        for i, start in enumerate(range(0, count, size))]
+        y = 120 + 40 * math.ceil(len(children) / 10)
+        outputs = [patch.add_obj(host.outlet_signal, x=20 + 120 * c, y=y) for c in range(self.n_signals)]
+        self.wire(patch, children, source, [traffic], outputs, groups=count > self.fanout)
+
+    def patch(self, path):
+        """writes the load patch to `path`"""
+        with self.host.new(path) as patch:
+            self.build(patch)
+
+    def build(self, patch):
+        host, e = self.host, self.model
+        patch.add_text(f"{self.count} x {host.name} ({self.layout})", x=200, y=0)
+        loadbang = patch.add_obj("loadbang", x=20, y=20)
+        host.dsp_on(patch, loadbang)
+        patch.link(loadbang, host.cpu_meter(patch, 700, 20))
+
+        # random values of the settable params (or bangs) every `rate` ms
+        metro = patch.add_obj("metro", self.rate, x=200, y=50)
+        patch.link(loadbang, metro)
+        traffic = []
+        for i, p in enumerate(e.settable_params):
+            rnd, scale = host.value(patch, p, 200 + 130 * i, 80)
+            traffic.append(host.message(patch, p.name, 200 + 130 * i, 140))
+            patch.link(metro, rnd)
+            patch.link(scale, traffic[-1])
+        if not traffic and "bang" in [m.type for m in e.type_methods]:
+            traffic.append(metro)
+
+        source = patch.add_obj("noise~", x=20, y=200) if self.n_signals else None
+        outputs = [host.output(patch, 20 + 120 * c, 700) for c in range(self.n_signals)]
+        if self.layout == "flat":
+            self.wire(patch, self.instances(patch, self.count, self.args, y=250), source, traffic, outputs)
+        elif self.layout == "abstraction":
+            children = [patch.add_obj(self.abstraction(self.count), *self.args, x=20, y=250)]
+            self.wire(patch, children, source, traffic, outputs, groups=True)
+        else:
+            with patch.subpatch("instances", x=20, y=250) as sub:
+                self.group(sub, self.count, self.args)
+            self.wire(patch, [len(patch) - 1], source, traffic, outputs, groups=True)
+
+
+def generate(spec, counts=(10, 100, 1000), layouts=StressPatch.layouts, target_dir=None,
+             fanout=10, rate=10):
+    """writes the load patches of every external of `spec`"""
+    for i in range(len(xtgen.load_spec(spec))):
+        project = xtgen.PdProject(spec, external=i)
+        out = target_dir or project.project_path / "stress"
+        os.makedirs(out, exist_ok=True)
+        for host in (Host(project.model), MaxHost(project.model)):
+            abstractions = Abstractions(out, host.new, host.extension)
+            for layout in layouts:
+                for count in counts:
+                    stress = StressPatch(host, count, layout, fanout, rate, abstractions)
+                    path = os.path.join(out, stress.filename)
+                    stress.patch(path)
+                    print(path, "written")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="generate load patches of externals")
+    parser.add_argument("specs", nargs="+", help="xtgen spec files")
+    parser.add_argument("-n", "--counts", default="10,100,1000",
+                        help="instance counts (10,100,1000)")
+    parser.add_argument("-l", "--layouts", default=",".join(StressPatch.layouts),
+                        help="flat, nested and/or abstraction (all)")
+    parser.add_argument("-f", "--fanout", type=int, default=10,
+                        help="instances (or groups) per group of the nested and abstraction layouts (10)")
+    parser.add_argument("-r", "--rate", type=float, default=10,
+                        help="ms between the messages sent to the instances (10)")
+    parser.add_argument("-o", "--output",
+                        help="directory of the patches (the stress/ directory of each project)")
+    args = parser.parse_args()
+    for spec in args.specs:
+        generate(spec, [int(n) for n in args.counts.split(",")], args.layouts.split(","),
+                 args.output, args.fanout, args.rate)
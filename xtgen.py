@@ -21,6 +21,9 @@ Requires the following python packages:
 >>> xtgen.MaxProject('counter.yml').generate()
 >>> ... (similar as above)
 
+>>> xtgen.HybridProject('counter~.yml').generate()
+>>> # generates a header-only dsp kernel with thin pd and max wrappers
+
 ## Model
 
 external
@@ -76,13 +79,21 @@ externals:
 
 """
 import argparse
+import glob
+import hashlib
 import os
+import re
+import shutil
+import socket
+import subprocess
 import sys
+import time
+from concurrent.futures import ProcessPoolExecutor
+from functools import cached_property
 from pathlib import Path
 from types import SimpleNamespace
 
 import yaml
-from mako.template import Template
 from mako.lookup import TemplateLookup
 
 
@@ -90,12 +101,79 @@ from mako.lookup import TemplateLookup
 # CONSTANTS
 
 TEMPLATE_DIR = os.path.join(os.getcwd(), "resources/templates")
-TEMPLATE_LOOKUP = TemplateLookup(directories=[TEMPLATE_DIR])
+# templates are compiled to python modules once and reused by later runs, in
+# a cache of the user (mako imports them: a shared directory would let other
+# users plant code in the generator)
+MODULE_DIR = os.environ.get("XTGEN_CACHE") or os.path.join(
+    os.environ.get("XDG_CACHE_HOME") or os.path.join(os.path.expanduser("~"), ".cache"), "xtgen")
+TEMPLATE_LOOKUP = TemplateLookup(directories=[TEMPLATE_DIR], module_directory=MODULE_DIR)
 OUTPUT_DIR = "build"
 
+
+def gensym(name: str) -> str:
+    """the C expression of the pd symbol `name`, interned where it is used"""
+    return f'gensym("{name}")'
+
+
+_specs = {}
+
+
+def load_spec(spec_yml) -> list[dict]:
+    """the `externals` of a spec file, parsed once (again when it changes)"""
+    path = Path(spec_yml).resolve()
+    mtime = path.stat().st_mtime_ns
+    if path not in _specs or _specs[path][0] != mtime:
+        with open(path) as f:
+            _specs[path] = (mtime, yaml.safe_load(f.read())["externals"])
+    return _specs[path][1]
+
+
+def digest(data: bytes) -> str:
+    return hashlib.sha256(data).hexdigest()
+
+
+def write_if_changed(target: Path, text: str) -> bool:
+    """write text to target unless it already holds it, so its mtime (and
+    make) only sees outputs which changed. Returns True if it was written."""
+    data = text.encode()
+    if target.exists() and digest(target.read_bytes()) == digest(data):
+        return False
+    target.write_bytes(data)
+    return True
+
+
+def copy_if_changed(target_dir: Path, *sources: str) -> bool:
+    """copy files (or glob patterns) into target_dir, skipping identical ones.
+    Returns True if any was copied."""
+    copied = False
+    for pattern in sources:
+        for src in sorted(glob.glob(pattern)):
+            target = Path(target_dir) / Path(src).name
+            if target.exists() and digest(target.read_bytes()) == digest(Path(src).read_bytes()):
+                continue
+            shutil.copyfile(src, target)
+            copied = True
+    return copied
+
+
+def pd_send(port: int, *messages: str, host: str = "localhost"):
+    """send FUDI messages to the [netreceive <port>] of a running pd"""
+    with socket.create_connection((host, port), timeout=1) as s:
+        s.sendall("".join(f"{m};\n" for m in messages).encode())
+
 # ----------------------------------------------------------------------------
 # UTILITY FUNCTIONS
 
+class SpecError(ValueError):
+    """a spec which cannot be generated"""
+
+
+def check(condition, message: str):
+    """validates the spec: unlike an assert, kept by `python -O`"""
+    if not condition:
+        raise SpecError(message)
+
+
 c_type = lambda s: f"t_{s}"
 lookup_address = lambda s: f"&s_{s}"
 lookup_routine = lambda s: f'gensym("{s}")'
@@ -109,7 +187,7 @@ class AbstractType:
     VALID_TYPES: list[str] = []
 
     def __init__(self, name: str):
-        assert name in self.VALID_TYPES
+        check(name in self.VALID_TYPES, f"unknown type: {name}")
         self.name = name
 
     def __str__(self):
@@ -188,7 +266,7 @@ class TypeMethod(Object):
         super().__init__(parent, **kwargs)
         # self.type = self.ns.type
         self.doc = self.ns.doc if hasattr(self.ns, "doc") else ""
-        assert self.type in self.valid_types
+        check(self.type in self.valid_types, f"unknown type method: {self.type}")
 
     @property
     def name(self) -> str:
@@ -217,9 +295,13 @@ class TypeMethod(Object):
     @property
     def class_addmethod(self) -> str:
         return (
-            f"class_add{self.type}({self.parent.klass}, {self.parent.name}_{self.type})"
+            f"class_add{self.type}({self.parent.klass}, {self.parent.c_name}_{self.type})"
         )
 
+    def addmethod(self, sym=gensym) -> str:
+        """class_add<type>() of the method, which has no selector"""
+        return self.class_addmethod
+
 
 class MessagedMethod(Object):
     def __init__(self, parent, **kwargs):
@@ -244,16 +326,28 @@ class MessagedMethod(Object):
                 type_str = ", ".join(types)
                 return f"{prefix}, {type_str}"
 
+    @property
+    def symbol(self) -> str:
+        return f"ps_{self.name}"
+
+    @property
+    def selector(self) -> str:
+        return f"SEL_{self.name.upper()}"
+
     @property
     def class_addmethod(self) -> str:
+        return self.addmethod()
+
+    def addmethod(self, sym=gensym) -> str:
+        """class_addmethod() of the method, `sym` giving the C expression of its selector"""
         prefix = (
-            f"class_addmethod({self.parent.name}_class, "
-            f"(t_method){self.parent.name}_{self.name}, "
-            f'gensym("{self.name}")'
+            f"class_addmethod({self.parent.klass}, "
+            f"(t_method){self.parent.c_name}_{self.name}, "
+            f"{sym(self.name)}"
         )
 
         if len(self.params) == 0:
-            return f"{prefix}, 0)"
+            return f"{prefix}, A_NULL)"
         else:
             if (self.params == ["list"]) or (len(self.params) > 6):
                 return f"{prefix}, A_GIMME, 0)"
@@ -300,9 +394,46 @@ class Param(Object):
         self.name = self.ns.name
         self.initial = self.ns.initial
         self.type = self.ns.type
+        # 'type: delay': a delay time in ms (a float param) with a delay line of up to max_ms
+        self.is_delay = self.type == "delay"
+        self.max_ms = getattr(self.ns, "max_ms", None)
+        check(not self.is_delay or self.max_ms, f"delay param '{self.name}' needs a max_ms")
+        if self.is_delay:
+            self.type = "float"
+        # 'type: table': the name of an array (pd) or buffer~ (max) read by the perform routine
+        self.is_table = self.type == "table"
         self.is_arg = self.ns.arg
-        self.has_inlet = self.ns.inlet
+        # 'inlet: signal_or_float' gives a dsp param its own signal inlet
+        self.is_signal = self.ns.inlet == "signal_or_float"
+        self.has_inlet = self.ns.inlet is True
         self.desc = self.ns.desc
+        self.min = self.ns.min if hasattr(self.ns, "min") else (0 if self.is_delay else None)
+        self.max = self.ns.max if hasattr(self.ns, "max") else self.max_ms
+        self.is_attr = self.ns.attr if hasattr(self.ns, "attr") else False
+        check(not self.is_attr or self.type == "float", f"attr param '{self.name}' must be a float")  # only float attrs for now
+        # C statements which update derived coefficients after a change
+        self.recompute = self.ns.recompute if hasattr(self.ns, "recompute") else None
+        self.derived = self.ns.derived if hasattr(self.ns, "derived") else []
+        check(not self.derived or self.recompute, f"param '{self.name}' has derived fields but no recompute hook")
+        # ramp time in ms over which a new value is reached in the perform loop
+        self.smooth = self.ns.smooth if hasattr(self.ns, "smooth") else None
+        # fixed at compile time: no setter, inlet or message
+        self.is_const = getattr(self.ns, "const", False)
+        check(not self.is_const or not (
+            self.has_inlet or self.is_signal or self.is_attr or self.smooth
+        ), f"const param '{self.name}' cannot have an inlet, attr or smoothing")
+        # (poly) one value per voice, set by `<name> <voice> <value>` messages
+        self.is_voice = getattr(self.ns, "voice", False)
+        check(not self.is_voice or not (
+            self.is_arg or self.has_inlet or self.is_signal or self.is_attr
+            or self.smooth or self.recompute or self.is_const
+        ), f"voice param '{self.name}' cannot be an arg or have an inlet, attr, smoothing, recompute or const")
+        check(not self.is_voice or self.type in ("float", "sample"), "voice params must be floats")
+        check(not (self.is_voice and self.is_delay), "voice params cannot be delays")
+        check(not self.is_table or not (
+            self.is_arg or self.has_inlet or self.is_signal or self.is_attr
+            or self.smooth or self.recompute or self.is_const or self.is_voice
+        ), f"table param '{self.name}' is set by name: it cannot be an arg or have an inlet, attr, smoothing, recompute or const")
 
     # def as_inlet(self):
     #     return Inlet(self.parent, vars(self.ns))
@@ -315,12 +446,290 @@ class Param(Object):
     def struct_declaration(self) -> str:
         return f"{self.pd_type} {self.name}"
 
+    @property
+    def max_type(self) -> str:
+        """type of the param in max dsp externals, which process doubles"""
+        return {"float": "double", "sample": "double", "int": "t_atom_long"}[self.type]
+
+    @property
+    def max_declaration(self) -> str:
+        return f"{self.max_type} {self.name}"
+
+    @property
+    def max_derived_declarations(self) -> list[str]:
+        types = {"float": "double", "sample": "double", "int": "t_atom_long"}
+        return [f"{types[d['type']]} {d['name']}" for d in self.derived]
+
+    @property
+    def kernel_type(self) -> str:
+        """type of the param in a hybrid kernel templated on sample type T"""
+        return {"float": "T", "sample": "T", "int": "int"}[self.type]
+
+    @property
+    def kernel_declaration(self) -> str:
+        return f"{self.kernel_type} {self.name}"
+
+    @property
+    def kernel_derived_declarations(self) -> list[str]:
+        types = {"float": "T", "sample": "T", "int": "int"}
+        return [f"{types[d['type']]} {d['name']}" for d in self.derived]
+
+    @property
+    def symbol(self) -> str:
+        return f"ps_{self.name}"
+
+    @property
+    def selector(self) -> str:
+        return f"SEL_{self.name.upper()}"
+
+    @property
+    def delay_line(self) -> str:
+        """struct field of the delay line of a delay param"""
+        return f"{self.name}_line"
+
+    @property
+    def max_delay(self) -> str:
+        """C expression of the delay line length in samples (of `x->sr`)"""
+        return f"(uint32_t)ceil({self.max_ms} * x->sr / 1000.)"
+
+    @property
+    def array_name(self) -> str:
+        """C string of the name of the array initially read by a table param"""
+        return '"' + (self.initial or "") + '"'
+
+    @property
+    def event_id(self) -> str:
+        """id of the events which set the param"""
+        return f"EVENT_{self.name.upper()}"
+
+    @property
+    def dirty_flag(self) -> str:
+        return f"DIRTY_{self.name.upper()}"
+
+    @property
+    def ramp_flag(self) -> str:
+        """flag of a new target of a smoothed param (Max setters)"""
+        return f"RAMP_{self.name.upper()}"
+
+    @property
+    def derived_declarations(self) -> list[str]:
+        return [f"{self.c_types[d['type']]} {d['name']}" for d in self.derived]
+
+    def sample_value(self, offset: int = 0, vector: bool = False) -> str:
+        """returns a C expression of the param's value at frame `i + offset`
+
+        the perform routines provide {name}_0 (and {name}_step if smoothed),
+        and {name}_in for signal params in the vector variant.
+        """
+        i = f"i + {offset}" if offset else "i"
+        if self.smooth:
+            value = f"{self.name}_0 + {self.name}_step * (i + {offset + 1})"
+        else:
+            value = f"{self.name}_0"
+        if vector and self.is_signal:
+            value = f"{self.name}_in ? {self.name}_in[{i}] : {value}"
+        return value
+
+    def clamp(self, expr: str) -> str:
+        """returns a C expression clamping `expr` to the param's range"""
+        if self.min is not None and self.max is not None:
+            return f"({expr} < {self.min}) ? {self.min} : ({expr} > {self.max}) ? {self.max} : {expr}"
+        elif self.min is not None:
+            return f"({expr} < {self.min}) ? {self.min} : {expr}"
+        elif self.max is not None:
+            return f"({expr} > {self.max}) ? {self.max} : {expr}"
+        return expr
+
 
 class Outlet(Object):
+    """an outlet, which a dsp external may also feed from its perform routine
+
+    A `from_dsp` outlet is sent the values the perform routine reports with
+    `_report_<name>()` by a clock of the object, at most once every `rate`
+    ms: reports in between replace the values still waiting to be sent.
+    """
+
     def __init__(self, parent, **kwargs):
         super().__init__(parent, **kwargs)
         self.name = self.ns.name
         self.type = self.ns.type
+        self.from_dsp = getattr(self.ns, "from_dsp", False)
+        self.rate = getattr(self.ns, "rate", 20)
+        self.size = getattr(self.ns, "size", 1)
+        if self.from_dsp:
+            check(parent.is_dsp, "from_dsp outlets require a dsp external")
+            check(self.type in ("float", "list"), "from_dsp outlets send a float or a list")
+            check(self.rate > 0, "the rate of a from_dsp outlet is a positive number of ms")
+            check(self.size >= 1 and (self.type == "list" or self.size == 1),
+                "a float outlet has a size of 1")
+
+
+class Kernel(Object):
+    """a dsp kernel object placed inside the external's struct
+
+    The kernel is constructed in an aligned slot of the object itself (by
+    placement-new in max, as plain storage in pd) rather than allocated per
+    instance, and `init` is run by the dsp method only when the sample rate
+    or the vector size has changed.
+    """
+
+    def __init__(self, parent, **kwargs):
+        super().__init__(parent, **kwargs)
+        self.name = self.ns.name if hasattr(self.ns, "name") else "kernel"
+        self.type = self.ns.type
+        self.header = self.ns.header if hasattr(self.ns, "header") else None
+        self.init = self.ns.init if hasattr(self.ns, "init") else None
+        self.free = self.ns.free if hasattr(self.ns, "free") else None
+        self.hosts = self.ns.hosts if hasattr(self.ns, "hosts") else ["pd", "max"]
+        self.align = self.ns.align if hasattr(self.ns, "align") else 64
+        check(self.align & (self.align - 1) == 0, "kernel alignment must be a power of two")
+
+    @property
+    def storage(self) -> str:
+        """name of the (over-sized) storage the kernel is constructed in"""
+        return f"{self.name}_storage"
+
+
+class Buffer(Object):
+    """a sample buffer sized by a C expression of `x->sr` and `x->vs`"""
+
+    def __init__(self, parent, **kwargs):
+        super().__init__(parent, **kwargs)
+        self.name = self.ns.name
+        self.size = self.ns.size
+
+
+class Table(Object):
+    """a lookup table shared by all instances of the class
+
+    The table (one period of `size` points, a power of two, framed by
+    guard points) is created and filled when the first instance is created
+    and freed with the last one, so the perform routines of all instances
+    read the same cache-resident copy instead of computing transcendentals.
+    Its source is "sine", "saw" (bandlimited to `harmonics` partials),
+    "expr" (a C expression of the phase `p` in [0, 1)) or "file" (numbers
+    separated by whitespace, read when the external is generated).
+    """
+
+    sources = ("sine", "saw", "expr", "file")
+
+    def __init__(self, parent, **kwargs):
+        super().__init__(parent, **kwargs)
+        self.name = self.ns.name
+        self.source = getattr(self.ns, "source", "sine")
+        check(self.source in self.sources, f"unknown table source: {self.source}")
+        self.expr = getattr(self.ns, "expr", None)
+        check(self.source != "expr" or self.expr, f"table '{self.name}' needs an expr")
+        self.file = getattr(self.ns, "file", None)
+        check(self.source != "file" or self.file, f"table '{self.name}' needs a file")
+        self.points = self.load() if self.source == "file" else None
+        self.size = len(self.points) if self.points else getattr(self.ns, "size", 2048)
+        check(self.size >= 2 and self.size & (self.size - 1) == 0,
+            f"table '{self.name}' must have a power-of-two size")
+        self.harmonics = getattr(self.ns, "harmonics", self.size // 4)
+        self.desc = getattr(self.ns, "desc", "")
+
+    def load(self) -> list[str]:
+        """the points of a file table, as C literals"""
+        with open(self.file) as f:
+            return [repr(float(v)) for v in f.read().split()]
+
+    @property
+    def key(self) -> tuple:
+        """what the points of the table depend on: tables with the same key are the same"""
+        if self.source == "saw":
+            return (self.source, self.size, self.harmonics)
+        if self.source == "expr":
+            return (self.source, self.size, self.expr)
+        if self.source == "file":
+            return (self.source, tuple(self.points))
+        return (self.source, self.size)
+
+
+class ChannelState(Object):
+    """a per-channel (multichannel) or per-voice (poly) state variable
+
+    Each state variable is one array indexed by channel or voice (structure
+    of arrays), resized by the dsp method when the channel count changes,
+    or of fixed size for the voices of a poly external.
+    """
+
+    def __init__(self, parent, **kwargs):
+        super().__init__(parent, **kwargs)
+        self.name = self.ns.name
+        self.initial = self.ns.initial if hasattr(self.ns, "initial") else 0
+        self.desc = self.ns.desc if hasattr(self.ns, "desc") else ""
+
+
+class Spectral(Object):
+    """the short-time fourier transform of a spectral external
+
+    Frames of `size` samples (a power of two) are taken every
+    `size / overlap` samples, windowed, transformed and handed to the
+    external as spectra, then transformed back and overlap-added, with a
+    latency of `size` samples whatever the block size. The fft plan, the
+    window table and the (aligned) buffers are created once by the dsp
+    method, never in the perform routine. Each window needs a minimum
+    overlap for its overlapped squares to add up evenly.
+    """
+
+    windows = {"rect": 1, "sine": 2, "hann": 4, "hamming": 4, "blackman": 8}
+
+    def __init__(self, parent, **kwargs):
+        super().__init__(parent, **kwargs)
+        self.size = getattr(self.ns, "size", 1024)
+        check(self.size >= 16 and self.size & (self.size - 1) == 0,
+            "the spectral size must be a power of two >= 16")
+        self.window = getattr(self.ns, "window", "hann")
+        check(self.window in self.windows, f"unknown window: {self.window}")
+        self.overlap = getattr(self.ns, "overlap", self.windows[self.window])
+        check(self.overlap & (self.overlap - 1) == 0 and self.overlap <= self.size,
+            "the spectral overlap must be a power of two")
+        check(self.overlap >= self.windows[self.window],
+            f"the {self.window} window needs an overlap of at least {self.windows[self.window]}")
+        self.hop = self.size // self.overlap
+
+    @property
+    def name(self) -> str:
+        return self.window
+
+    @property
+    def window_id(self) -> str:
+        return f"XT_WINDOW_{self.window.upper()}"
+
+
+class Build(Object):
+    """the build profiles of the generated pd Makefile
+
+    `profile` is the default of `make PROFILE=release|debug`. Release
+    builds are -O3 with link-time optimization (unless `lto: false`), tuned
+    for the build machine (`make MARCH=<cpu>`, empty for portable builds),
+    and `fast_math: true` opts externals whose dsp tolerates reassociation
+    and no inf/nan into -ffast-math. Debug builds are -O0 -g.
+    """
+
+    profiles = ("release", "debug")
+
+    def __init__(self, parent, **kwargs):
+        super().__init__(parent, **kwargs)
+        self.profile = getattr(self.ns, "profile", "release")
+        check(self.profile in self.profiles, f"unknown build profile: {self.profile}")
+        self.fast_math = getattr(self.ns, "fast_math", False)
+        self.lto = getattr(self.ns, "lto", True)
+
+    @property
+    def name(self) -> str:
+        return self.profile
+
+    @property
+    def release_flags(self) -> str:
+        """compiler flags of the release profile, but the -march of MARCH"""
+        flags = ["-O3", "-funroll-loops", "-fomit-frame-pointer"]
+        if self.lto:
+            flags.append("-flto")
+        if self.fast_math:
+            flags.append("-ffast-math")
+        return " ".join(flags)
 
 
 class External(Object):
@@ -336,46 +745,288 @@ class External(Object):
         "anything": "t_symbol *s, int argc, t_atom *argv",
     }
 
-    def __init__(self, **kwargs):
+    def __init__(self, is_dsp=False, **kwargs):
         self.ns = SimpleNamespace(**kwargs)
+        self.check_keys()
         # self.name = self.ns.name
-        self.type = f"t_{self.name}"
-        self.klass = f"{self.name}_class"
+        self.is_dsp = is_dsp
+        self.c_name = f"{self.name}_tilde" if is_dsp else self.name
+        self.type = f"t_{self.c_name}"
+        self.klass = f"{self.c_name}_class"
         # self.meta = self.ns.meta
         # self.help = self.ns.help
         self.alias = self.ns.alias if hasattr(self.ns, "alias") else None
         # self.namespace = self.ns.namespace
-        # self.n_channels = self.ns.n_channels
+        self.n_channels = self.ns.n_channels if hasattr(self.ns, "n_channels") else 1
+        # max: how params are handed from the main/scheduler thread to the perform routine
+        self.handoff = self.ns.handoff if hasattr(self.ns, "handoff") else None
+        check(self.handoff in (None, "seqlock"), f"unknown handoff: {self.handoff}")
+        # one multichannel inlet and outlet (pd 0.54 / max mc), channels known at dsp time
+        self.multichannel = self.ns.multichannel if hasattr(self.ns, "multichannel") else False
+        check(not self.multichannel or is_dsp, "multichannel externals must be dsp externals")
+        # fixed pool of voices allocated by `note`/`voice` messages and mixed onto the outputs
+        self.poly = self.ns.poly if hasattr(self.ns, "poly") else 0
+        check(not self.poly or is_dsp, "poly externals must be dsp externals")
+        check(not (self.poly and self.multichannel), "poly externals cannot be multichannel")
+        check(not (self.poly and self.handoff), "voice messages do not go through the param handoff")
+        check(self.multichannel or self.poly or not hasattr(self.ns, "state"),
+            "per-channel state requires multichannel (or per-voice state poly)")
+        # denormal protection of the perform routines: 'ftz' (flush-to-zero mode
+        # set and restored around them) and/or 'dc' (tiny offset added to the inputs)
+        denormals = getattr(self.ns, "denormals", [])
+        denormals = [denormals] if isinstance(denormals, str) else denormals
+        check(set(denormals) <= {"ftz", "dc"}, f"unknown denormals mode: {denormals}")
+        check(not denormals or is_dsp, "denormal protection requires a dsp external")
+        self.denormal_ftz = "ftz" in denormals
+        self.denormal_dc = "dc" in denormals
+        # queue of timestamped param changes applied at their sample within a block
+        events = getattr(self.ns, "events", 0)
+        self.events = 64 if events is True else int(events)
+        check(not self.events or is_dsp, "events require a dsp external")
+        check(self.events == 0 or self.events >= 2 and self.events & (self.events - 1) == 0,
+            "the event queue size must be a power of two")
+        check(not (self.events and (self.multichannel or self.poly)),
+            "events are not supported by multichannel or poly externals yet")
+        check(not (self.events and self.handoff), "events are queued instead of handed off")
+        # (pd) run the perform routine on a worker thread, one block behind the dsp thread
+        self.threaded = getattr(self.ns, "threaded", False)
+        check(not self.threaded or is_dsp, "threaded externals must be dsp externals")
+        check(not (self.threaded and (self.multichannel or self.poly or self.events)),
+            "threaded externals cannot be multichannel, poly or have events yet")
+        # short-time fourier transform: frames handed to the external as spectra
+        self.spectral = Spectral(self, **self.ns.spectral) if hasattr(self.ns, "spectral") else None
+        self.build = Build(self, **getattr(self.ns, "build", {}))
+        check(not self.spectral or is_dsp, "spectral externals must be dsp externals")
+        check(not (self.spectral and (self.multichannel or self.poly or self.events)),
+            "spectral externals cannot be multichannel, poly or have events")
+        check(not (self.spectral and self.denormal_dc), "spectral externals copy their inputs unbiased")
         # self.prefix = self.ns.prefix
+        self.validate()
+        self._frozen = True
 
     def __repr__(self):
         return f"<{self.__class__.__name__}: '{self.name}'>"
 
-    @property
+    def __setattr__(self, attr, value):
+        assert not self.__dict__.get("_frozen"), f"the model of {self.name} is frozen ({attr})"
+        super().__setattr__(attr, value)
+
+    def check_keys(self):
+        """check the keys of the spec and of its params, before any field
+        is read from them"""
+        name = self.ns.__dict__.get("name", "?")
+        for key in ("name", "namespace", "prefix", "params", "outlets",
+                    "type_methods", "message_methods", "meta", "help"):
+            check(hasattr(self.ns, key), f"{name}: missing '{key}'")
+        for p in self.ns.params:
+            missing = {"name", "type", "initial", "arg", "inlet", "desc"} - set(p)
+            check(not missing, f"{name}: param '{p.get('name')}' misses {sorted(missing)}")
+            check(p["type"] in (*Param.c_types, "delay", "table"),
+                f"param '{p['name']}' has an unknown type: {p['type']}")
+
+    def validate(self):
+        """resolve the whole spec once, so that inconsistencies fail here
+        rather than halfway through a template; the derived fields are
+        cached and the model is frozen afterwards."""
+        names = [p.name for p in self.params + self.table_params]
+        check(len(names) == len(set(names)), f"{self.name}: duplicate param names")
+        names = [o.name for o in self.outlets]
+        check(len(names) == len(set(names)), f"{self.name}: duplicate outlet names")
+        names = [m.name for m in self.message_methods]
+        check(len(names) == len(set(names)), f"{self.name}: duplicate message methods")
+        types = [m.type for m in self.type_methods]
+        check(len(types) == len(set(types)), f"{self.name}: duplicate type methods")
+        # creation args are A_DEFFLOAT or A_DEFSYMBOL (or all of them A_GIMME)
+        for p in self.args:
+            check(p.type in ("float", "symbol") or len(self.args) > 6,
+                f"arg '{p.name}' must be a float or a symbol param")
+            check(not p.is_const, f"const param '{p.name}' cannot be set by an arg")
+        for m in self.message_methods:
+            check(m.params == ["list"] or len(m.params) > 6 or
+                set(m.params) <= set(self.mapping),
+                f"method '{m.name}': params are float, symbol, anything or a single list")
+        check(not (self.spectral and any(p.smooth or p.is_signal for p in self.params)),
+            "spectral externals read their params once per frame: no smooth or signal params")
+        # the checks of the derived fields
+        self.table_set, self.voice_params, self.dsp_outlets, self.delay_params
+        self.tables, self.recomputed_params, self.event_params, self.buffers, self.state
+        self._kernel, self.class_new_args, self.class_type_signature
+
+    @cached_property
     def params(self) -> list[Param]:
-        return [Param(self, **p) for p in self.ns.params]
-
-    @property
+        """all params but table params, which hold the name of an array rather than a value"""
+        return [Param(self, **p) for p in self.ns.params if p["type"] != "table"]
+
+    @cached_property
+    def table_params(self) -> list[Param]:
+        """params naming an array (pd) or buffer~ (max) read by the perform routine
+
+        The array is looked up by name by the dsp method and by the
+        `<param> <name>` message (or `set <name>` for the first table
+        param), never in the perform routine, which reads the cached
+        samples (pd) or locks the buffer~ once per call (max).
+        """
+        params = [Param(self, **p) for p in self.ns.params if p["type"] == "table"]
+        check(not params or self.is_dsp, "table params require a dsp external")
+        check(not (params and (self.multichannel or self.poly or self.spectral or self.threaded)),
+            "table params are not supported by multichannel, poly, spectral or threaded externals yet")
+        return params
+
+    @cached_property
+    def table_set(self):
+        """the table param set by the `set` message, unless a message method is named set"""
+        params = self.table_params
+        if not params or "set" in [m.name for m in self.message_methods]:
+            return None
+        return params[0]
+
+    @cached_property
+    def object_params(self):
+        """params with a single value per object (all but `voice` params)"""
+        return [p for p in self.params if not p.is_voice]
+
+    @cached_property
+    def voice_params(self):
+        """(poly) params with one value per voice"""
+        params = [p for p in self.params if p.is_voice]
+        check(not params or self.poly, "voice params require poly")
+        check(not {p.name for p in params} & {"note", "velocity", "gate", "voice"},
+            "note, velocity, gate and voice are reserved in poly externals")
+        return params
+
+    @cached_property
+    def variable_params(self):
+        """params which can be changed at runtime (not `const`), one value per object"""
+        return [p for p in self.object_params if not p.is_const]
+
+    @cached_property
+    def const_params(self):
+        """params fixed at compile time (constexpr in hybrid kernels)"""
+        return [p for p in self.params if p.is_const]
+
+    @cached_property
     def args(self):
         return [p for p in self.params if p.is_arg]
 
-    @property
+    @cached_property
     def inlets(self):
         return [p for p in self.params if p.has_inlet]
 
-    @property
+    @cached_property
     def outlets(self):
         return [Outlet(self, **o) for o in self.ns.outlets]
 
-    @property
+    @cached_property
+    def dsp_outlets(self):
+        """outlets fed by the perform routine through the report ring and clock"""
+        outlets = [o for o in self.outlets if o.from_dsp]
+        check(not (outlets and self.threaded), "threaded externals cannot have from_dsp outlets yet")
+        return outlets
+
+    @cached_property
+    def report_size(self):
+        """values of the largest report of the from_dsp outlets"""
+        return max(o.size for o in self.dsp_outlets)
+
+    @cached_property
+    def _kernel(self):
+        return Kernel(self, **self.ns.kernel) if hasattr(self.ns, "kernel") else None
+
+    def kernel(self, host: str):
+        """the dsp kernel of the external if it is available for `host`"""
+        kernel = self._kernel
+        return kernel if kernel and host in kernel.hosts else None
+
+    @cached_property
+    def buffers(self):
+        """buffers reallocated by the dsp method when sr or vector size change"""
+        return [Buffer(self, **b) for b in self.ns.buffers] if hasattr(self.ns, "buffers") else []
+
+    @cached_property
+    def delay_params(self):
+        """params with a delay line, reallocated by the dsp method when sr changes"""
+        params = [p for p in self.params if p.is_delay]
+        check(not params or self.is_dsp, "delay params require a dsp external")
+        return params
+
+    @cached_property
+    def tables(self):
+        """lookup tables shared by all instances"""
+        tables = [Table(self, **t) for t in self.ns.tables] if hasattr(self.ns, "tables") else []
+        check(not tables or self.is_dsp, "tables require a dsp external")
+        return tables
+
+    @cached_property
+    def state(self):
+        """per-channel state of a multichannel external, or per-voice state of a poly one"""
+        return [ChannelState(self, **c) for c in self.ns.state] if hasattr(self.ns, "state") else []
+
+    @cached_property
     def type_methods(self):
         return [TypeMethod(self, **m) for m in self.ns.type_methods]
 
-    @property
+    @cached_property
     def message_methods(self):
         return [MessagedMethod(self, **m) for m in self.ns.message_methods]
 
-    @property
+    @cached_property
+    def attrs(self):
+        return [p for p in self.params if p.is_attr]
+
+    @cached_property
+    def recomputed_params(self):
+        """params with a recompute hook, each owning a bit of the dirty mask"""
+        params = [p for p in self.params if p.recompute]
+        check(len(params) <= 32, "at most 32 params can have a recompute hook")
+        return params
+
+    @cached_property
+    def smoothed_params(self):
+        """params which are linearly ramped to new values in the perform loop,
+        each owning a bit of the retarget mask of Max"""
+        params = [p for p in self.params if p.smooth]
+        check(len(params) <= 32, "at most 32 params can be smoothed")
+        return params
+
+    @cached_property
+    def signal_params(self):
+        """params with a signal inlet which may also receive floats"""
+        return [p for p in self.params if p.is_signal]
+
+    @cached_property
+    def frame_params(self):
+        """params whose value is provided per sample in the perform loop"""
+        return [p for p in self.params if p.smooth or p.is_signal]
+
+    @cached_property
+    def settable_params(self):
+        """params set by name (a message method shadows a param)"""
+        names = [m.name for m in self.message_methods]
+        return [p for p in self.variable_params if p.name not in names]
+
+    @cached_property
+    def event_params(self):
+        """settable params whose changes are queued as timestamped events"""
+        params = self.settable_params if self.events else []
+        check(params or not self.events, "events require settable params")
+        return params
+
+    @cached_property
+    def dispatch_params(self):
+        """settable params which are not handled as max attributes"""
+        return [p for p in self.settable_params if not p.is_attr]
+
+    @cached_property
+    def selector_table_size(self) -> int:
+        """power-of-two size of the open-addressed selector table (<= 50% full)"""
+        n_selectors = len(self.message_methods) + len(self.dispatch_params) + len(self.voice_params)
+        n_selectors += len(self.table_params) + (1 if self.table_set else 0)
+        size = 4
+        while size < 2 * n_selectors:
+            size *= 2
+        return size
+
+    @cached_property
     def class_new_args(self):
         if len(self.args) == 0:
             return "void"
@@ -390,7 +1041,7 @@ class External(Object):
         else:
             raise Exception("cannot populate class_new_args")
 
-    @property
+    @cached_property
     def class_type_signature(self):
         suffix = ", 0"
         if len(self.args) == 0:
@@ -401,11 +1052,14 @@ class External(Object):
         else:
             return "A_GIMME" + suffix
 
-    @property
+    @cached_property
     def class_addcreator(self):
+        return self.addcreator()
+
+    def addcreator(self, sym=gensym):
         return (
             f"class_addcreator((t_newmethod)"
-            f'{self.name}_new, gensym("{self.alias}"), '
+            f"{self.c_name}_new, {sym(self.alias)}, "
             f"{self.class_type_signature})"
         )
 
@@ -414,37 +1068,59 @@ class External(Object):
 # MAIN CLASS
 
 class Generator:
-    """main base class to manage external projects and related files."""
+    """main base class to manage external projects and related files.
 
-    def __init__(self, spec_yml, target_dir=OUTPUT_DIR):
+    `external` is the index of the external in the `externals` of the spec,
+    or its already parsed entry, which comes with `n_externals`, the number
+    of externals of the spec, so that the spec file is not read at all.
+    A spec of a single external names it after the file (`<name>~.yml` for
+    a dsp external), the externals of a spec of several are named after
+    their `name`, and `dsp: true` makes one a dsp external.
+    """
+
+    def __init__(self, spec_yml, target_dir=OUTPUT_DIR, external=0, n_externals=None):
         self.spec_yml = Path(spec_yml)
-        self.fullname = Path(spec_yml).stem
+        if isinstance(external, int):
+            externals = load_spec(spec_yml)
+            ext_yml, n_externals = externals[external], len(externals)
+        else:
+            assert n_externals, "a parsed entry comes with the number of externals of its spec"
+            ext_yml = external
+        stem = self.spec_yml.stem
+        self.is_dsp = ext_yml.get("dsp", stem.endswith("~"))
+        if n_externals == 1:
+            self.fullname = stem
+        else:
+            check("name" in ext_yml, f"{stem}: an external misses 'name'")
+            self.fullname = ext_yml["name"] + ("~" if self.is_dsp else "")
         self.name = self.fullname.strip("~")
-        self.is_dsp = self.fullname.endswith("~")
         self.target_dir = Path(target_dir)
         self.project_path = self.target_dir / self.fullname
-        self.model = None
+        self.model = External(is_dsp=self.is_dsp, **ext_yml)
+        self.changed = False        # whether generate() wrote any file
 
     def cmd(self, shell, *args, **kwds):
         os.system(shell.format(*args, **kwds))
 
+    def copy(self, *sources, to=None):
+        """copy support files into the project (or `to`) unless they are there already"""
+        self.changed |= copy_if_changed(to or self.project_path, *sources)
+
     def generate(self):
         """override this"""
 
-    def render(self, template, outfile=None):
-        with open(self.spec_yml) as f:
-            yml = yaml.safe_load(f.read())
-            ext_yml = yml["externals"][0]
-
-        templ = Template(filename=os.path.join(TEMPLATE_DIR, template))
-        self.model = external = External(**ext_yml)
-        rendered = str(templ.render(e=external))
+    def render(self, template, outfile=None, **context):
+        """render a template of the external, `lib` and `sym` in context are
+        the library it is built into (None) and the C expression of a symbol"""
+        templ = TEMPLATE_LOOKUP.get_template(template)
+        context = {"lib": None, "sym": gensym, **context}
+        rendered = str(templ.render(e=self.model, **context))
         if not outfile:
             outfile = self.fullname + ".c"
         target = self.project_path / outfile
-        with open(target, "w") as f:
-            f.write(rendered)
-        print(target, "rendered")
+        written = write_if_changed(target, rendered)
+        self.changed |= written
+        print(target, "rendered" if written else "unchanged")
 
 
 class MaxProject(Generator):
@@ -452,18 +1128,40 @@ class MaxProject(Generator):
 
     def generate(self):
         try:
-            Path(OUTPUT_DIR).mkdir(exist_ok=True)
+            self.target_dir.mkdir(parents=True, exist_ok=True)
             self.project_path.mkdir(exist_ok=True)
         except OSError:
             print(f"{self.project_path} already exists")
             return
 
         if self.is_dsp:
+            self.copy("resources/headers/xtgen_profile.h")
             self.render("mx/dsp-external.cpp.mako")
+            if self.model.delay_params:
+                self.copy("resources/headers/xtgen_ring.h")
+            if self.model.tables:
+                self.copy("resources/headers/xtgen_table.h")
+            if self.model.denormal_ftz:
+                self.copy("resources/headers/xtgen_denormal.h")
+            if self.model.events:
+                self.copy("resources/headers/xtgen_event.h", "resources/headers/xtgen_ring.h")
+            if self.model.spectral:
+                self.copy("resources/headers/xtgen_fft.h")
+            if self.model.dsp_outlets:
+                self.copy("resources/headers/xtgen_ring.h")
         else:
             self.render("mx/external.cpp.mako")
         # self.render("mx/Makefile.mako", "Makefile")
         self.render("mx/README.md.mako", "README.md")
+        if self.is_dsp:
+            self.generate_bench()
+
+    def generate_bench(self):
+        """standalone benchmark of the perform routines against max api stubs"""
+        bench = self.project_path / "bench"
+        bench.mkdir(exist_ok=True)
+        self.copy("resources/bench/xtbench.h", "resources/bench/max/*", to=bench)
+        self.render("mx/bench-Makefile.mako", "bench/Makefile")
 
 
 class PdProject(Generator):
@@ -471,25 +1169,300 @@ class PdProject(Generator):
 
     def generate(self):
         try:
-            Path(OUTPUT_DIR).mkdir(exist_ok=True)
+            self.target_dir.mkdir(parents=True, exist_ok=True)
             self.project_path.mkdir(exist_ok=True)
         except OSError:
             print(f"{self.project_path} already exists")
             return
 
-        self.cmd(f"cp -rf resources/pd/Makefile.pdlibbuilder {self.project_path}")
+        self.copy("resources/pd/Makefile.pdlibbuilder")
         if self.is_dsp:
             self.render("pd/dsp-external.c.mako")
         else:
             self.render("pd/external.c.mako")
+        self.copy_headers()
         self.render("pd/Makefile.mako", "Makefile")
         self.render("pd/README.md.mako", "README.md")
+        if self.is_dsp:
+            self.generate_bench()
+
+    def copy_headers(self):
+        """copy the support headers the rendered external includes"""
+        if not self.is_dsp:
+            return
+        self.copy("resources/headers/xtgen_profile.h")
+        if self.model.delay_params:
+            self.copy("resources/headers/xtgen_ring.h")
+        if self.model.tables:
+            self.copy("resources/headers/xtgen_table.h")
+        if self.model.denormal_ftz:
+            self.copy("resources/headers/xtgen_denormal.h")
+        if self.model.events:
+            self.copy("resources/headers/xtgen_event.h", "resources/headers/xtgen_ring.h")
+        if self.model.spectral:
+            self.copy("resources/headers/xtgen_fft.h")
+        if self.model.dsp_outlets:
+            self.copy("resources/headers/xtgen_ring.h")
+        if self.model.threaded:
+            self.copy("resources/headers/xtgen_thread.h", "resources/headers/xtgen_ring.h")
+
+    def generate_bench(self):
+        """standalone benchmark of the perform routines against pd api stubs"""
+        bench = self.project_path / "bench"
+        bench.mkdir(exist_ok=True)
+        self.copy("resources/pd/m_pd.h", "resources/bench/xtbench.h", "resources/bench/pd/*", to=bench)
+        self.render("pd/bench-Makefile.mako", "bench/Makefile")
+
+
+class PdLibrary:
+    """several pd externals built into a single library binary
+
+    Each spec is rendered as by PdProject into the library's project, and
+    `<name>_setup()` registers all of the classes, so that pd loads the
+    whole library with one dlopen (`-lib <name>` or [declare -lib <name>]).
+    The selectors and names of all classes are interned once by the setup
+    into symbols the classes share, and lookup tables with the same points
+    are shared by all classes, filled by the first instance reading them.
+    """
+
+    def __init__(self, name, specs, target_dir=OUTPUT_DIR):
+        self.name = name
+        self.target_dir = Path(target_dir)
+        self.project_path = self.target_dir / name
+        self.projects = [PdProject(spec, target_dir, i)
+                         for spec in specs for i in range(len(load_spec(spec)))]
+        check(name not in [p.fullname for p in self.projects],
+            f"the library {name} cannot have a class of the same name")
+        self.symbols = {}           # pd symbol -> its C variable
+        self.shared_tables = {}     # Table.key -> (C name, table)
+
+    def cmd(self, shell, *args, **kwds):
+        os.system(shell.format(*args, **kwds))
+
+    def copy(self, *sources):
+        copy_if_changed(self.project_path, *sources)
+
+    @property
+    def guard(self) -> str:
+        return re.sub(r"\W", "_", self.name).upper() + "_H"
+
+    @property
+    def externals(self) -> list[External]:
+        return [p.model for p in self.projects]
+
+    @property
+    def sources(self) -> list[str]:
+        return [f"{p.fullname}.c" for p in self.projects]
+
+    @property
+    def build(self) -> Build:
+        """the build of the library: fast math and lto only if all classes allow them"""
+        builds = [e.build for e in self.externals]
+        return Build(None, profile=builds[0].profile,
+                     fast_math=all(b.fast_math for b in builds), lto=all(b.lto for b in builds))
+
+    @property
+    def tables(self) -> list[tuple]:
+        """(C name, table) of the distinct lookup tables of all classes"""
+        return list(self.shared_tables.values())
+
+    def sym(self, name: str) -> str:
+        """the C variable of the shared symbol `name`, interned by the setup"""
+        if name not in self.symbols:
+            var = f"{self.name}_s_" + (re.sub(r"\W", "_", name.replace("~", "_tilde")) or "empty")
+            while var in self.symbols.values():
+                var += "_"
+            self.symbols[name] = var
+        return self.symbols[name]
+
+    def table(self, table: Table) -> str:
+        """the C name of the shared lookup table with the points of `table`"""
+        if table.key not in self.shared_tables:
+            self.shared_tables[table.key] = (f"{self.name}_table{len(self.shared_tables)}", table)
+        return self.shared_tables[table.key][0]
+
+    def render(self, template, outfile):
+        templ = TEMPLATE_LOOKUP.get_template(template)
+        target = self.project_path / outfile
+        rendered = str(templ.render(lib=self))
+        print(target, "rendered" if write_if_changed(target, rendered) else "unchanged")
+
+    def generate(self):
+        try:
+            self.target_dir.mkdir(parents=True, exist_ok=True)
+            self.project_path.mkdir(exist_ok=True)
+        except OSError:
+            print(f"{self.project_path} already exists")
+            return
+
+        self.copy("resources/pd/Makefile.pdlibbuilder")
+        # the classes first: rendering them collects the symbols and tables of the setup
+        for p in self.projects:
+            p.project_path = self.project_path
+            template = "pd/dsp-external.c.mako" if p.is_dsp else "pd/external.c.mako"
+            p.render(template, lib=self, sym=self.sym)
+            p.copy_headers()
+        self.render("pd/library.h.mako", f"{self.name}.h")
+        self.render("pd/library.c.mako", f"{self.name}.c")
+        self.render("pd/library-Makefile.mako", "Makefile")
+
+
+class HybridProject(Generator):
+    """dsp project with one header-only kernel shared by pd and max wrappers.
+
+    The kernel is a class templated on the sample type (t_sample in pd,
+    double in max) which owns the params and the process loop, so the
+    wrappers only translate messages and signal vectors and the compiler
+    still sees (and inlines) the whole loop in each host.
+    """
+
+    def __init__(self, *args, **kwds):
+        super().__init__(*args, **kwds)
+        self.check_supported()
+
+    def check_supported(self):
+        """rejects the features of the spec which the hybrid kernel lacks"""
+        e, name = self.model, self.fullname
+        check(not e.multichannel, f"{name}: hybrid kernels do not support multichannel externals yet")
+        check(not e.poly, f"{name}: hybrid kernels do not support poly externals yet")
+        check(not e.delay_params, f"{name}: hybrid kernels do not support delay params yet")
+        check(not e.tables, f"{name}: hybrid kernels do not support tables yet")
+        check(not e.denormal_dc, f"{name}: hybrid kernels do not support denormals: dc yet (ftz is supported)")
+        check(not e.events, f"{name}: hybrid kernels do not support events yet")
+        check(not e.spectral, f"{name}: hybrid kernels do not support spectral externals yet")
+        check(not e.table_params, f"{name}: hybrid kernels do not support table params yet")
+        check(not e.dsp_outlets, f"{name}: hybrid kernels do not support from_dsp outlets yet")
+
+    def generate(self):
+        if not self.is_dsp:
+            print(f"{self.fullname}: hybrid projects are dsp externals only")
+            return
+        try:
+            self.target_dir.mkdir(parents=True, exist_ok=True)
+            self.project_path.mkdir(exist_ok=True)
+            (self.project_path / "pd").mkdir(exist_ok=True)
+            (self.project_path / "max").mkdir(exist_ok=True)
+        except OSError:
+            print(f"{self.project_path} already exists")
+            return
+
+        self.render("hybrid/kernel.hpp.mako", f"{self.name}_kernel.hpp")
+        self.copy("resources/headers/xtgen_profile.h")
+        if self.model.denormal_ftz:
+            self.copy("resources/headers/xtgen_denormal.h")
+        self.copy("resources/pd/Makefile.pdlibbuilder", to=self.project_path / 'pd')
+        self.render("hybrid/pd-external.cpp.mako", f"pd/{self.fullname}.cpp")
+        self.render("hybrid/Makefile.mako", "pd/Makefile")
+        self.render("hybrid/mx-external.cpp.mako", f"max/{self.fullname}.cpp")
+        self.render("pd/README.md.mako", "README.md")
+
+
+PROJECTS = {"pd": PdProject, "max": MaxProject, "hybrid": HybridProject}
+
+
+def _generate(project, spec_yml, target_dir, external, n_externals):
+    project(spec_yml, target_dir, external, n_externals).generate()
+
+
+def generate_all(specs, project=PdProject, target_dir=OUTPUT_DIR, jobs=None):
+    """generate every external of every spec, in `jobs` processes at once
+
+    Each spec is parsed once here and the workers get its parsed entries
+    with their count, so that they never read the spec file again. The
+    compiled templates are shared through the module directory, and
+    outputs whose content did not change are left untouched.
+    """
+    work = []
+    for spec in specs:
+        externals = load_spec(spec)
+        work += [(project, spec, target_dir, ext, len(externals)) for ext in externals]
+    if jobs == 1 or len(work) < 2:
+        for args in work:
+            _generate(*args)
+        return
+    with ProcessPoolExecutor(max_workers=jobs) as pool:
+        for future in [pool.submit(_generate, *args) for args in work]:
+            future.result()
+
+
+def watch(directory, project=PdProject, target_dir=OUTPUT_DIR, make=False,
+          reload_port=None, interval=0.2):
+    """regenerate the externals of the specs in `directory` as they change
+
+    A persistent process keeps the parsed specs and compiled templates in
+    memory (mako reloads a template whose file changed), so an edit only
+    costs the rendering of the externals of the edited spec, or of all of
+    them when a template changed. With `make` the projects with changed
+    outputs are rebuilt, and `reload_port` then sends `dsp 0` and `dsp 1`
+    to a [netreceive <port>] of a running pd connected to [s pd].
+    """
+    specs, templates = {}, {}
+    while True:
+        found = {s: os.stat(s).st_mtime_ns for s in glob.glob(os.path.join(directory, "*.yml"))}
+        found_templates = {t: os.stat(t).st_mtime_ns
+                           for t in glob.glob(os.path.join(TEMPLATE_DIR, "**", "*.mako"), recursive=True)}
+        changed = [s for s in found if found[s] != specs.get(s)]
+        if found_templates != templates:
+            changed = list(found)
+        specs, templates = found, found_templates
+
+        built = []
+        for spec in sorted(changed):
+            try:
+                for i in range(len(load_spec(spec))):
+                    p = project(spec, target_dir, i)
+                    p.generate()
+                    if p.changed:
+                        built.append(p)
+            except Exception as e:      # a spec being edited: report it and keep watching
+                print(f"{spec}: {type(e).__name__}: {e}")
+        if make and built:
+            for p in built:
+                make_dir = p.project_path / "pd" if isinstance(p, HybridProject) else p.project_path
+                if (make_dir / "Makefile").exists() and \
+                        subprocess.run(["make", "-C", str(make_dir)]).returncode != 0:
+                    built = []
+                    break
+            if reload_port and built:
+                try:
+                    pd_send(reload_port, "dsp 0", "dsp 1")
+                except OSError as e:
+                    print(f"pd on port {reload_port}: {e}")
+        time.sleep(interval)
 
 
 # ----------------------------------------------------------------------------
 # MAIN CLASS
 
 if __name__ == "__main__":
-    p = PdProject("resources/examples/counter.yml")
-    # p = MaxProject("resources/examples/counter.yml")
-    p.generate()
+    parser = argparse.ArgumentParser(description="generate pd and max externals from yaml specs")
+    parser.add_argument("specs", nargs="*", default=["resources/examples/counter.yml"],
+                        help="spec files, each with one or more externals")
+    parser.add_argument("-t", "--target", choices=PROJECTS, default="pd",
+                        help="kind of project to generate (pd)")
+    parser.add_argument("-o", "--output", default=OUTPUT_DIR,
+                        help=f"directory of the projects ({OUTPUT_DIR})")
+    parser.add_argument("-j", "--jobs", type=int, default=None,
+                        help="number of parallel processes (one per cpu)")
+    parser.add_argument("-l", "--library",
+                        help="build all pd externals into one library of this name")
+    parser.add_argument("-w", "--watch", metavar="DIR",
+                        help="regenerate the specs of DIR whenever they or the templates change")
+    parser.add_argument("-m", "--make", action="store_true",
+                        help="(watch) run make in the projects which changed")
+    parser.add_argument("-r", "--reload", type=int, metavar="PORT",
+                        help="(watch) then restart dsp of the pd listening on PORT")
+    args = parser.parse_args()
+    if args.watch:
+        try:
+            watch(args.watch, PROJECTS[args.target], args.output, args.make, args.reload)
+        except KeyboardInterrupt:
+            pass
+    else:
+        try:
+            if args.library:
+                PdLibrary(args.library, args.specs, args.output).generate()
+            else:
+                generate_all(args.specs, PROJECTS[args.target], args.output, args.jobs)
+        except SpecError as e:
+            parser.exit(1, f"xtgen: {e}\n")